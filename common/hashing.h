@@ -547,7 +547,7 @@ inline constexpr auto HashCode::ExtractIndexAndTag(ssize_t size)
   CARBON_DCHECK(llvm::isPowerOf2_64(size));
   CARBON_DCHECK(1LL << (64 - N) >= size) << "Not enough bits for size and tag!";
   return {static_cast<ssize_t>((value_ >> N) & (size - 1)),
-          static_cast<uint32_t>(value_ & ((1U << (N + 1)) - 1))};
+          static_cast<uint32_t>(value_ & ((1ULL << N) - 1))};
 }
 
 // Building with `-DCARBON_MCA_MARKERS` will enable `llvm-mca` annotations in
@@ -0,0 +1,134 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_COMMON_MAP_H_
+#define CARBON_COMMON_MAP_H_
+
+#include <utility>
+
+#include "common/raw_hashtable.h"
+
+namespace Carbon {
+
+// A hashtable map from `KeyT` to `ValueT`. See `common/raw_hashtable.h` for
+// the design.
+//
+// Up to `SmallSize` entries are stored inline, without allocating. Keys are
+// hashed with `Carbon::HashValue`, and lookups accept any key type that hashes
+// and compares equal to `KeyT`, such as `llvm::StringRef` for `std::string`.
+//
+// Unlike `llvm::DenseMap`, no key values are reserved. Pointers to entries are
+// invalidated by inserting into the map.
+template <typename KeyT, typename ValueT, ssize_t SmallSize = 0>
+class Map {
+ public:
+  // The result of inserting into a map.
+  class InsertResult {
+   public:
+    // Whether the key was newly inserted, rather than already present.
+    auto is_inserted() const -> bool { return is_inserted_; }
+
+    auto key() const -> const KeyT& { return *key_; }
+    auto value() const -> ValueT& { return *value_; }
+
+   private:
+    friend class Map;
+
+    InsertResult(bool is_inserted, const KeyT& key, ValueT& value)
+        : is_inserted_(is_inserted), key_(&key), value_(&value) {}
+
+    bool is_inserted_;
+    const KeyT* key_;
+    ValueT* value_;
+  };
+
+  auto size() const -> ssize_t { return table_.size(); }
+  auto empty() const -> bool { return size() == 0; }
+
+  template <typename LookupKeyT>
+  auto Contains(const LookupKeyT& lookup_key) const -> bool {
+    return table_.Find(lookup_key) >= 0;
+  }
+
+  // Returns the value for `lookup_key`, or null if it isn't present.
+  template <typename LookupKeyT>
+  auto Lookup(const LookupKeyT& lookup_key) -> ValueT* {
+    ssize_t slot = table_.Find(lookup_key);
+    return slot >= 0 ? &table_.entry(slot).value : nullptr;
+  }
+  template <typename LookupKeyT>
+  auto Lookup(const LookupKeyT& lookup_key) const -> const ValueT* {
+    ssize_t slot = table_.Find(lookup_key);
+    return slot >= 0 ? &table_.entry(slot).value : nullptr;
+  }
+
+  // Inserts `value` for `lookup_key` if the key isn't present. The key is only
+  // converted to `KeyT` when it's inserted. Returns the entry for the key.
+  template <typename LookupKeyT>
+  auto Insert(const LookupKeyT& lookup_key, ValueT value) -> InsertResult {
+    auto [slot, is_inserted] = table_.FindOrClaim(lookup_key);
+    if (is_inserted) {
+      new (&table_.entry(slot)) Entry{KeyT(lookup_key), std::move(value)};
+    }
+    auto& entry = table_.entry(slot);
+    return InsertResult(is_inserted, entry.key, entry.value);
+  }
+
+  // Sets the value for `lookup_key`, inserting the key if it isn't present.
+  // Returns the entry for the key.
+  template <typename LookupKeyT>
+  auto Update(const LookupKeyT& lookup_key, ValueT value) -> InsertResult {
+    auto [slot, is_inserted] = table_.FindOrClaim(lookup_key);
+    if (is_inserted) {
+      new (&table_.entry(slot)) Entry{KeyT(lookup_key), std::move(value)};
+    } else {
+      table_.entry(slot).value = std::move(value);
+    }
+    auto& entry = table_.entry(slot);
+    return InsertResult(is_inserted, entry.key, entry.value);
+  }
+
+  // Removes `lookup_key`. Returns whether it was present.
+  template <typename LookupKeyT>
+  auto Erase(const LookupKeyT& lookup_key) -> bool {
+    ssize_t slot = table_.Find(lookup_key);
+    if (slot < 0) {
+      return false;
+    }
+    table_.Erase(slot);
+    return true;
+  }
+
+  // Removes all entries, keeping the allocated storage.
+  auto Clear() -> void { table_.Clear(); }
+
+  // Allocates room for `count` entries, so that they can be inserted without
+  // growing.
+  auto Reserve(ssize_t count) -> void { table_.Reserve(count); }
+
+  // Calls `callback(key, value)` for each entry, in an unspecified order. The
+  // map must not be modified during the walk, other than by assigning values.
+  template <typename CallbackT>
+  auto ForEach(CallbackT callback) -> void {
+    table_.ForEachEntry(
+        [&](Entry& entry) { callback(std::as_const(entry.key), entry.value); });
+  }
+  template <typename CallbackT>
+  auto ForEach(CallbackT callback) const -> void {
+    table_.ForEachEntry(
+        [&](const Entry& entry) { callback(entry.key, entry.value); });
+  }
+
+ private:
+  struct Entry {
+    KeyT key;
+    ValueT value;
+  };
+
+  RawHashtable::Table<Entry, SmallSize> table_;
+};
+
+}  // namespace Carbon
+
+#endif  // CARBON_COMMON_MAP_H_
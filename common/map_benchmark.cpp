@@ -0,0 +1,157 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/random/random.h"
+#include "common/check.h"
+#include "common/map.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace Carbon {
+namespace {
+
+// Returns `count` distinct random keys.
+template <typename KeyT>
+auto GetKeys(ssize_t count) -> std::vector<KeyT>;
+
+template <>
+auto GetKeys<int64_t>(ssize_t count) -> std::vector<int64_t> {
+  absl::BitGen gen;
+  llvm::DenseSet<int64_t> seen;
+  std::vector<int64_t> keys;
+  keys.reserve(count);
+  while (static_cast<ssize_t>(keys.size()) < count) {
+    // Stay clear of the values that `llvm::DenseMap` reserves.
+    int64_t key = absl::Uniform<int64_t>(gen, 0, INT64_MAX / 2);
+    if (seen.insert(key).second) {
+      keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+template <>
+auto GetKeys<llvm::StringRef>(ssize_t count) -> std::vector<llvm::StringRef> {
+  // Identifier-like strings, with storage that outlives the benchmark.
+  static std::vector<std::string>* storage = new std::vector<std::string>;
+  std::vector<llvm::StringRef> keys;
+  for (int64_t key : GetKeys<int64_t>(count)) {
+    storage->push_back("key_" + std::to_string(key));
+  }
+  for (const auto& key : llvm::ArrayRef(*storage).take_back(count)) {
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+// Adapters giving each map implementation the same interface.
+template <typename KeyT>
+struct CarbonMapAdapter {
+  auto Insert(KeyT key) -> void { map.Insert(key, 1); }
+  auto Contains(KeyT key) const -> bool { return map.Contains(key); }
+
+  Map<KeyT, int> map;
+};
+
+template <typename KeyT>
+struct DenseMapAdapter {
+  auto Insert(KeyT key) -> void { map.insert({key, 1}); }
+  auto Contains(KeyT key) const -> bool { return map.find(key) != map.end(); }
+
+  llvm::DenseMap<KeyT, int> map;
+};
+
+template <typename KeyT>
+struct AbseilMapAdapter {
+  // Abseil doesn't know how to hash `llvm::StringRef`, so use the equivalent
+  // `std::string_view`.
+  using StoredKeyT =
+      std::conditional_t<std::is_same_v<KeyT, llvm::StringRef>,
+                         std::string_view, KeyT>;
+
+  auto Insert(KeyT key) -> void { map.insert({StoredKeyT(key), 1}); }
+  auto Contains(KeyT key) const -> bool {
+    return map.find(StoredKeyT(key)) != map.end();
+  }
+
+  absl::flat_hash_map<StoredKeyT, int> map;
+};
+
+// Inserts `state.range(0)` keys into an empty map.
+template <typename MapT, typename KeyT>
+void BM_MapInsert(benchmark::State& state) {
+  ssize_t count = state.range(0);
+  std::vector<KeyT> keys = GetKeys<KeyT>(count);
+  for (auto _ : state) {
+    MapT map;
+    for (const auto& key : keys) {
+      map.Insert(key);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Looks up keys in a map of `state.range(0)` keys. All lookups hit if `Hit` is
+// true, and all miss otherwise.
+template <typename MapT, typename KeyT, bool Hit>
+void BM_MapLookup(benchmark::State& state) {
+  ssize_t count = state.range(0);
+  std::vector<KeyT> keys = GetKeys<KeyT>(count * 2);
+  MapT map;
+  for (const auto& key : llvm::ArrayRef(keys).take_front(count)) {
+    map.Insert(key);
+  }
+  llvm::ArrayRef<KeyT> lookup_keys = Hit
+                                         ? llvm::ArrayRef(keys).take_front(count)
+                                         : llvm::ArrayRef(keys).take_back(count);
+
+  // Look up each key once per batch, so that the keys are visited in a
+  // cache-unfriendly order for large maps.
+  while (state.KeepRunningBatch(count)) {
+    for (const auto& key : lookup_keys) {
+      bool found = map.Contains(key);
+      CARBON_DCHECK(found == Hit);
+      benchmark::DoNotOptimize(found);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+#define MAP_BENCHMARKS(KeyT)                                             \
+  BENCHMARK(BM_MapInsert<CarbonMapAdapter<KeyT>, KeyT>)                 \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapInsert<DenseMapAdapter<KeyT>, KeyT>)                  \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapInsert<AbseilMapAdapter<KeyT>, KeyT>)                 \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<CarbonMapAdapter<KeyT>, KeyT, /*Hit=*/true>)   \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<DenseMapAdapter<KeyT>, KeyT, /*Hit=*/true>)    \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<AbseilMapAdapter<KeyT>, KeyT, /*Hit=*/true>)   \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<CarbonMapAdapter<KeyT>, KeyT, /*Hit=*/false>)  \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<DenseMapAdapter<KeyT>, KeyT, /*Hit=*/false>)   \
+      ->Range(1 << 4, 1 << 16);                                          \
+  BENCHMARK(BM_MapLookup<AbseilMapAdapter<KeyT>, KeyT, /*Hit=*/false>)  \
+      ->Range(1 << 4, 1 << 16)
+
+MAP_BENCHMARKS(int64_t);
+MAP_BENCHMARKS(llvm::StringRef);
+
+}  // namespace
+}  // namespace Carbon
@@ -0,0 +1,168 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "common/map.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace Carbon {
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::Pointee;
+using ::testing::UnorderedElementsAreArray;
+
+// Returns the entries of a map, for matching in any order.
+template <typename MapT, typename KeyT, typename ValueT>
+auto GetEntries(const MapT& map) -> std::vector<std::pair<KeyT, ValueT>> {
+  std::vector<std::pair<KeyT, ValueT>> entries;
+  map.ForEach([&](const KeyT& key, const ValueT& value) {
+    entries.push_back({key, value});
+  });
+  return entries;
+}
+
+template <typename MapT>
+class TypedMapTest : public ::testing::Test {};
+
+using MapTypes = ::testing::Types<Map<int, int>, Map<int, int, 16>,
+                                  Map<int, int, 128>>;
+TYPED_TEST_SUITE(TypedMapTest, MapTypes);
+
+TYPED_TEST(TypedMapTest, Basic) {
+  TypeParam map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.Contains(1));
+  EXPECT_THAT(map.Lookup(1), IsNull());
+
+  auto result = map.Insert(1, 100);
+  EXPECT_TRUE(result.is_inserted());
+  EXPECT_THAT(result.key(), Eq(1));
+  EXPECT_THAT(result.value(), Eq(100));
+  EXPECT_TRUE(map.Contains(1));
+  EXPECT_THAT(map.Lookup(1), Pointee(100));
+  EXPECT_THAT(map.size(), Eq(1));
+
+  // Inserting an existing key keeps the existing value.
+  result = map.Insert(1, 101);
+  EXPECT_FALSE(result.is_inserted());
+  EXPECT_THAT(result.value(), Eq(100));
+
+  // Updating an existing key replaces the value.
+  result = map.Update(1, 102);
+  EXPECT_FALSE(result.is_inserted());
+  EXPECT_THAT(map.Lookup(1), Pointee(102));
+
+  result = map.Update(2, 200);
+  EXPECT_TRUE(result.is_inserted());
+  EXPECT_THAT(map.Lookup(2), Pointee(200));
+  EXPECT_THAT(map.size(), Eq(2));
+
+  EXPECT_TRUE(map.Erase(1));
+  EXPECT_FALSE(map.Erase(1));
+  EXPECT_FALSE(map.Contains(1));
+  EXPECT_THAT(map.Lookup(2), Pointee(200));
+  EXPECT_THAT(map.size(), Eq(1));
+
+  map.Clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.Contains(2));
+}
+
+TYPED_TEST(TypedMapTest, Growth) {
+  TypeParam map;
+  std::vector<std::pair<int, int>> expected;
+  for (int i : llvm::seq(1000)) {
+    ASSERT_TRUE(map.Insert(i, i * 100).is_inserted()) << i;
+    expected.push_back({i, i * 100});
+  }
+  EXPECT_THAT(map.size(), Eq(1000));
+  for (int i : llvm::seq(1000)) {
+    EXPECT_THAT(map.Lookup(i), Pointee(i * 100)) << i;
+  }
+  EXPECT_FALSE(map.Contains(1000));
+  EXPECT_THAT((GetEntries<TypeParam, int, int>(map)),
+              UnorderedElementsAreArray(expected));
+}
+
+TYPED_TEST(TypedMapTest, EraseAndReinsert) {
+  TypeParam map;
+  // Repeatedly erasing and inserting fills the table with tombstones, which
+  // must be reclaimed without losing entries.
+  for (int i : llvm::seq(10000)) {
+    ASSERT_TRUE(map.Insert(i, i).is_inserted()) << i;
+    if (i >= 10) {
+      ASSERT_TRUE(map.Erase(i - 10)) << i;
+    }
+  }
+  EXPECT_THAT(map.size(), Eq(10));
+  for (int i : llvm::seq(9990, 10000)) {
+    EXPECT_THAT(map.Lookup(i), Pointee(i)) << i;
+  }
+  EXPECT_FALSE(map.Contains(9989));
+}
+
+TYPED_TEST(TypedMapTest, CopyAndMove) {
+  TypeParam map;
+  for (int i : llvm::seq(100)) {
+    map.Insert(i, i + 1);
+  }
+
+  TypeParam copy = map;
+  EXPECT_THAT(copy.size(), Eq(100));
+  copy.Update(0, -1);
+  EXPECT_THAT(map.Lookup(0), Pointee(1));
+  EXPECT_THAT(copy.Lookup(0), Pointee(-1));
+
+  TypeParam moved = std::move(copy);
+  EXPECT_THAT(moved.size(), Eq(100));
+  EXPECT_THAT(moved.Lookup(0), Pointee(-1));
+  EXPECT_THAT(moved.Lookup(99), Pointee(100));
+
+  TypeParam small;
+  small.Insert(1, 1);
+  moved = std::move(small);
+  EXPECT_THAT(moved.size(), Eq(1));
+  EXPECT_THAT(moved.Lookup(1), Pointee(1));
+  EXPECT_FALSE(moved.Contains(99));
+}
+
+TEST(MapTest, StringKeys) {
+  Map<std::string, int> map;
+  // Look up and insert with `llvm::StringRef`, which is only converted to a
+  // `std::string` when it's inserted.
+  EXPECT_TRUE(map.Insert(llvm::StringRef("abc"), 1).is_inserted());
+  EXPECT_TRUE(map.Insert(std::string("def"), 2).is_inserted());
+  EXPECT_FALSE(map.Insert(llvm::StringRef("def"), 3).is_inserted());
+  EXPECT_THAT(map.Lookup(llvm::StringRef("abc")), Pointee(1));
+  EXPECT_THAT(map.Lookup(std::string("def")), Pointee(2));
+  EXPECT_FALSE(map.Contains(llvm::StringRef("ghi")));
+  EXPECT_TRUE(map.Erase(llvm::StringRef("abc")));
+  EXPECT_THAT(map.size(), Eq(1));
+}
+
+TEST(MapTest, MoveOnlyValues) {
+  Map<int, std::unique_ptr<int>, 4> map;
+  for (int i : llvm::seq(100)) {
+    map.Insert(i, std::make_unique<int>(i));
+  }
+  for (int i : llvm::seq(100)) {
+    auto* value = map.Lookup(i);
+    ASSERT_TRUE(value != nullptr) << i;
+    EXPECT_THAT(**value, Eq(i));
+  }
+}
+
+}  // namespace
+}  // namespace Carbon
@@ -0,0 +1,549 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_COMMON_RAW_HASHTABLE_H_
+#define CARBON_COMMON_RAW_HASHTABLE_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "common/check.h"
+#include "common/hashing.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemAlloc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// The implementation shared by `Carbon::Map` and `Carbon::Set`.
+//
+// These are open-addressing hashtables in the style of [SwissTable][1]:
+//
+// - Each slot has a metadata byte, which is either `Empty`, `Deleted`, or a
+//   7-bit tag taken from the hash code of the slot's key.
+// - Lookups load a group of metadata bytes at once and match all of them
+//   against the tag with SIMD instructions where available, so that almost
+//   all keys that don't match are skipped without being compared.
+// - Groups are visited in a triangular probe sequence. Because the number of
+//   groups is a power of two, this visits every group exactly once.
+//
+// Hashing uses `Carbon::HashValue`, so a lookup key of a different type may be
+// used if it hashes and compares equal to the stored key, for example looking
+// up an `llvm::StringRef` in a table of `std::string`s.
+//
+// [1]: https://abseil.io/about/design/swisstables
+namespace Carbon::RawHashtable {
+
+// Metadata byte values for slots without an entry. Slots with an entry hold a
+// 7-bit tag, so have the high bit clear.
+inline constexpr uint8_t Empty = 0b1000'0000;
+inline constexpr uint8_t Deleted = 0b1111'1110;
+
+// The number of bits of the hash code stored in the metadata byte.
+inline constexpr int TagBits = 7;
+
+// The indices of the bytes in a group that matched some query, formed from a
+// mask with one set bit per matched byte, `1 << Shift` bits apart.
+template <typename BitsT, int Shift>
+class MatchRange {
+ public:
+  class Iterator {
+   public:
+    explicit Iterator(BitsT bits) : bits_(bits) {}
+
+    auto operator*() const -> ssize_t {
+      return std::countr_zero(bits_) >> Shift;
+    }
+
+    auto operator++() -> Iterator& {
+      // Clear the lowest set bit.
+      bits_ &= bits_ - 1;
+      return *this;
+    }
+
+    friend auto operator==(Iterator lhs, Iterator rhs) -> bool {
+      return lhs.bits_ == rhs.bits_;
+    }
+
+   private:
+    BitsT bits_;
+  };
+
+  explicit MatchRange(BitsT bits) : bits_(bits) {}
+
+  auto empty() const -> bool { return bits_ == 0; }
+
+  // Returns the first matched index. The range must not be empty.
+  auto First() const -> ssize_t { return *begin(); }
+
+  auto begin() const -> Iterator { return Iterator(bits_); }
+  auto end() const -> Iterator { return Iterator(0); }
+
+ private:
+  BitsT bits_;
+};
+
+// A group of metadata bytes that are matched together.
+#if defined(__SSE2__)
+
+class MetadataGroup {
+ public:
+  static constexpr ssize_t Size = 16;
+
+  using Match = MatchRange<uint32_t, 0>;
+
+  static auto Load(const uint8_t* metadata, ssize_t index) -> MetadataGroup {
+    return MetadataGroup(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(metadata + index)));
+  }
+
+  auto MatchTag(uint8_t tag) const -> Match {
+    return ToMatch(
+        _mm_cmpeq_epi8(bytes_, _mm_set1_epi8(static_cast<char>(tag))));
+  }
+
+  auto MatchEmpty() const -> Match { return MatchTag(Empty); }
+
+  // Both `Empty` and `Deleted` have the high bit set.
+  auto MatchEmptyOrDeleted() const -> Match { return ToMatch(bytes_); }
+
+  auto MatchPresent() const -> Match {
+    return Match(~static_cast<uint32_t>(_mm_movemask_epi8(bytes_)) & 0xFFFF);
+  }
+
+ private:
+  explicit MetadataGroup(__m128i bytes) : bytes_(bytes) {}
+
+  static auto ToMatch(__m128i mask) -> Match {
+    return Match(static_cast<uint32_t>(_mm_movemask_epi8(mask)));
+  }
+
+  __m128i bytes_;
+};
+
+#elif defined(__ARM_NEON)
+
+class MetadataGroup {
+ public:
+  static constexpr ssize_t Size = 8;
+
+  using Match = MatchRange<uint64_t, 3>;
+
+  static auto Load(const uint8_t* metadata, ssize_t index) -> MetadataGroup {
+    return MetadataGroup(vld1_u8(metadata + index));
+  }
+
+  auto MatchTag(uint8_t tag) const -> Match {
+    return ToMatch(vceq_u8(bytes_, vdup_n_u8(tag)));
+  }
+
+  auto MatchEmpty() const -> Match { return MatchTag(Empty); }
+
+  // Both `Empty` and `Deleted` have the high bit set.
+  auto MatchEmptyOrDeleted() const -> Match {
+    return ToMatch(vcltz_s8(vreinterpret_s8_u8(bytes_)));
+  }
+
+  auto MatchPresent() const -> Match {
+    return ToMatch(vcgez_s8(vreinterpret_s8_u8(bytes_)));
+  }
+
+ private:
+  explicit MetadataGroup(uint8x8_t bytes) : bytes_(bytes) {}
+
+  // Converts a byte mask to a match of the high bit of each byte.
+  static auto ToMatch(uint8x8_t mask) -> Match {
+    return Match(vget_lane_u64(vreinterpret_u64_u8(mask), 0) &
+                 0x8080'8080'8080'8080);
+  }
+
+  uint8x8_t bytes_;
+};
+
+#else
+
+// A portable implementation that matches the bytes of a `uint64_t` with
+// bitwise operations.
+class MetadataGroup {
+ public:
+  static constexpr ssize_t Size = 8;
+
+  using Match = MatchRange<uint64_t, 3>;
+
+  static auto Load(const uint8_t* metadata, ssize_t index) -> MetadataGroup {
+    return MetadataGroup(llvm::support::endian::read64le(metadata + index));
+  }
+
+  // This may have false positives in bytes above a true match, which are
+  // always present slots. Callers compare keys, so these only cost time.
+  auto MatchTag(uint8_t tag) const -> Match {
+    uint64_t zeroed = bytes_ ^ (LSBs * tag);
+    return Match((zeroed - LSBs) & ~zeroed & MSBs);
+  }
+
+  // Of the bytes with the high bit set, only `Empty` has bit 1 clear.
+  auto MatchEmpty() const -> Match {
+    return Match(bytes_ & ~(bytes_ << 6) & MSBs);
+  }
+
+  auto MatchEmptyOrDeleted() const -> Match { return Match(bytes_ & MSBs); }
+
+  auto MatchPresent() const -> Match { return Match(~bytes_ & MSBs); }
+
+ private:
+  static constexpr uint64_t LSBs = 0x0101'0101'0101'0101;
+  static constexpr uint64_t MSBs = 0x8080'8080'8080'8080;
+
+  explicit MetadataGroup(uint64_t bytes) : bytes_(bytes) {}
+
+  uint64_t bytes_;
+};
+
+#endif
+
+// Returns the number of slots that a table of `size` slots can fill before it
+// needs to grow. Keeping one slot in eight free bounds the length of probe
+// sequences.
+constexpr auto GetGrowthBudget(ssize_t size) -> ssize_t {
+  return size - size / 8;
+}
+
+// Returns the smallest valid table size with room for `count` entries.
+constexpr auto GetSizeForCount(ssize_t count) -> ssize_t {
+  ssize_t size = MetadataGroup::Size;
+  while (GetGrowthBudget(size) < count) {
+    size *= 2;
+  }
+  return size;
+}
+
+// The slots stored inline in a table, so that small tables don't allocate.
+template <typename EntryT, ssize_t Size>
+struct SmallStorage {
+  uint8_t metadata[Size];
+  alignas(EntryT) std::byte entries[Size * sizeof(EntryT)];
+};
+
+template <typename EntryT>
+struct SmallStorage<EntryT, 0> {};
+
+// A hashtable of `EntryT`s, which have a `key` member. The `SmallSize` is the
+// number of entries that can be stored without allocating.
+//
+// This manages slots and entry lifetimes. Lookup keys are matched against
+// `entry.key` with `==`. Entries for newly claimed slots are constructed by
+// the caller.
+template <typename EntryT, ssize_t SmallSize>
+class Table {
+ public:
+  Table() { Init(); }
+
+  Table(const Table& other) : Table() {
+    Reserve(other.num_entries_);
+    other.ForEachEntry([&](const EntryT& entry) {
+      new (&entries_[ClaimSlot(HashValue(entry.key))]) EntryT(entry);
+    });
+  }
+
+  Table(Table&& other) noexcept : Table() { MoveFrom(other); }
+
+  auto operator=(const Table& other) -> Table& {
+    if (this != &other) {
+      *this = Table(other);
+    }
+    return *this;
+  }
+
+  auto operator=(Table&& other) noexcept -> Table& {
+    if (this != &other) {
+      Destroy();
+      Init();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  ~Table() { Destroy(); }
+
+  auto size() const -> ssize_t { return num_entries_; }
+
+  // Returns the entry in a slot returned by `Find` or `FindOrClaim`.
+  auto entry(ssize_t slot) -> EntryT& { return entries_[slot]; }
+  auto entry(ssize_t slot) const -> const EntryT& { return entries_[slot]; }
+
+  // Returns the slot holding `lookup_key`, or -1 if it isn't present.
+  template <typename LookupKeyT>
+  auto Find(const LookupKeyT& lookup_key) const -> ssize_t {
+    if (num_entries_ == 0) {
+      return -1;
+    }
+    return Find(HashValue(lookup_key), lookup_key);
+  }
+
+  // Returns the slot holding `lookup_key`, and false. If it isn't present,
+  // claims a slot for it and returns that slot and true. The caller must
+  // construct the entry in a claimed slot before any other operation on the
+  // table.
+  template <typename LookupKeyT>
+  auto FindOrClaim(const LookupKeyT& lookup_key) -> std::pair<ssize_t, bool> {
+    HashCode hash = HashValue(lookup_key);
+    if (num_entries_ > 0) {
+      if (ssize_t slot = Find(hash, lookup_key); slot >= 0) {
+        return {slot, false};
+      }
+    }
+    return {ClaimSlot(hash), true};
+  }
+
+  // Destroys the entry in a slot.
+  auto Erase(ssize_t slot) -> void {
+    entries_[slot].~EntryT();
+    // Leave a tombstone so that probe sequences passing through this slot
+    // continue. It's replaced when the slot is claimed or the table rehashed.
+    metadata_[slot] = Deleted;
+    --num_entries_;
+  }
+
+  // Destroys all entries, keeping the table's storage.
+  auto Clear() -> void {
+    ForEachEntry([](EntryT& entry) { entry.~EntryT(); });
+    if (size_ > 0) {
+      std::memset(metadata_, Empty, size_);
+    }
+    num_entries_ = 0;
+    growth_budget_ = GetGrowthBudget(size_);
+  }
+
+  // Grows the table, if needed, so that `count` entries fit without growing.
+  auto Reserve(ssize_t count) -> void {
+    if (count == 0) {
+      return;
+    }
+    ssize_t new_size = GetSizeForCount(count);
+    if (new_size > size_) {
+      Rehash(new_size);
+    }
+  }
+
+  // Calls `callback(entry)` for each entry, in an unspecified order. Entries
+  // must not be added or removed during the walk.
+  template <typename CallbackT>
+  auto ForEachEntry(CallbackT callback) -> void {
+    for (ssize_t group_index = 0; group_index < size_;
+         group_index += MetadataGroup::Size) {
+      for (ssize_t offset :
+           MetadataGroup::Load(metadata_, group_index).MatchPresent()) {
+        callback(entries_[group_index + offset]);
+      }
+    }
+  }
+  template <typename CallbackT>
+  auto ForEachEntry(CallbackT callback) const -> void {
+    const_cast<Table*>(this)->ForEachEntry(
+        [&](const EntryT& entry) { callback(entry); });
+  }
+
+ private:
+  static constexpr ssize_t SmallCapacity =
+      SmallSize == 0 ? 0 : GetSizeForCount(SmallSize);
+
+  // Computes the probe sequence of group indices for a hash index.
+  class ProbeSequence {
+   public:
+    ProbeSequence(ssize_t hash_index, ssize_t size)
+        : mask_(size - 1), index_(hash_index & ~(MetadataGroup::Size - 1)) {}
+
+    auto index() const -> ssize_t { return index_; }
+
+    auto Next() -> void {
+      step_ += MetadataGroup::Size;
+      index_ = (index_ + step_) & mask_;
+    }
+
+   private:
+    ssize_t mask_;
+    ssize_t index_;
+    ssize_t step_ = 0;
+  };
+
+  auto is_small() const -> bool {
+    if constexpr (SmallCapacity > 0) {
+      return metadata_ == small_.metadata;
+    } else {
+      return false;
+    }
+  }
+
+  // Sets up the initial, empty storage.
+  auto Init() -> void {
+    if constexpr (SmallCapacity > 0) {
+      metadata_ = small_.metadata;
+      entries_ = reinterpret_cast<EntryT*>(small_.entries);
+      size_ = SmallCapacity;
+      std::memset(metadata_, Empty, size_);
+    } else {
+      metadata_ = nullptr;
+      entries_ = nullptr;
+      size_ = 0;
+    }
+    num_entries_ = 0;
+    growth_budget_ = GetGrowthBudget(size_);
+  }
+
+  // Destroys all entries and frees any allocated storage.
+  auto Destroy() -> void {
+    ForEachEntry([](EntryT& entry) { entry.~EntryT(); });
+    if (!is_small() && metadata_) {
+      llvm::deallocate_buffer(metadata_, GetAllocSize(size_), alignof(EntryT));
+    }
+  }
+
+  // Moves the entries of `other` into this table, which must be empty, and
+  // leaves `other` empty.
+  auto MoveFrom(Table& other) -> void {
+    if (other.is_small() || !other.metadata_) {
+      // Inline entries can't be stolen, so move them individually.
+      other.ForEachEntry([&](EntryT& entry) {
+        new (&entries_[ClaimSlot(HashValue(entry.key))])
+            EntryT(std::move(entry));
+      });
+      other.Clear();
+      return;
+    }
+
+    if (!is_small() && metadata_) {
+      llvm::deallocate_buffer(metadata_, GetAllocSize(size_), alignof(EntryT));
+    }
+    metadata_ = other.metadata_;
+    entries_ = other.entries_;
+    size_ = other.size_;
+    num_entries_ = other.num_entries_;
+    growth_budget_ = other.growth_budget_;
+    other.Init();
+  }
+
+  // Returns the bytes allocated for a table of `size` slots, which are the
+  // metadata followed by the entries.
+  static auto GetEntriesOffset(ssize_t size) -> ssize_t {
+    return (size + alignof(EntryT) - 1) & ~(alignof(EntryT) - 1);
+  }
+  static auto GetAllocSize(ssize_t size) -> ssize_t {
+    return GetEntriesOffset(size) + size * sizeof(EntryT);
+  }
+
+  template <typename LookupKeyT>
+  auto Find(HashCode hash, const LookupKeyT& lookup_key) const -> ssize_t {
+    auto [hash_index, tag] = hash.ExtractIndexAndTag<TagBits>(size_);
+    for (ProbeSequence probe(hash_index, size_);; probe.Next()) {
+      auto group = MetadataGroup::Load(metadata_, probe.index());
+      for (ssize_t offset : group.MatchTag(tag)) {
+        ssize_t slot = probe.index() + offset;
+        if (entries_[slot].key == lookup_key) {
+          return slot;
+        }
+      }
+      // Keys are placed in the first group with a free slot, so an empty slot
+      // ends the probe sequence.
+      if (!group.MatchEmpty().empty()) {
+        return -1;
+      }
+    }
+  }
+
+  // Claims a free slot for a key with the given hash, which must not be
+  // present, growing the table if needed.
+  auto ClaimSlot(HashCode hash) -> ssize_t {
+    if (growth_budget_ == 0) {
+      Grow();
+    }
+    auto [hash_index, tag] = hash.ExtractIndexAndTag<TagBits>(size_);
+    for (ProbeSequence probe(hash_index, size_);; probe.Next()) {
+      auto free =
+          MetadataGroup::Load(metadata_, probe.index()).MatchEmptyOrDeleted();
+      if (!free.empty()) {
+        ssize_t slot = probe.index() + free.First();
+        if (metadata_[slot] == Empty) {
+          --growth_budget_;
+        }
+        metadata_[slot] = tag;
+        ++num_entries_;
+        return slot;
+      }
+    }
+  }
+
+  // Makes room for at least one more entry.
+  auto Grow() -> void {
+    // If most of the used budget is tombstones, rehashing at the same size
+    // frees enough room. Inline storage can't be rehashed into itself, so
+    // always moves to a larger allocation.
+    ssize_t new_size = std::max(size_, MetadataGroup::Size);
+    if (is_small() || num_entries_ >= GetGrowthBudget(size_) / 2) {
+      new_size = std::max(size_ * 2, MetadataGroup::Size);
+    }
+    Rehash(new_size);
+  }
+
+  // Moves all entries into a new allocation of `new_size` slots.
+  auto Rehash(ssize_t new_size) -> void {
+    CARBON_DCHECK(std::has_single_bit(static_cast<size_t>(new_size)) &&
+                  new_size >= MetadataGroup::Size)
+        << "Invalid table size " << new_size;
+    uint8_t* old_metadata = metadata_;
+    EntryT* old_entries = entries_;
+    ssize_t old_size = size_;
+    bool old_is_small = is_small();
+
+    metadata_ = static_cast<uint8_t*>(
+        llvm::allocate_buffer(GetAllocSize(new_size), alignof(EntryT)));
+    entries_ =
+        reinterpret_cast<EntryT*>(metadata_ + GetEntriesOffset(new_size));
+    size_ = new_size;
+    std::memset(metadata_, Empty, size_);
+    num_entries_ = 0;
+    growth_budget_ = GetGrowthBudget(size_);
+
+    for (ssize_t group_index = 0; group_index < old_size;
+         group_index += MetadataGroup::Size) {
+      for (ssize_t offset :
+           MetadataGroup::Load(old_metadata, group_index).MatchPresent()) {
+        EntryT& entry = old_entries[group_index + offset];
+        new (&entries_[ClaimSlot(HashValue(entry.key))])
+            EntryT(std::move(entry));
+        entry.~EntryT();
+      }
+    }
+
+    if (!old_is_small && old_metadata) {
+      llvm::deallocate_buffer(old_metadata, GetAllocSize(old_size),
+                              alignof(EntryT));
+    }
+  }
+
+  // The metadata and entries of the table's `size_` slots. These point into
+  // `small_` when the table is small, and are null when a table without inline
+  // storage hasn't allocated.
+  uint8_t* metadata_;
+  EntryT* entries_;
+  ssize_t size_;
+
+  ssize_t num_entries_;
+
+  // The number of empty slots that can be claimed before the table grows.
+  ssize_t growth_budget_;
+
+  [[no_unique_address]] SmallStorage<EntryT, SmallCapacity> small_;
+};
+
+}  // namespace Carbon::RawHashtable
+
+#endif  // CARBON_COMMON_RAW_HASHTABLE_H_
@@ -0,0 +1,102 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_COMMON_SET_H_
+#define CARBON_COMMON_SET_H_
+
+#include "common/raw_hashtable.h"
+
+namespace Carbon {
+
+// A hashtable set of `KeyT`s. See `common/raw_hashtable.h` for the design.
+//
+// Up to `SmallSize` keys are stored inline, without allocating. Keys are
+// hashed with `Carbon::HashValue`, and lookups accept any key type that hashes
+// and compares equal to `KeyT`, such as `llvm::StringRef` for `std::string`.
+//
+// Pointers to keys are invalidated by inserting into the set.
+template <typename KeyT, ssize_t SmallSize = 0>
+class Set {
+ public:
+  // The result of inserting into a set.
+  class InsertResult {
+   public:
+    // Whether the key was newly inserted, rather than already present.
+    auto is_inserted() const -> bool { return is_inserted_; }
+
+    auto key() const -> const KeyT& { return *key_; }
+
+   private:
+    friend class Set;
+
+    InsertResult(bool is_inserted, const KeyT& key)
+        : is_inserted_(is_inserted), key_(&key) {}
+
+    bool is_inserted_;
+    const KeyT* key_;
+  };
+
+  auto size() const -> ssize_t { return table_.size(); }
+  auto empty() const -> bool { return size() == 0; }
+
+  template <typename LookupKeyT>
+  auto Contains(const LookupKeyT& lookup_key) const -> bool {
+    return table_.Find(lookup_key) >= 0;
+  }
+
+  // Returns the stored key equal to `lookup_key`, or null if it isn't present.
+  // This allows a set to be used to intern keys.
+  template <typename LookupKeyT>
+  auto Lookup(const LookupKeyT& lookup_key) const -> const KeyT* {
+    ssize_t slot = table_.Find(lookup_key);
+    return slot >= 0 ? &table_.entry(slot).key : nullptr;
+  }
+
+  // Inserts `lookup_key` if it isn't present. The key is only converted to
+  // `KeyT` when it's inserted. Returns the stored key.
+  template <typename LookupKeyT>
+  auto Insert(const LookupKeyT& lookup_key) -> InsertResult {
+    auto [slot, is_inserted] = table_.FindOrClaim(lookup_key);
+    if (is_inserted) {
+      new (&table_.entry(slot)) Entry{KeyT(lookup_key)};
+    }
+    return InsertResult(is_inserted, table_.entry(slot).key);
+  }
+
+  // Removes `lookup_key`. Returns whether it was present.
+  template <typename LookupKeyT>
+  auto Erase(const LookupKeyT& lookup_key) -> bool {
+    ssize_t slot = table_.Find(lookup_key);
+    if (slot < 0) {
+      return false;
+    }
+    table_.Erase(slot);
+    return true;
+  }
+
+  // Removes all keys, keeping the allocated storage.
+  auto Clear() -> void { table_.Clear(); }
+
+  // Allocates room for `count` keys, so that they can be inserted without
+  // growing.
+  auto Reserve(ssize_t count) -> void { table_.Reserve(count); }
+
+  // Calls `callback(key)` for each key, in an unspecified order. The set must
+  // not be modified during the walk.
+  template <typename CallbackT>
+  auto ForEach(CallbackT callback) const -> void {
+    table_.ForEachEntry([&](const Entry& entry) { callback(entry.key); });
+  }
+
+ private:
+  struct Entry {
+    KeyT key;
+  };
+
+  RawHashtable::Table<Entry, SmallSize> table_;
+};
+
+}  // namespace Carbon
+
+#endif  // CARBON_COMMON_SET_H_
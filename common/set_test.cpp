@@ -0,0 +1,80 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "common/set.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace Carbon {
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::Pointee;
+using ::testing::UnorderedElementsAreArray;
+
+template <typename SetT>
+class TypedSetTest : public ::testing::Test {};
+
+using SetTypes = ::testing::Types<Set<int>, Set<int, 16>, Set<int, 128>>;
+TYPED_TEST_SUITE(TypedSetTest, SetTypes);
+
+TYPED_TEST(TypedSetTest, Basic) {
+  TypeParam set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.Contains(1));
+
+  EXPECT_TRUE(set.Insert(1).is_inserted());
+  EXPECT_FALSE(set.Insert(1).is_inserted());
+  EXPECT_TRUE(set.Contains(1));
+  EXPECT_THAT(set.Lookup(1), Pointee(1));
+  EXPECT_THAT(set.Lookup(2), IsNull());
+  EXPECT_THAT(set.size(), Eq(1));
+
+  EXPECT_TRUE(set.Erase(1));
+  EXPECT_FALSE(set.Erase(1));
+  EXPECT_TRUE(set.empty());
+}
+
+TYPED_TEST(TypedSetTest, Growth) {
+  TypeParam set;
+  std::vector<int> expected;
+  for (int i : llvm::seq(1000)) {
+    ASSERT_TRUE(set.Insert(i * 7).is_inserted()) << i;
+    expected.push_back(i * 7);
+  }
+  EXPECT_THAT(set.size(), Eq(1000));
+  for (int i : llvm::seq(1000)) {
+    EXPECT_TRUE(set.Contains(i * 7)) << i;
+    EXPECT_FALSE(set.Contains(i * 7 + 1)) << i;
+  }
+
+  std::vector<int> keys;
+  set.ForEach([&](int key) { keys.push_back(key); });
+  EXPECT_THAT(keys, UnorderedElementsAreArray(expected));
+
+  set.Clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.Contains(0));
+}
+
+TEST(SetTest, InternStrings) {
+  Set<std::string> set;
+  const std::string& abc = set.Insert(llvm::StringRef("abc")).key();
+  EXPECT_THAT(abc, Eq("abc"));
+  // Looking up an equal key finds the stored string.
+  EXPECT_THAT(set.Lookup(llvm::StringRef("abc")), Eq(&abc));
+  EXPECT_THAT(&set.Insert(std::string("abc")).key(), Eq(&abc));
+  EXPECT_THAT(set.Lookup(llvm::StringRef("abd")), IsNull());
+}
+
+}  // namespace
+}  // namespace Carbon
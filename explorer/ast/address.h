@@ -24,10 +24,10 @@ class AllocationId : public Printable<AllocationId> {
   auto operator=(const AllocationId&) -> AllocationId& = default;
 
   inline friend auto operator==(AllocationId lhs, AllocationId rhs) -> bool {
-    return lhs.index_ == rhs.index_;
+    return lhs.index_ == rhs.index_ && lhs.generation_ == rhs.generation_;
   }
   inline friend auto hash_value(AllocationId id) {
-    return llvm::hash_combine(id.index_);
+    return llvm::hash_combine(id.index_, id.generation_);
   }
 
   // Prints a human-readable representation of *this to `out`.
@@ -43,9 +43,12 @@ class AllocationId : public Printable<AllocationId> {
   // details of Heap.
   friend class Heap;
 
-  explicit AllocationId(size_t index) : index_(index) {}
+  explicit AllocationId(size_t index, uint32_t generation)
+      : index_(index), generation_(generation) {}
 
   size_t index_;
+  // Distinguishes allocations that reuse the same heap slot.
+  uint32_t generation_;
 };
 
 // An Address represents a memory address in the Carbon virtual machine.
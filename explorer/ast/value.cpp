@@ -438,6 +438,146 @@ auto Value::SetField(Nonnull<Arena*> arena, const ElementPath& path,
                       field_value, source_loc);
 }
 
+// Returns `value` if it's owned, and otherwise an owned copy of it.
+template <typename T>
+static auto MakeOwned(Nonnull<Arena*> arena, const T& value,
+                      llvm::DenseSet<const Value*>& owned) -> Nonnull<T*> {
+  if (owned.contains(&value)) {
+    // Owned values are allocated as non-const by NewUncanonicalized below.
+    return const_cast<T*>(&value);
+  }
+  Nonnull<T*> copy = arena->NewUncanonicalized<T>(value.elements().vec());
+  owned.insert(copy);
+  return copy;
+}
+
+// Returns `object` if it's owned, and otherwise an owned copy of it. The bases
+// are copied along with the object, so that the copies share a
+// class_value_ptr, and are owned whenever the object is.
+template <>
+auto MakeOwned(Nonnull<Arena*> arena, const NominalClassValue& object,
+               llvm::DenseSet<const Value*>& owned)
+    -> Nonnull<NominalClassValue*> {
+  if (owned.contains(&object)) {
+    return const_cast<NominalClassValue*>(&object);
+  }
+  auto* class_value_ptr = arena->New<const NominalClassValue*>();
+  std::vector<const NominalClassValue*> base_path;
+  for (auto base = object.base(); base; base = (*base)->base()) {
+    base_path.push_back(*base);
+  }
+  std::optional<Nonnull<const NominalClassValue*>> base;
+  for (auto* base_path_elem : llvm::reverse(base_path)) {
+    Nonnull<NominalClassValue*> base_copy =
+        arena->NewUncanonicalized<NominalClassValue>(
+            &base_path_elem->type(), &base_path_elem->inits(), base,
+            class_value_ptr);
+    owned.insert(base_copy);
+    base = base_copy;
+  }
+  Nonnull<NominalClassValue*> copy =
+      arena->NewUncanonicalized<NominalClassValue>(
+          &object.type(), &object.inits(), base, class_value_ptr);
+  owned.insert(copy);
+  return copy;
+}
+
+// Updates bottom-up: each aggregate is only modified once the update of its
+// element has succeeded, so a failed update leaves owned values unchanged.
+static auto SetFieldInPlaceImpl(
+    Nonnull<Arena*> arena, Nonnull<const Value*> value,
+    std::vector<ElementPath::Component>::const_iterator path_begin,
+    std::vector<ElementPath::Component>::const_iterator path_end,
+    Nonnull<const Value*> field_value, llvm::DenseSet<const Value*>& owned,
+    SourceLocation source_loc) -> ErrorOr<Nonnull<const Value*>> {
+  if (path_begin == path_end) {
+    return field_value;
+  }
+  switch (value->kind()) {
+    case Value::Kind::StructValue: {
+      const auto& struct_value = cast<StructValue>(*value);
+      llvm::ArrayRef<NamedValue> elements = struct_value.elements();
+      const auto* it =
+          llvm::find_if(elements, [path_begin](const NamedValue& element) {
+            return (*path_begin).IsNamed(element.name);
+          });
+      if (it == elements.end()) {
+        return ProgramError(source_loc)
+               << "field " << *path_begin << " not in " << *value;
+      }
+      CARBON_ASSIGN_OR_RETURN(
+          Nonnull<const Value*> element,
+          SetFieldInPlaceImpl(arena, it->value, path_begin + 1, path_end,
+                              field_value, owned, source_loc));
+      Nonnull<StructValue*> result = MakeOwned(arena, struct_value, owned);
+      result->set_element_value(it - elements.begin(), element);
+      return result;
+    }
+    case Value::Kind::NominalClassValue: {
+      const auto& object = cast<NominalClassValue>(*value);
+      if (auto inits = SetFieldInPlaceImpl(arena, &object.inits(), path_begin,
+                                           path_end, field_value, owned,
+                                           source_loc);
+          inits.ok()) {
+        Nonnull<NominalClassValue*> result = MakeOwned(arena, object, owned);
+        result->set_inits(*inits);
+        return result;
+      } else if (object.base().has_value()) {
+        // The bases of an owned object are owned, so this updates the base in
+        // place.
+        Nonnull<NominalClassValue*> result = MakeOwned(arena, object, owned);
+        auto new_base =
+            SetFieldInPlaceImpl(arena, *result->base(), path_begin, path_end,
+                                field_value, owned, source_loc);
+        if (new_base.ok()) {
+          CARBON_CHECK(*new_base == *result->base())
+              << "owned base was replaced";
+          return result;
+        }
+      }
+      // Failed to match, show full object content
+      return ProgramError(source_loc)
+             << "field " << *path_begin << " not in " << *value;
+    }
+    case Value::Kind::TupleType:
+    case Value::Kind::TupleValue: {
+      CARBON_CHECK((*path_begin).element()->kind() ==
+                   ElementKind::PositionalElement)
+          << "Invalid non-positional member for tuple";
+      const auto& tuple = cast<TupleValueBase>(*value);
+      const size_t index =
+          cast<PositionalElement>((*path_begin).element())->index();
+      if (index < 0 || index >= tuple.elements().size()) {
+        return ProgramError(source_loc)
+               << "index " << index << " out of range in " << *value;
+      }
+      CARBON_ASSIGN_OR_RETURN(
+          Nonnull<const Value*> element,
+          SetFieldInPlaceImpl(arena, tuple.elements()[index], path_begin + 1,
+                              path_end, field_value, owned, source_loc));
+      Nonnull<TupleValueBase*> result =
+          isa<TupleType>(tuple)
+              ? static_cast<Nonnull<TupleValueBase*>>(
+                    MakeOwned(arena, cast<TupleType>(tuple), owned))
+              : MakeOwned(arena, cast<TupleValue>(tuple), owned);
+      result->set_element(index, element);
+      return result;
+    }
+    default:
+      CARBON_FATAL() << "field access not allowed for value " << *value;
+  }
+}
+
+auto Value::SetFieldInPlace(Nonnull<Arena*> arena, const ElementPath& path,
+                            Nonnull<const Value*> field_value,
+                            llvm::DenseSet<const Value*>& owned,
+                            SourceLocation source_loc) const
+    -> ErrorOr<Nonnull<const Value*>> {
+  return SetFieldInPlaceImpl(arena, static_cast<Nonnull<const Value*>>(this),
+                             path.components_.begin(), path.components_.end(),
+                             field_value, owned, source_loc);
+}
+
 static auto PrintNameWithBindings(llvm::raw_ostream& out,
                                   Nonnull<const Declaration*> declaration,
                                   const BindingMap& args) {
@@ -19,6 +19,7 @@
 #include "explorer/ast/expression_category.h"
 #include "explorer/ast/statement.h"
 #include "explorer/base/nonnull.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Compiler.h"
 
@@ -98,6 +99,19 @@ class Value : public Printable<Value> {
                 SourceLocation source_loc) const
       -> ErrorOr<Nonnull<const Value*>>;
 
+  // Like SetField, but the aggregates along `path` that are in `owned` are
+  // updated in place instead of being copied. Aggregates that aren't owned are
+  // copied without canonicalization and added to `owned`, so later updates
+  // along the same path don't allocate.
+  //
+  // Values are otherwise immutable, so the caller must ensure that nothing
+  // else can observe the aggregates in `owned`.
+  auto SetFieldInPlace(Nonnull<Arena*> arena, const ElementPath& path,
+                       Nonnull<const Value*> field_value,
+                       llvm::DenseSet<const Value*>& owned,
+                       SourceLocation source_loc) const
+      -> ErrorOr<Nonnull<const Value*>>;
+
   // Returns the enumerator corresponding to the most-derived type of this
   // object.
   auto kind() const -> Kind { return kind_; }
@@ -397,6 +411,12 @@ class StructValue : public Value {
 
   auto elements() const -> llvm::ArrayRef<NamedValue> { return elements_; }
 
+  // Replaces the value of the element at `index`. Only for use on an owned
+  // value; see SetFieldInPlace.
+  void set_element_value(size_t index, Nonnull<const Value*> value) {
+    elements_[index].value = value;
+  }
+
   // Returns the value of the field named `name` in this struct, or
   // nullopt if there is no such field.
   auto FindField(std::string_view name) const
@@ -432,6 +452,8 @@ class NominalClassValue : public Value {
 
   auto type() const -> const Value& { return *type_; }
   auto inits() const -> const Value& { return *inits_; }
+  // Only for use on an owned value; see SetFieldInPlace.
+  void set_inits(Nonnull<const Value*> inits) { inits_ = inits; }
   auto base() const -> std::optional<Nonnull<const NominalClassValue*>> {
     return base_;
   }
@@ -522,6 +544,12 @@ class TupleValueBase : public Value {
     return elements_;
   }
 
+  // Replaces the element at `index`. Only for use on an owned value; see
+  // SetFieldInPlace.
+  void set_element(size_t index, Nonnull<const Value*> element) {
+    elements_[index] = element;
+  }
+
   static auto classof(const Value* value) -> bool {
     return value->kind() == Kind::TupleValue ||
            value->kind() == Kind::TupleType;
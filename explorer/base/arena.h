@@ -5,16 +5,19 @@
 #ifndef CARBON_EXPLORER_BASE_ARENA_H_
 #define CARBON_EXPLORER_BASE_ARENA_H_
 
-#include <any>
-#include <map>
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <new>
+#include <optional>
+#include <tuple>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "explorer/base/nonnull.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Allocator.h"
 
 namespace Carbon {
 
@@ -25,6 +28,11 @@ namespace Carbon {
 // and have a hash_value overload as defined in llvm/ADT/Hashing.h. This
 // should only be customized in cases where we cannot modify T itself to
 // satisfy those requirements.
+//
+// If converting a T to a key is expensive, a specialization can also provide
+// `static auto Hash(const T&) -> llvm::hash_code` and
+// `static auto Equals(const type&, const T&) -> bool`, which are used to look
+// up a T without converting it. Otherwise every lookup converts the T.
 template <typename T, typename = void>
 struct ArgKey {
   using type = T;
@@ -36,6 +44,9 @@ using ArgKeyType = typename ArgKey<T>::type;
 // Allocates and maintains ownership of arbitrary objects, so that their
 // lifetimes all end at the same time. It can also canonicalize the allocated
 // objects (see the documentation of New).
+//
+// Objects are bump-allocated from slabs, and are destroyed in reverse order of
+// allocation when the arena is destroyed.
 class Arena {
   // CanonicalizeAllocation<T>::value is true if canonicalization is enabled
   // for T, and false otherwise.
@@ -43,6 +54,11 @@ class Arena {
   struct CanonicalizeAllocation;
 
  public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  auto operator=(const Arena&) -> Arena& = delete;
+  ~Arena();
+
   // Values of this type can be passed as the first argument to New in order to
   // have the address of the created object written to the given pointer before
   // the constructor is run. This is used during cloning to support pointer
@@ -88,6 +104,16 @@ class Arena {
                                 CanonicalizeAllocation<T>::value>* = nullptr>
   auto New(Args&&... args) -> Nonnull<const T*>;
 
+  // Returns a pointer to an object constructed as if by `T(args...)`, owned
+  // by this Arena. Unlike New, this never canonicalizes, so the object can be
+  // mutated by whoever allocated it, provided that no one else can observe it.
+  template <
+      typename T, typename... Args,
+      typename std::enable_if_t<std::is_constructible_v<T, Args...>>* = nullptr>
+  auto NewUncanonicalized(Args&&... args) -> Nonnull<T*> {
+    return UniqueNew<T>(std::forward<Args>(args)...);
+  }
+
   // Allocates an object in the arena, writing its address to the given pointer.
   template <
       typename T, typename U, typename... Args,
@@ -97,62 +123,78 @@ class Arena {
   auto allocated() -> int64_t { return allocated_; }
 
  private:
-  // Virtualizes arena entries so that a single vector can contain many types,
-  // avoiding templated statics.
-  class ArenaEntry {
-   public:
-    virtual ~ArenaEntry() = default;
+  // An object that must be destroyed with the arena. Objects of trivially
+  // destructible types aren't recorded.
+  struct Destructor {
+    // Destroys `object`, which was allocated as the type it was registered
+    // with.
+    void (*destroy)(void* object);
+    void* object;
   };
 
-  // Templated destruction of a pointer.
+  // Type-erased destruction of a T.
   template <typename T>
-  class ArenaEntryTyped;
+  static void Destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
 
-  // Hash functor implemented in terms of hash_value (see llvm/ADT/Hashing.h).
-  struct LlvmHasher {
-    template <typename T>
-    auto operator()(const T& t) const -> size_t {
-      using llvm::hash_value;
-      return hash_value(t);
-    }
-  };
+  // HasLookupByArg<T>::value is true if ArgKey<T> can hash and compare a T
+  // without converting it to a key.
+  template <typename T, typename = void>
+  struct HasLookupByArg;
 
-  // Factory metafunction for globally unique type IDs.
-  // &TypeId<T>::id == &TypeId<U>::id if and only if std::is_same_v<T,U>.
-  //
-  // Inspired by llvm::Any::TypeId.
-  template <typename T>
-  struct TypeId {
-    // This is only used for an address to compare; the value is unimportant.
-    static char id;
+  // Type-erased base of CanonicalizationTable, so that a single vector can
+  // own tables of many types.
+  class CanonicalizationTableBase {
+   public:
+    virtual ~CanonicalizationTableBase() = default;
   };
 
   // A canonicalization table maps a tuple of constructor argument values to
-  // a non-null pointer to a T object constructed with those arguments.
+  // a pointer to a T object constructed with those arguments.
   template <typename T, typename... Args>
-  using CanonicalizationTable =
-      std::unordered_map<std::tuple<ArgKeyType<Args>...>, Nonnull<const T*>,
-                         LlvmHasher>;
+  class CanonicalizationTable;
 
   // Allocates an object in the arena. Unlike New, this will always allocate
   // and construct a new object.
   template <typename T, typename... Args>
   auto UniqueNew(Args&&... args) -> Nonnull<T*>;
 
-  // Returns a pointer to the canonical instance of T constructed from
-  // `args...`, or null if there is no such instance yet. Returns a mutable
-  // reference so that a null entry can be updated.
+  // Allocates uninitialized storage for a T. The caller must construct the
+  // object and then call RegisterDestructor.
+  template <typename T>
+  auto Allocate() -> Nonnull<T*>;
+
+  // Records that `object` must be destroyed with the arena.
+  template <typename T>
+  void RegisterDestructor(Nonnull<T*> object);
+
+  // Returns this arena's canonicalization table for T objects constructed
+  // from Args, creating it if needed.
   template <typename T, typename... Args>
-  auto CanonicalInstance(const Args&... args) -> const T*&;
+  auto GetCanonicalizationTable() -> CanonicalizationTable<T, Args...>&;
+
+  // Returns the index of the canonicalization table of type TableT in
+  // canonical_tables_. Indexes are assigned on first use, and are the same for
+  // all arenas.
+  template <typename TableT>
+  static auto CanonicalizationTableIndex() -> int {
+    static const int index = next_canonicalization_table_index_++;
+    return index;
+  }
 
-  // Manages allocations in an arena for destruction at shutdown.
-  std::vector<std::unique_ptr<ArenaEntry>> arena_;
+  static inline std::atomic<int> next_canonicalization_table_index_ = 0;
+
+  // The slabs holding allocated objects.
+  llvm::BumpPtrAllocator allocator_;
+  // Objects to destroy at shutdown, in order of allocation.
+  std::vector<Destructor> destructors_;
   int64_t allocated_ = 0;
 
-  // Maps a CanonicalizationTable type to a unique instance of that type for
-  // this arena. For a key equal to &TypeId<T>::id for some T, the corresponding
-  // value contains a T*.
-  std::map<char*, std::any> canonical_tables_;
+  // This arena's canonicalization tables, indexed by
+  // CanonicalizationTableIndex. Entries are null for tables that haven't been
+  // used by this arena.
+  std::vector<std::unique_ptr<CanonicalizationTableBase>> canonical_tables_;
 };
 
 // ---------------------------------------
@@ -178,15 +220,22 @@ struct ArgKey<std::vector<T>> {
     friend auto operator==(const VectorProxy& lhs, const VectorProxy& rhs) {
       return lhs.vec_ == rhs.vec_;
     }
-    friend auto hash_value(const VectorProxy& v) {
-      return llvm::hash_combine(
-          llvm::hash_combine_range(v.vec_.begin(), v.vec_.end()),
-          v.vec_.size());
-    }
+    friend auto hash_value(const VectorProxy& v) { return Hash(v.vec_); }
 
    private:
+    friend struct ArgKey;
+
     std::vector<T> vec_;
   };
+
+  // Look up vectors without copying them into a VectorProxy.
+  static auto Hash(const std::vector<T>& vec) -> llvm::hash_code {
+    return llvm::hash_combine(llvm::hash_combine_range(vec.begin(), vec.end()),
+                              vec.size());
+  }
+  static auto Equals(const type& key, const std::vector<T>& vec) -> bool {
+    return key.vec_ == vec;
+  }
 };
 
 template <typename T, typename... Args,
@@ -200,11 +249,15 @@ template <typename T, typename... Args,
           typename std::enable_if_t<std::is_constructible_v<T, Args...> &&
                                     Arena::CanonicalizeAllocation<T>::value>*>
 auto Arena::New(Args&&... args) -> Nonnull<const T*> {
-  const T*& canonical_instance = CanonicalInstance<T>(args...);
-  if (canonical_instance == nullptr) {
-    canonical_instance = UniqueNew<T>(std::forward<Args>(args)...);
+  auto& table = GetCanonicalizationTable<T, std::remove_cvref_t<Args>...>();
+  auto [index, inserted] = table.FindOrInsert(args...);
+  if (inserted) {
+    // The key is copied from `args` before they're forwarded. Refer to the
+    // entry by index, because constructing T can add entries to the table.
+    Nonnull<const T*> instance = UniqueNew<T>(std::forward<Args>(args)...);
+    table.instance(index) = instance;
   }
-  return canonical_instance;
+  return table.instance(index);
 }
 
 template <typename T, typename U, typename... Args,
@@ -212,21 +265,39 @@ template <typename T, typename U, typename... Args,
 void Arena::New(WriteAddressTo<U> addr, Args&&... args) {
   static_assert(!CanonicalizeAllocation<T>::value,
                 "This form of New does not support canonicalization yet");
-  arena_.push_back(
-      std::make_unique<ArenaEntryTyped<T>>(addr, std::forward<Args>(args)...));
-  allocated_ += sizeof(T);
+  Nonnull<T*> ptr = Allocate<T>();
+  *addr.target = ptr;
+  new (ptr) T(std::forward<Args>(args)...);
+  RegisterDestructor(ptr);
 }
 
 template <typename T, typename... Args>
 auto Arena::UniqueNew(Args&&... args) -> Nonnull<T*> {
-  auto smart_ptr =
-      std::make_unique<ArenaEntryTyped<T>>(std::forward<Args>(args)...);
-  Nonnull<T*> ptr = smart_ptr->Instance();
-  arena_.push_back(std::move(smart_ptr));
-  allocated_ += sizeof(T);
+  Nonnull<T*> ptr = Allocate<T>();
+  new (ptr) T(std::forward<Args>(args)...);
+  RegisterDestructor(ptr);
   return ptr;
 }
 
+template <typename T>
+auto Arena::Allocate() -> Nonnull<T*> {
+  allocated_ += sizeof(T);
+  return static_cast<T*>(allocator_.Allocate(sizeof(T), alignof(T)));
+}
+
+template <typename T>
+void Arena::RegisterDestructor(Nonnull<T*> object) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    destructors_.push_back({.destroy = &Destroy<T>, .object = object});
+  }
+}
+
+inline Arena::~Arena() {
+  for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+    it->destroy(it->object);
+  }
+}
+
 template <typename T, typename>
 struct Arena::CanonicalizeAllocation : public std::false_type {};
 
@@ -235,45 +306,124 @@ struct Arena::CanonicalizeAllocation<
     T, std::void_t<typename T::EnableCanonicalizedAllocation>>
     : public std::true_type {};
 
-template <typename T, typename... Args>
-auto Arena::CanonicalInstance(const Args&... args) -> const T*& {
-  using MapType = CanonicalizationTable<T, Args...>;
-  std::any& wrapped_table = canonical_tables_[&TypeId<MapType>::id];
-  if (!wrapped_table.has_value()) {
-    wrapped_table.emplace<MapType>();
-  }
-  MapType& table = std::any_cast<MapType&>(wrapped_table);
-  return table[typename MapType::key_type(args...)];
-}
+template <typename T, typename>
+struct Arena::HasLookupByArg : public std::false_type {};
 
-// Templated destruction of a pointer.
 template <typename T>
-class Arena::ArenaEntryTyped : public ArenaEntry {
+struct Arena::HasLookupByArg<
+    T, std::void_t<decltype(ArgKey<T>::Hash(std::declval<const T&>())),
+                   decltype(ArgKey<T>::Equals(
+                       std::declval<const ArgKeyType<T>&>(),
+                       std::declval<const T&>()))>> : public std::true_type {};
+
+// An open-addressing hash table from constructor arguments to canonical
+// instances. Entries are stored densely in insertion order, and the buckets
+// hold indexes into them, so growing the table only moves the indexes.
+// Arguments are hashed and compared in place, and are only converted to keys
+// when inserting.
+template <typename T, typename... Args>
+class Arena::CanonicalizationTable : public CanonicalizationTableBase {
  public:
-  struct WriteAddressHelper {};
+  // Finds the entry for `args...`, inserting one with a null instance if
+  // there isn't one. Returns the index of the entry and whether it was
+  // inserted.
+  auto FindOrInsert(const Args&... args) -> std::pair<int, bool> {
+    if ((entries_.size() + 1) * 4 > buckets_.size() * 3) {
+      Grow();
+    }
+    size_t hash = llvm::hash_combine(HashArg(args)...);
+    size_t mask = buckets_.size() - 1;
+    // Triangular probing visits every bucket of a power-of-two table.
+    for (size_t i = hash & mask, step = 1;; i = (i + step++) & mask) {
+      int& bucket = buckets_[i];
+      if (bucket < 0) {
+        bucket = entries_.size();
+        entries_.push_back({.key = Key(args...), .hash = hash});
+        return {bucket, true};
+      }
+      const Entry& entry = entries_[bucket];
+      if (entry.hash == hash && KeyEquals(entry.key, args...)) {
+        return {bucket, false};
+      }
+    }
+  }
 
-  template <typename... Args>
-  explicit ArenaEntryTyped(Args&&... args)
-      : instance_(std::forward<Args>(args)...) {}
+  // Returns the canonical instance for the entry at `index`, which is null
+  // until it's set by the caller of FindOrInsert.
+  auto instance(int index) -> const T*& { return entries_[index].instance; }
 
-  template <typename... Args>
-  explicit ArenaEntryTyped(WriteAddressHelper, Args&&... args)
-      : ArenaEntryTyped(std::forward<Args>(args)...) {}
+ private:
+  using Key = std::tuple<ArgKeyType<Args>...>;
 
-  template <typename U, typename... Args>
-  explicit ArenaEntryTyped(WriteAddressTo<U> write_address, Args&&... args)
-      : ArenaEntryTyped(
-            (*write_address.target = &instance_, WriteAddressHelper{}),
-            std::forward<Args>(args)...) {}
+  struct Entry {
+    Key key;
+    size_t hash;
+    const T* instance = nullptr;
+  };
 
-  auto Instance() -> Nonnull<T*> { return Nonnull<T*>(&instance_); }
+  template <typename A>
+  static auto HashArg(const A& arg) -> llvm::hash_code {
+    if constexpr (HasLookupByArg<A>::value) {
+      return ArgKey<A>::Hash(arg);
+    } else if constexpr (std::is_same_v<ArgKeyType<A>, A>) {
+      using llvm::hash_value;
+      return hash_value(arg);
+    } else {
+      using llvm::hash_value;
+      return hash_value(ArgKeyType<A>(arg));
+    }
+  }
 
- private:
-  T instance_;
+  template <typename A>
+  static auto ArgEquals(const ArgKeyType<A>& key, const A& arg) -> bool {
+    if constexpr (HasLookupByArg<A>::value) {
+      return ArgKey<A>::Equals(key, arg);
+    } else if constexpr (std::is_same_v<ArgKeyType<A>, A>) {
+      return key == arg;
+    } else {
+      return key == ArgKeyType<A>(arg);
+    }
+  }
+
+  static auto KeyEquals(const Key& key, const Args&... args) -> bool {
+    return std::apply(
+        [&](const auto&... keys) {
+          return (ArgEquals<Args>(keys, args) && ...);
+        },
+        key);
+  }
+
+  // Doubles the number of buckets, reinserting entries by their stored hash.
+  void Grow() {
+    buckets_.assign(std::max<size_t>(16, buckets_.size() * 2), -1);
+    size_t mask = buckets_.size() - 1;
+    for (int index = 0; index < static_cast<int>(entries_.size()); ++index) {
+      size_t i = entries_[index].hash & mask;
+      for (size_t step = 1; buckets_[i] >= 0; i = (i + step++) & mask) {
+      }
+      buckets_[i] = index;
+    }
+  }
+
+  // Indexes into entries_, or -1 for an empty bucket. The size is zero or a
+  // power of two.
+  std::vector<int> buckets_;
+  std::vector<Entry> entries_;
 };
 
-template <typename T>
-char Arena::TypeId<T>::id = 1;
+template <typename T, typename... Args>
+auto Arena::GetCanonicalizationTable() -> CanonicalizationTable<T, Args...>& {
+  using TableType = CanonicalizationTable<T, Args...>;
+  size_t index = CanonicalizationTableIndex<TableType>();
+  if (index >= canonical_tables_.size()) {
+    canonical_tables_.resize(index + 1);
+  }
+  auto& table = canonical_tables_[index];
+  if (!table) {
+    table = std::make_unique<TableType>();
+  }
+  return static_cast<TableType&>(*table);
+}
 
 }  // namespace Carbon
 
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -30,6 +31,58 @@ TEST(ArenaTest, BasicAllocation) {
   EXPECT_TRUE(destroyed);
 }
 
+class ReportDestructionOrder {
+ public:
+  explicit ReportDestructionOrder(std::vector<int>* order, int id)
+      : order_(order), id_(id) {}
+
+  ~ReportDestructionOrder() { order_->push_back(id_); }
+
+ private:
+  std::vector<int>* order_;
+  int id_;
+};
+
+TEST(ArenaTest, DestructionOrder) {
+  std::vector<int> order;
+  {
+    Arena arena;
+    for (int i = 0; i < 1000; ++i) {
+      // Interleave trivially destructible objects, which aren't registered
+      // for destruction.
+      (void)arena.New<int>(i);
+      (void)arena.New<ReportDestructionOrder>(&order, i);
+    }
+  }
+  ASSERT_EQ(order.size(), 1000U);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(order[i], 999 - i);
+  }
+}
+
+TEST(ArenaTest, WriteAddressTo) {
+  struct SelfReference {
+    explicit SelfReference(SelfReference** self) : self_address(*self) {}
+    SelfReference* self_address;
+  };
+  Arena arena;
+  SelfReference* self = nullptr;
+  arena.New<SelfReference>(Arena::WriteAddressTo{&self}, &self);
+  ASSERT_TRUE(self != nullptr);
+  EXPECT_EQ(self->self_address, self);
+}
+
+TEST(ArenaTest, Alignment) {
+  struct alignas(64) OverAligned {
+    char c;
+  };
+  Arena arena;
+  (void)arena.New<char>('a');
+  auto* aligned = arena.New<OverAligned>();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0U);
+  EXPECT_EQ(arena.allocated(), 1 + static_cast<int64_t>(sizeof(OverAligned)));
+}
+
 struct CanonicalizedDummy {
   explicit CanonicalizedDummy(int) {}
   explicit CanonicalizedDummy(int*) {}
@@ -46,6 +99,20 @@ TEST(ArenaTest, Canonicalize) {
   EXPECT_TRUE(dummy1 == dummy2);
 }
 
+TEST(ArenaTest, CanonicalizeMany) {
+  Arena arena;
+  std::vector<const CanonicalizedDummy*> dummies;
+  for (int i = 0; i < 1000; ++i) {
+    dummies.push_back(arena.New<CanonicalizedDummy>(i));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(arena.New<CanonicalizedDummy>(i) == dummies[i]) << i;
+  }
+  for (int i = 1; i < 1000; ++i) {
+    EXPECT_TRUE(dummies[i - 1] != dummies[i]) << i;
+  }
+}
+
 TEST(ArenaTest, CanonicalizeArgMismatch) {
   Arena arena;
   auto* dummy1 = arena.New<CanonicalizedDummy>(1);
@@ -91,14 +91,16 @@ auto AnalyzeProgram(Nonnull<Arena*> arena, AST ast,
 
 auto ExecProgram(Nonnull<Arena*> arena, AST ast,
                  Nonnull<TraceStream*> trace_stream,
-                 Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int> {
+                 Nonnull<llvm::raw_ostream*> print_stream,
+                 size_t min_heap_slots_before_reuse) -> ErrorOr<int> {
   SetProgramPhase set_program_phase(*trace_stream, ProgramPhase::Execution);
   if (trace_stream->is_enabled()) {
     trace_stream->Heading("starting execution");
   }
   CARBON_ASSIGN_OR_RETURN(
       auto interpreter_result,
-      InterpProgram(ast, arena, trace_stream, print_stream));
+      InterpProgram(ast, arena, trace_stream, print_stream,
+                    min_heap_slots_before_reuse));
   if (trace_stream->is_enabled()) {
     trace_stream->Result() << "interpreter result: " << interpreter_result
                            << "\n";
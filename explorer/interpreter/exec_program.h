@@ -20,10 +20,12 @@ auto AnalyzeProgram(Nonnull<Arena*> arena, AST ast,
                     Nonnull<TraceStream*> trace_stream,
                     Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<AST>;
 
-// Run the program's `Main` function.
+// Run the program's `Main` function. Dead heap slots are reused once there are
+// `min_heap_slots_before_reuse` of them.
 auto ExecProgram(Nonnull<Arena*> arena, AST ast,
                  Nonnull<TraceStream*> trace_stream,
-                 Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int>;
+                 Nonnull<llvm::raw_ostream*> print_stream,
+                 size_t min_heap_slots_before_reuse) -> ErrorOr<int>;
 
 }  // namespace Carbon
 
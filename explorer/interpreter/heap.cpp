@@ -19,17 +19,30 @@ auto Heap::AllocateValue(Nonnull<const Value*> v) -> AllocationId {
   // ensures that we don't do anything else in between, which would be really
   // bad! Consider whether to include a copy of the input v in this function or
   // to leave it up to the caller.
-  AllocationId a(values_.size());
-  values_.push_back(v);
-  bool is_uninitialized = false;
-
-  if (v->kind() == Carbon::Value::Kind::UninitializedValue) {
-    states_.push_back(ValueState::Uninitialized);
-    is_uninitialized = true;
+  bool is_uninitialized =
+      v->kind() == Carbon::Value::Kind::UninitializedValue;
+  ValueState initial_state =
+      is_uninitialized ? ValueState::Uninitialized : ValueState::Alive;
+
+  size_t index;
+  if (values_.size() >= min_slots_before_reuse_ && !free_slots_.empty()) {
+    // Reuse a dead slot, invalidating any addresses that still refer to it.
+    index = free_slots_.back();
+    free_slots_.pop_back();
+    values_[index] = v;
+    states_[index] = initial_state;
+    bound_values_[index] = llvm::DenseMap<const AstNode*, Address>{};
+    owned_aggregates_[index] = llvm::DenseSet<const Value*>{};
+    ++generations_[index];
   } else {
-    states_.push_back(ValueState::Alive);
+    index = values_.size();
+    values_.push_back(v);
+    states_.push_back(initial_state);
+    bound_values_.push_back(llvm::DenseMap<const AstNode*, Address>{});
+    owned_aggregates_.push_back(llvm::DenseSet<const Value*>{});
+    generations_.push_back(0);
   }
-  bound_values_.push_back(llvm::DenseMap<const AstNode*, Address>{});
+  AllocationId a(index, generations_[index]);
 
   if (trace_stream_->is_enabled()) {
     trace_stream_->Allocate()
@@ -48,6 +61,15 @@ auto Heap::Read(const Address& a, SourceLocation source_loc) const
   ErrorOr<Nonnull<const Value*>> read_value =
       value->GetElement(arena_, a.element_path_, source_loc, value);
 
+  // Once an owned aggregate is visible outside the heap, it can no longer be
+  // updated in place. A bound method refers to the object it's bound to.
+  auto& owned = owned_aggregates_[a.allocation_.index_];
+  if (read_value.ok() && !owned.empty() &&
+      (owned.contains(*read_value) ||
+       llvm::isa<BoundMethodValue>(**read_value))) {
+    owned.clear();
+  }
+
   if (trace_stream_->is_enabled()) {
     trace_stream_->Read() << "memory-read: #" << a.allocation_.index_ << " `"
                           << **read_value << "`\n";
@@ -59,7 +81,7 @@ auto Heap::Read(const Address& a, SourceLocation source_loc) const
 auto Heap::Write(const Address& a, Nonnull<const Value*> v,
                  SourceLocation source_loc) -> ErrorOr<Success> {
   CARBON_RETURN_IF_ERROR(this->CheckAlive(a.allocation_, source_loc));
-  if (states_[a.allocation_.index_] == ValueState::Uninitialized) {
+  if (state(a.allocation_) == ValueState::Uninitialized) {
     if (!a.element_path_.IsEmpty()) {
       return ProgramError(source_loc)
              << "undefined behavior: store to subobject of uninitialized value "
@@ -67,9 +89,14 @@ auto Heap::Write(const Address& a, Nonnull<const Value*> v,
     }
     states_[a.allocation_.index_] = ValueState::Alive;
   }
+  auto& owned = owned_aggregates_[a.allocation_.index_];
+  if (a.element_path_.IsEmpty()) {
+    // The whole value is replaced, so none of the old aggregates remain.
+    owned.clear();
+  }
   CARBON_ASSIGN_OR_RETURN(values_[a.allocation_.index_],
-                          values_[a.allocation_.index_]->SetField(
-                              arena_, a.element_path_, v, source_loc));
+                          values_[a.allocation_.index_]->SetFieldInPlace(
+                              arena_, a.element_path_, v, owned, source_loc));
   auto& bound_values_map = bound_values_[a.allocation_.index_];
   // End lifetime of all values bound to this address and its subobjects.
   if (a.element_path_.IsEmpty()) {
@@ -93,8 +120,14 @@ auto Heap::Write(const Address& a, Nonnull<const Value*> v,
 
 auto Heap::CheckAlive(AllocationId allocation, SourceLocation source_loc) const
     -> ErrorOr<Success> {
-  const auto state = states_[allocation.index_];
-  if (state == ValueState::Dead || state == ValueState::Discarded) {
+  if (is_stale(allocation)) {
+    // The slot now holds a different value, so don't print it.
+    return ProgramError(source_loc)
+           << "undefined behavior: access to dead value " << allocation;
+  }
+  const auto value_state = states_[allocation.index_];
+  if (value_state == ValueState::Dead ||
+      value_state == ValueState::Discarded) {
     return ProgramError(source_loc)
            << "undefined behavior: access to dead or discarded value "
            << *values_[allocation.index_];
@@ -104,7 +137,7 @@ auto Heap::CheckAlive(AllocationId allocation, SourceLocation source_loc) const
 
 auto Heap::CheckInit(AllocationId allocation, SourceLocation source_loc) const
     -> ErrorOr<Success> {
-  if (states_[allocation.index_] == ValueState::Uninitialized) {
+  if (state(allocation) == ValueState::Uninitialized) {
     return ProgramError(source_loc)
            << "undefined behavior: access to uninitialized value "
            << *values_[allocation.index_];
@@ -113,8 +146,12 @@ auto Heap::CheckInit(AllocationId allocation, SourceLocation source_loc) const
 }
 
 auto Heap::Deallocate(AllocationId allocation) -> ErrorOr<Success> {
-  if (states_[allocation.index_] != ValueState::Dead) {
+  if (state(allocation) != ValueState::Dead) {
     states_[allocation.index_] = ValueState::Dead;
+    owned_aggregates_[allocation.index_] = llvm::DenseSet<const Value*>{};
+    free_slots_.push_back(allocation.index_);
+  } else if (is_stale(allocation)) {
+    CARBON_FATAL() << "deallocating an already dead value: " << allocation;
   } else {
     CARBON_FATAL() << "deallocating an already dead value: "
                    << *values_[allocation.index_];
@@ -133,26 +170,29 @@ auto Heap::Deallocate(const Address& a) -> ErrorOr<Success> {
 }
 
 auto Heap::is_initialized(AllocationId allocation) const -> bool {
-  return states_[allocation.index_] != ValueState::Uninitialized;
+  return state(allocation) != ValueState::Uninitialized;
 }
 
 auto Heap::is_discarded(AllocationId allocation) const -> bool {
-  return states_[allocation.index_] == ValueState::Discarded;
+  return state(allocation) == ValueState::Discarded;
 }
 
 void Heap::Discard(AllocationId allocation) {
-  CARBON_CHECK(states_[allocation.index_] == ValueState::Uninitialized);
+  CARBON_CHECK(state(allocation) == ValueState::Uninitialized);
   states_[allocation.index_] = ValueState::Discarded;
 }
 
 void Heap::BindValueToReference(const ValueNodeView& node, const Address& a) {
+  CARBON_CHECK(!is_stale(a.allocation_))
+      << "binding to a dead allocation " << a.allocation_;
   // Update mapped node ignoring any previous mapping.
   bound_values_[a.allocation_.index_].insert({&node.base(), a});
 }
 
 auto Heap::is_bound_value_alive(const ValueNodeView& node,
                                 const Address& a) const -> bool {
-  return bound_values_[a.allocation_.index_].contains(&node.base());
+  return !is_stale(a.allocation_) &&
+         bound_values_[a.allocation_.index_].contains(&node.base());
 }
 
 void Heap::Print(llvm::raw_ostream& out) const {
@@ -15,10 +15,19 @@
 #include "explorer/base/source_location.h"
 #include "explorer/base/trace_stream.h"
 #include "explorer/interpreter/heap_allocation_interface.h"
+#include "llvm/ADT/DenseSet.h"
 
 namespace Carbon {
 
 // A Heap represents the abstract machine's dynamically allocated memory.
+//
+// Each allocation occupies a slot. Once the heap has at least
+// `min_slots_before_reuse` slots, the slots of deallocated values are reused, and each reuse bumps the slot's generation so
+// that stale addresses are still diagnosed as referring to dead values.
+//
+// Writes to an element of an aggregate update the heap's own copy of the
+// aggregate in place, so that they don't copy the whole aggregate. The copy is
+// only shared once a read returns it, after which the next write copies again.
 class Heap : public HeapAllocationInterface, public Printable<Heap> {
  public:
   enum class ValueState {
@@ -28,9 +37,17 @@ class Heap : public HeapAllocationInterface, public Printable<Heap> {
     Dead,
   };
 
+  // Dead allocations are only recycled once the heap has this many slots by
+  // default, so that small programs keep every allocation, and heap dumps show
+  // them all.
+  static constexpr size_t DefaultMinSlotsBeforeReuse = 1 << 16;
+
   // Constructs an empty Heap.
-  explicit Heap(Nonnull<TraceStream*> trace_stream, Nonnull<Arena*> arena)
-      : arena_(arena), trace_stream_(trace_stream){};
+  explicit Heap(Nonnull<TraceStream*> trace_stream, Nonnull<Arena*> arena,
+                size_t min_slots_before_reuse = DefaultMinSlotsBeforeReuse)
+      : arena_(arena),
+        min_slots_before_reuse_(min_slots_before_reuse),
+        trace_stream_(trace_stream){};
 
   Heap(const Heap&) = delete;
   auto operator=(const Heap&) -> Heap& = delete;
@@ -84,6 +101,18 @@ class Heap : public HeapAllocationInterface, public Printable<Heap> {
   static auto PathsAreStrictlyNested(const ElementPath& first,
                                      const ElementPath& second) -> bool;
 
+  // Returns whether the slot of `allocation` has since been reused by a newer
+  // allocation, meaning that `allocation` is dead.
+  auto is_stale(AllocationId allocation) const -> bool {
+    return generations_[allocation.index_] != allocation.generation_;
+  }
+
+  // Returns the state of `allocation`, which is dead if it's stale.
+  auto state(AllocationId allocation) const -> ValueState {
+    return is_stale(allocation) ? ValueState::Dead
+                                : states_[allocation.index_];
+  }
+
   // Signal an error if the allocation is no longer alive.
   auto CheckAlive(AllocationId allocation, SourceLocation source_loc) const
       -> ErrorOr<Success>;
@@ -93,9 +122,19 @@ class Heap : public HeapAllocationInterface, public Printable<Heap> {
       -> ErrorOr<Success>;
 
   Nonnull<Arena*> arena_;
+  // Dead slots are only reused once there are at least this many slots.
+  size_t min_slots_before_reuse_;
   std::vector<Nonnull<const Value*>> values_;
   std::vector<ValueState> states_;
   std::vector<llvm::DenseMap<const AstNode*, Address>> bound_values_;
+  // For each slot, the aggregates in its value that only the heap can observe,
+  // and so can be updated in place. See Value::SetFieldInPlace. Reads clear
+  // this when they expose an aggregate.
+  mutable std::vector<llvm::DenseSet<const Value*>> owned_aggregates_;
+  // The current generation of each slot.
+  std::vector<uint32_t> generations_;
+  // Slots of dead allocations, which can be reused.
+  std::vector<size_t> free_slots_;
   Nonnull<TraceStream*> trace_stream_;
 };
 
@@ -68,12 +68,15 @@ class Interpreter {
  public:
   // Constructs an Interpreter which allocates values on `arena`, and prints
   // traces if `trace` is true. `phase` indicates whether it executes at
-  // compile time or run time.
+  // compile time or run time. Dead heap slots are reused once there are
+  // `min_heap_slots_before_reuse` of them.
   Interpreter(Phase phase, Nonnull<Arena*> arena,
               Nonnull<TraceStream*> trace_stream,
-              Nonnull<llvm::raw_ostream*> print_stream)
+              Nonnull<llvm::raw_ostream*> print_stream,
+              size_t min_heap_slots_before_reuse =
+                  Heap::DefaultMinSlotsBeforeReuse)
       : arena_(arena),
-        heap_(trace_stream, arena),
+        heap_(trace_stream, arena, min_heap_slots_before_reuse),
         todo_(MakeTodo(phase, &heap_, trace_stream)),
         trace_stream_(trace_stream),
         print_stream_(print_stream),
@@ -2595,8 +2598,10 @@ auto Interpreter::RunAllSteps(std::unique_ptr<Action> action)
 
 auto InterpProgram(const AST& ast, Nonnull<Arena*> arena,
                    Nonnull<TraceStream*> trace_stream,
-                   Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int> {
-  Interpreter interpreter(Phase::RunTime, arena, trace_stream, print_stream);
+                   Nonnull<llvm::raw_ostream*> print_stream,
+                   size_t min_heap_slots_before_reuse) -> ErrorOr<int> {
+  Interpreter interpreter(Phase::RunTime, arena, trace_stream, print_stream,
+                          min_heap_slots_before_reuse);
   if (trace_stream->is_enabled()) {
     trace_stream->SubHeading("initializing globals");
   }
@@ -14,10 +14,12 @@
 namespace Carbon {
 
 // Interprets the program defined by `ast`, allocating values on `arena` and
-// printing traces if `trace` is true.
+// printing traces if `trace` is true. Dead heap slots are reused once there are
+// `min_heap_slots_before_reuse` of them.
 auto InterpProgram(const AST& ast, Nonnull<Arena*> arena,
                    Nonnull<TraceStream*> trace_stream,
-                   Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int>;
+                   Nonnull<llvm::raw_ostream*> print_stream,
+                   size_t min_heap_slots_before_reuse) -> ErrorOr<int>;
 
 // Interprets `e` at compile-time, allocating values on `arena` and
 // printing traces if `trace` is true. The caller must ensure that all the
@@ -16,6 +16,7 @@
 
 #include "common/error.h"
 #include "explorer/base/trace_stream.h"
+#include "explorer/interpreter/heap.h"
 #include "explorer/parse_and_execute/parse_and_execute.h"
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SmallString.h"
@@ -122,6 +123,11 @@ auto ExplorerMain(int argc, const char** argv, llvm::StringRef install_path,
   std::string default_prelude_file_str(default_prelude_file);
   cl::opt<std::string> prelude_file_name("prelude", cl::desc("<prelude file>"),
                                          cl::init(default_prelude_file_str));
+  cl::opt<unsigned> min_heap_slots_before_reuse(
+      "min_heap_slots_before_reuse",
+      cl::desc("Reuse the slots of dead heap allocations once the heap has "
+               "this many slots."),
+      cl::init(Heap::DefaultMinSlotsBeforeReuse), cl::Hidden);
 
   cl::ParseCommandLineOptions(argc, argv);
   auto reset_parser =
@@ -177,7 +183,7 @@ auto ExplorerMain(int argc, const char** argv, llvm::StringRef install_path,
 
   ErrorOr<int> result =
       ParseAndExecute(fs, prelude_file_name, input_file_name, parser_debug,
-                      &trace_stream, &out_stream);
+                      &trace_stream, &out_stream, min_heap_slots_before_reuse);
   if (result.ok()) {
     // Print the return code to stdout.
     out_stream << "result: " << *result << "\n";
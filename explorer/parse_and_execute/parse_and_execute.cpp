@@ -39,7 +39,8 @@ static auto PrintTimingOnExit(TraceStream* trace_stream, const char* label,
 auto ParseAndExecute(llvm::vfs::FileSystem& fs, std::string_view prelude_path,
                      std::string_view input_file_name, bool parser_debug,
                      Nonnull<TraceStream*> trace_stream,
-                     Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int> {
+                     Nonnull<llvm::raw_ostream*> print_stream,
+                     size_t min_heap_slots_before_reuse) -> ErrorOr<int> {
   return RunWithExtraStack([&]() -> ErrorOr<int> {
     Arena arena;
     auto cursor = std::chrono::steady_clock::now();
@@ -67,7 +68,8 @@ auto ParseAndExecute(llvm::vfs::FileSystem& fs, std::string_view prelude_path,
 
     // Run the program.
     ErrorOr<int> exec_result =
-        ExecProgram(&arena, *analyze_result, trace_stream, print_stream);
+        ExecProgram(&arena, *analyze_result, trace_stream, print_stream,
+                    min_heap_slots_before_reuse);
     auto print_exec_time =
         PrintTimingOnExit(trace_stream, "ExecProgram", &cursor);
 
@@ -7,15 +7,20 @@
 
 #include "common/error.h"
 #include "explorer/base/trace_stream.h"
+#include "explorer/interpreter/heap.h"
 #include "llvm/Support/VirtualFileSystem.h"
 
 namespace Carbon {
 
 // Parses and executes the input file, returning the program result on success.
+// Dead heap slots are reused once there are `min_heap_slots_before_reuse` of
+// them.
 auto ParseAndExecute(llvm::vfs::FileSystem& fs, std::string_view prelude_path,
                      std::string_view input_file_name, bool parser_debug,
                      Nonnull<TraceStream*> trace_stream,
-                     Nonnull<llvm::raw_ostream*> print_stream) -> ErrorOr<int>;
+                     Nonnull<llvm::raw_ostream*> print_stream,
+                     size_t min_heap_slots_before_reuse =
+                         Heap::DefaultMinSlotsBeforeReuse) -> ErrorOr<int>;
 
 }  // namespace Carbon
 
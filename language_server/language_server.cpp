@@ -14,9 +14,79 @@
 
 namespace Carbon::LS {
 
+// The most versions of a file to keep before lexing and parsing it from
+// scratch, which frees the earlier versions that later ones refer into.
+static constexpr int MaxFileVersions = 20;
+
+auto LanguageServer::File::Update(llvm::StringRef filename,
+                                  llvm::StringRef text) -> void {
+  // Copy the text so that it outlives the request, because the tokens of
+  // later versions can refer into it.
+  auto source =
+      SourceBuffer::CreateFromText(text, filename, NullDiagnosticConsumer());
+  if (!source) {
+    // The text can't be lexed, so drop the versions that no longer match it.
+    versions.clear();
+    value_stores.reset();
+    num_versions = 0;
+    return;
+  }
+
+  if (versions.empty() || num_versions >= MaxFileVersions) {
+    versions.clear();
+    value_stores = std::make_unique<SharedValueStores>();
+    Version& version = versions.emplace_front();
+    num_versions = 1;
+    version.source = std::move(source);
+    version.tokens =
+        Lex::Lex(*value_stores, *version.source, NullDiagnosticConsumer());
+    version.parse_tree = Parse::Tree::Parse(
+        *version.tokens, NullDiagnosticConsumer(), /*vlog_stream=*/nullptr);
+    return;
+  }
+
+  // The client sends the full text, so the edit is what's between the text
+  // shared with the current version at the start and the end.
+  Version& old_version = versions.front();
+  llvm::StringRef old_text = old_version.source->text();
+  size_t prefix = 0;
+  size_t max_length = std::min(old_text.size(), text.size());
+  while (prefix < max_length && old_text[prefix] == text[prefix]) {
+    ++prefix;
+  }
+  size_t suffix = 0;
+  while (suffix < max_length - prefix &&
+         old_text[old_text.size() - suffix - 1] ==
+             text[text.size() - suffix - 1]) {
+    ++suffix;
+  }
+  Lex::SourceEdit edit = {
+      .offset = static_cast<int64_t>(prefix),
+      .removed_length = static_cast<int64_t>(old_text.size() - prefix - suffix),
+      .inserted_length = static_cast<int64_t>(text.size() - prefix - suffix)};
+
+  Version& version = versions.emplace_front();
+  ++num_versions;
+  version.source = std::move(source);
+  auto relexed =
+      Lex::Relex(*value_stores, *version.source, *old_version.tokens, edit,
+                 NullDiagnosticConsumer());
+  version.tokens = std::move(relexed.tokens);
+  version.parse_tree = Parse::Tree::Reparse(
+      *version.tokens, *old_version.parse_tree,
+      relexed.num_unchanged_prefix_tokens, relexed.num_unchanged_suffix_tokens,
+      NullDiagnosticConsumer(), /*vlog_stream=*/nullptr);
+  // Only the source text of the old version is still referenced, by values
+  // such as identifiers that weren't relexed.
+  old_version.tokens.reset();
+  old_version.parse_tree.reset();
+}
+
 void LanguageServer::OnDidOpenTextDocument(
     clang::clangd::DidOpenTextDocumentParams const& params) {
-  files_.emplace(params.textDocument.uri.file(), params.textDocument.text);
+  std::string file = params.textDocument.uri.file().str();
+  files_[file] = File();
+  files_[file].Update(file, params.textDocument.text);
 }
 
 void LanguageServer::OnDidChangeTextDocument(
@@ -24,7 +94,7 @@ void LanguageServer::OnDidChangeTextDocument(
   // full text is sent if full sync is specified in capabilities.
   assert(params.contentChanges.size() == 1);
   std::string file = params.textDocument.uri.file().str();
-  files_[file] = params.contentChanges[0].text;
+  files_[file].Update(file, params.contentChanges[0].text);
 }
 
 void LanguageServer::OnInitialize(
@@ -92,15 +162,14 @@ static auto GetName(const SharedValueStores& value_stores,
 void LanguageServer::OnDocumentSymbol(
     clang::clangd::DocumentSymbolParams const& params,
     clang::clangd::Callback<std::vector<clang::clangd::DocumentSymbol>> cb) {
-  SharedValueStores value_stores;
-  llvm::vfs::InMemoryFileSystem vfs;
-  auto file = params.textDocument.uri.file().str();
-  vfs.addFile(file, /*mtime=*/0,
-              llvm::MemoryBuffer::getMemBufferCopy(files_.at(file)));
-
-  auto buf = SourceBuffer::CreateFromFile(vfs, file, NullDiagnosticConsumer());
-  auto lexed = Lex::Lex(value_stores, *buf, NullDiagnosticConsumer());
-  auto parsed = Parse::Tree::Parse(lexed, NullDiagnosticConsumer(), nullptr);
+  const File& file = files_.at(params.textDocument.uri.file().str());
+  if (file.versions.empty()) {
+    cb(std::vector<clang::clangd::DocumentSymbol>());
+    return;
+  }
+  const SharedValueStores& value_stores = *file.value_stores;
+  const Lex::TokenizedBuffer& lexed = *file.current().tokens;
+  const Parse::Tree& parsed = *file.current().parse_tree;
   std::vector<clang::clangd::DocumentSymbol> result;
   for (const auto& node : parsed.postorder()) {
     clang::clangd::SymbolKind symbol_kind;
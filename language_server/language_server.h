@@ -4,6 +4,9 @@
 
 #ifndef CARBON_LANGUAGE_SERVER_LANGUAGE_SERVER_H_
 #define CARBON_LANGUAGE_SERVER_LANGUAGE_SERVER_H_
+#include <forward_list>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -11,6 +14,7 @@
 #include "clang-tools-extra/clangd/Protocol.h"
 #include "clang-tools-extra/clangd/Transport.h"
 #include "clang-tools-extra/clangd/support/Function.h"
+#include "toolchain/base/value_store.h"
 #include "toolchain/lex/tokenized_buffer.h"
 #include "toolchain/parse/tree.h"
 #include "toolchain/source/source_buffer.h"
@@ -49,9 +53,32 @@ class LanguageServer : public clang::clangd::Transport::MessageHandler,
   }
 
  private:
+  // A file managed by the language client, kept lexed and parsed as it's
+  // edited.
+  struct File {
+    // A version of the file's content. Later versions are lexed and parsed
+    // from earlier ones, and may refer into them.
+    struct Version {
+      std::optional<SourceBuffer> source;
+      std::optional<Lex::TokenizedBuffer> tokens;
+      std::optional<Parse::Tree> parse_tree;
+    };
+
+    // Sets the content of the file, relexing and reparsing only what changed
+    // since the current version where possible.
+    auto Update(llvm::StringRef filename, llvm::StringRef text) -> void;
+
+    auto current() const -> const Version& { return versions.front(); }
+
+    std::unique_ptr<SharedValueStores> value_stores;
+    // Versions since the file was last lexed from scratch, latest first.
+    std::forward_list<Version> versions;
+    int num_versions = 0;
+  };
+
   const std::unique_ptr<clang::clangd::Transport> transport_;
-  // content of files managed by the language client.
-  std::unordered_map<std::string, std::string> files_;
+  // files managed by the language client.
+  std::unordered_map<std::string, File> files_;
   // handlers for client methods and notifications
   clang::clangd::LSPBinder::RawHandlers handlers_;
 
@@ -0,0 +1,149 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "toolchain/base/time_trace.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Threading.h"
+
+namespace Carbon {
+
+// Returns the peak resident set size of the process so far, or 0 if it's
+// unavailable.
+static auto GetMaxRssBytes() -> int64_t {
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  // Linux reports kilobytes.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+TimeTrace::Scope::Scope(TimeTrace* trace, llvm::StringRef filename,
+                        llvm::StringLiteral phase)
+    : trace_(trace), filename_(filename), phase_(phase) {
+  if (trace_) {
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+TimeTrace::Scope::~Scope() {
+  if (!trace_) {
+    return;
+  }
+  auto end = std::chrono::steady_clock::now();
+  trace_->Add(
+      {.filename = filename_.str(),
+       .phase = phase_,
+       .thread_id = llvm::get_threadid(),
+       .start = std::chrono::duration_cast<std::chrono::microseconds>(
+           start_ - trace_->start_),
+       .duration =
+           std::chrono::duration_cast<std::chrono::microseconds>(end - start_),
+       .max_rss_bytes = GetMaxRssBytes(),
+       .malloc_bytes =
+           static_cast<int64_t>(llvm::sys::Process::GetMallocUsage()),
+       .counts = std::move(counts_)});
+}
+
+auto TimeTrace::Add(Event event) -> void {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(std::move(event));
+}
+
+auto TimeTrace::PrintChromeTrace(llvm::raw_ostream& out) const -> void {
+  std::lock_guard<std::mutex> lock(mutex_);
+  llvm::json::OStream json(out, /*IndentSize=*/2);
+  json.object([&] {
+    json.attributeArray("traceEvents", [&] {
+      for (const auto& event : events_) {
+        // Complete events, with a duration, in microseconds.
+        json.object([&] {
+          json.attribute("name", event.phase);
+          json.attribute("cat", "carbon");
+          json.attribute("ph", "X");
+          json.attribute("pid", 1);
+          json.attribute("tid", static_cast<int64_t>(event.thread_id));
+          json.attribute("ts", static_cast<int64_t>(event.start.count()));
+          json.attribute("dur", static_cast<int64_t>(event.duration.count()));
+          json.attributeObject("args", [&] {
+            json.attribute("file", event.filename);
+            for (auto [name, count] : event.counts) {
+              json.attribute(name, count);
+            }
+            json.attribute("max_rss_bytes", event.max_rss_bytes);
+            json.attribute("malloc_bytes", event.malloc_bytes);
+          });
+        });
+      }
+    });
+    json.attribute("displayTimeUnit", "ms");
+  });
+  out << "\n";
+}
+
+auto TimeTrace::OutputEventYaml(const Event& event) -> Yaml::OutputMapping {
+  return Yaml::OutputMapping([&](Yaml::OutputMapping::Map map) {
+    map.Add("wall_us", static_cast<int64_t>(event.duration.count()));
+    for (auto [name, count] : event.counts) {
+      map.Add(name, count);
+    }
+    map.Add("max_rss_bytes", event.max_rss_bytes);
+    map.Add("malloc_bytes", event.malloc_bytes);
+  });
+}
+
+auto TimeTrace::OutputYaml() const -> Yaml::OutputMapping {
+  return Yaml::OutputMapping([&](Yaml::OutputMapping::Map map) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Group events by file and by phase, in the order they were first seen.
+    llvm::MapVector<llvm::StringRef, llvm::SmallVector<const Event*>> files;
+    llvm::MapVector<llvm::StringRef, int64_t> phase_totals;
+    int64_t max_rss_bytes = 0;
+    for (const auto& event : events_) {
+      files[event.filename].push_back(&event);
+      phase_totals[event.phase] += event.duration.count();
+      max_rss_bytes = std::max(max_rss_bytes, event.max_rss_bytes);
+    }
+
+    map.Add("max_rss_bytes", max_rss_bytes);
+    map.Add("phase_totals_us",
+            Yaml::OutputMapping([&](Yaml::OutputMapping::Map phases_map) {
+              for (auto [phase, total] : phase_totals) {
+                phases_map.Add(phase, total);
+              }
+            }));
+    map.Add("files", Yaml::OutputMapping([&](Yaml::OutputMapping::Map
+                                                 files_map) {
+              for (const auto& [filename, file_events] : files) {
+                files_map.Add(
+                    filename,
+                    Yaml::OutputMapping([&](Yaml::OutputMapping::Map file_map) {
+                      for (const auto* event : file_events) {
+                        file_map.Add(event->phase, OutputEventYaml(*event));
+                      }
+                    }));
+              }
+            }));
+  });
+}
+
+}  // namespace Carbon
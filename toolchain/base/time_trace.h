@@ -0,0 +1,96 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_TOOLCHAIN_BASE_TIME_TRACE_H_
+#define CARBON_TOOLCHAIN_BASE_TIME_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "toolchain/base/yaml.h"
+
+namespace Carbon {
+
+// Records the wall time and memory use of each phase of compiling each file.
+// Phases may be recorded concurrently from multiple threads.
+class TimeTrace {
+ public:
+  // Counts of things, such as tokens, that a phase produced.
+  using Counts =
+      llvm::SmallVector<std::pair<llvm::StringLiteral, int64_t>, 2>;
+
+  // Times a phase of compiling a file, from construction to destruction. If
+  // the trace is null, this does nothing.
+  class Scope {
+   public:
+    explicit Scope(TimeTrace* trace, llvm::StringRef filename,
+                   llvm::StringLiteral phase);
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+    ~Scope();
+
+    // Records the number of things, such as tokens, that the phase produced.
+    auto AddCount(llvm::StringLiteral name, int64_t count) -> void {
+      if (trace_) {
+        counts_.push_back({name, count});
+      }
+    }
+
+   private:
+    TimeTrace* trace_;
+    llvm::StringRef filename_;
+    llvm::StringLiteral phase_;
+    std::chrono::steady_clock::time_point start_;
+    Counts counts_;
+  };
+
+  TimeTrace() : start_(std::chrono::steady_clock::now()) {}
+
+  // Prints the phases in the Chrome trace event format, which can be viewed
+  // with `chrome://tracing` or Perfetto.
+  auto PrintChromeTrace(llvm::raw_ostream& out) const -> void;
+
+  // Prints a summary of the phases of each file as YAML.
+  auto PrintSummary(llvm::raw_ostream& out) const -> void {
+    Yaml::Print(out, OutputYaml());
+  }
+
+  auto OutputYaml() const -> Yaml::OutputMapping;
+
+ private:
+  // A completed phase.
+  struct Event {
+    std::string filename;
+    llvm::StringRef phase;
+    uint64_t thread_id = 0;
+    // Relative to the start of the trace.
+    std::chrono::microseconds start = {};
+    std::chrono::microseconds duration = {};
+    // The peak resident set size of the process at the end of the phase. This
+    // is process-wide, so it only grows, and includes other threads.
+    int64_t max_rss_bytes = 0;
+    // The bytes allocated by malloc at the end of the phase, if available.
+    int64_t malloc_bytes = 0;
+    Counts counts;
+  };
+
+  static auto OutputEventYaml(const Event& event) -> Yaml::OutputMapping;
+
+  auto Add(Event event) -> void;
+
+  std::chrono::steady_clock::time_point start_;
+
+  mutable std::mutex mutex_;
+  llvm::SmallVector<Event> events_;
+};
+
+}  // namespace Carbon
+
+#endif  // CARBON_TOOLCHAIN_BASE_TIME_TRACE_H_
@@ -5,9 +5,15 @@
 #ifndef CARBON_TOOLCHAIN_BASE_VALUE_STORE_H_
 #define CARBON_TOOLCHAIN_BASE_VALUE_STORE_H_
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <type_traits>
+#include <utility>
 
 #include "common/check.h"
+#include "common/hashing.h"
 #include "common/ostream.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
@@ -15,6 +21,7 @@
 #include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/YAMLParser.h"
 #include "toolchain/base/index_base.h"
 #include "toolchain/base/yaml.h"
@@ -172,17 +179,50 @@ class ValueStore
 };
 
 // Storage for StringRefs. The caller is responsible for ensuring storage is
-// allocated.
+// allocated, and outlives the store.
+//
+// A thread-safe store can be shared by all the files in a compile, giving
+// identical strings the same ID across files. Strings are sharded by hash, with
+// a lock and map per shard, and IDs come from a shared counter. Otherwise,
+// there's a single shard and adding doesn't lock. Either way, values are kept
+// in chunks that never move, so `Get` doesn't lock; an ID must be passed
+// between threads with some synchronization, such as waiting on a thread pool,
+// before another thread calls `Get` with it.
 template <>
 class ValueStore<StringId> : public Yaml::Printable<ValueStore<StringId>> {
  public:
+  explicit ValueStore(bool thread_safe = false)
+      : thread_safe_(thread_safe),
+        shards_(std::make_unique<Shard[]>(thread_safe ? 1 << ShardBits : 1)) {}
+
+  // Not copyable or movable.
+  ValueStore(const ValueStore&) = delete;
+  auto operator=(const ValueStore&) -> ValueStore& = delete;
+
+  ~ValueStore() {
+    for (auto& chunk : chunks_) {
+      delete[] chunk.load(std::memory_order_relaxed);
+    }
+  }
+
   // Returns an ID to reference the value. May return an existing ID if the
   // string was previously added.
   auto Add(llvm::StringRef value) -> StringId {
-    auto [it, inserted] = map_.insert({value, StringId(values_.size())});
+    uint64_t hash = static_cast<uint64_t>(HashValue(value));
+    // The map uses the low bits of the hash, so shard on the high bits.
+    Shard& shard = shards_[thread_safe_ ? hash >> (64 - ShardBits) : 0];
+    std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+    if (thread_safe_) {
+      lock.lock();
+    }
+    auto [it, inserted] =
+        shard.map.insert({{.value = value, .hash = hash}, StringId::Invalid});
     if (inserted) {
-      CARBON_CHECK(it->second.index >= 0) << "Too many unique strings";
-      values_.push_back(value);
+      int32_t index = size_.fetch_add(1, std::memory_order_relaxed);
+      CARBON_CHECK(index >= 0) << "Too many unique strings";
+      auto [chunk, offset] = GetChunkAndOffset(index);
+      GetOrAllocateChunk(chunk)[offset] = value;
+      it->second = StringId(index);
     }
     return it->second;
   }
@@ -190,20 +230,98 @@ class ValueStore<StringId> : public Yaml::Printable<ValueStore<StringId>> {
   // Returns the value for an ID.
   auto Get(StringId id) const -> llvm::StringRef {
     CARBON_CHECK(id.is_valid());
-    return values_[id.index];
+    auto [chunk, offset] = GetChunkAndOffset(id.index);
+    return chunks_[chunk].load(std::memory_order_acquire)[offset];
   }
 
+  // Returns the number of strings. Values may still be being added when
+  // strings are concurrently added, so this should only be used to visit all
+  // of the strings once adding is done.
+  auto size() const -> int { return size_.load(std::memory_order_relaxed); }
+
+  // Returns whether strings may be added from multiple threads at once.
+  auto thread_safe() const -> bool { return thread_safe_; }
+
   auto OutputYaml() const -> Yaml::OutputMapping {
     return Yaml::OutputMapping([&](Yaml::OutputMapping::Map map) {
-      for (auto [i, val] : llvm::enumerate(values_)) {
-        map.Add(PrintToString(StringId(i)), val);
+      for (auto i : llvm::seq(size())) {
+        map.Add(PrintToString(StringId(i)), Get(StringId(i)));
       }
     });
   }
 
  private:
-  llvm::DenseMap<llvm::StringRef, StringId> map_;
-  llvm::SmallVector<llvm::StringRef> values_;
+  // A string with its hash, so that the hash is only computed once when it's
+  // added.
+  struct HashedString {
+    llvm::StringRef value;
+    uint64_t hash;
+  };
+
+  struct HashedStringInfo {
+    static auto getEmptyKey() -> HashedString {
+      return {.value = llvm::DenseMapInfo<llvm::StringRef>::getEmptyKey(),
+              .hash = 0};
+    }
+    static auto getTombstoneKey() -> HashedString {
+      return {.value = llvm::DenseMapInfo<llvm::StringRef>::getTombstoneKey(),
+              .hash = 0};
+    }
+    static auto getHashValue(const HashedString& key) -> unsigned {
+      return key.hash;
+    }
+    static auto isEqual(const HashedString& lhs, const HashedString& rhs)
+        -> bool {
+      return lhs.hash == rhs.hash &&
+             llvm::DenseMapInfo<llvm::StringRef>::isEqual(lhs.value,
+                                                          rhs.value);
+    }
+  };
+
+  // Each shard is on its own cache line, so that threads adding to different
+  // shards don't contend.
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    llvm::DenseMap<HashedString, StringId, HashedStringInfo> map;
+  };
+
+  static constexpr int ShardBits = 5;
+
+  // Chunk `i` holds `FirstChunkSize << i` values, so a fixed number of chunks
+  // covers every valid index.
+  static constexpr int FirstChunkBits = 10;
+  static constexpr int32_t FirstChunkSize = 1 << FirstChunkBits;
+  static constexpr int NumChunks = 32 - FirstChunkBits;
+
+  // Returns the chunk holding an index, and the index's offset within it.
+  static auto GetChunkAndOffset(int32_t index) -> std::pair<int, int32_t> {
+    int chunk = llvm::Log2_32((index >> FirstChunkBits) + 1);
+    return {chunk, index - FirstChunkSize * ((1 << chunk) - 1)};
+  }
+
+  // Returns a chunk, allocating it if this is the first value in it.
+  auto GetOrAllocateChunk(int chunk) -> llvm::StringRef* {
+    llvm::StringRef* values = chunks_[chunk].load(std::memory_order_acquire);
+    if (values) {
+      return values;
+    }
+    std::lock_guard<std::mutex> lock(chunks_mutex_);
+    values = chunks_[chunk].load(std::memory_order_acquire);
+    if (!values) {
+      values = new llvm::StringRef[FirstChunkSize << chunk];
+      chunks_[chunk].store(values, std::memory_order_release);
+    }
+    return values;
+  }
+
+  bool thread_safe_;
+  std::unique_ptr<Shard[]> shards_;
+
+  std::atomic<int32_t> size_ = 0;
+
+  // Guards allocating chunks.
+  std::mutex chunks_mutex_;
+  std::array<std::atomic<llvm::StringRef*>, NumChunks> chunks_ = {};
 };
 
 // A thin wrapper around a `ValueStore<StringId>` that provides a different IdT,
@@ -232,8 +350,14 @@ class StringStoreWrapper : public Printable<StringStoreWrapper<IdT>> {
 // This is provided mainly so that they don't need to be passed separately.
 class SharedValueStores : public Yaml::Printable<SharedValueStores> {
  public:
-  explicit SharedValueStores()
-      : identifiers_(&strings_), string_literals_(&strings_) {}
+  // Uses `strings` when provided, which may be shared with other compilation
+  // units. Otherwise, the unit has its own string store.
+  explicit SharedValueStores(ValueStore<StringId>* strings = nullptr)
+      : owned_strings_(strings ? nullptr
+                               : std::make_unique<ValueStore<StringId>>()),
+        strings_(strings ? strings : owned_strings_.get()),
+        identifiers_(strings_),
+        string_literals_(strings_) {}
 
   // Not copyable or movable.
   SharedValueStores(const SharedValueStores&) = delete;
@@ -256,6 +380,11 @@ class SharedValueStores : public Yaml::Printable<SharedValueStores> {
     return string_literals_;
   }
 
+  // Provides direct access to the unified string storage, which backs both
+  // identifiers and string literals.
+  auto strings() -> ValueStore<StringId>& { return *strings_; }
+  auto strings() const -> const ValueStore<StringId>& { return *strings_; }
+
   auto OutputYaml(std::optional<llvm::StringRef> filename = std::nullopt) const
       -> Yaml::OutputMapping {
     return Yaml::OutputMapping([&, filename](Yaml::OutputMapping::Map map) {
@@ -266,7 +395,7 @@ class SharedValueStores : public Yaml::Printable<SharedValueStores> {
               Yaml::OutputMapping([&](Yaml::OutputMapping::Map map) {
                 map.Add("integers", integers_.OutputYaml());
                 map.Add("reals", reals_.OutputYaml());
-                map.Add("strings", strings_.OutputYaml());
+                map.Add("strings", strings_->OutputYaml());
               }));
     });
   }
@@ -275,7 +404,8 @@ class SharedValueStores : public Yaml::Printable<SharedValueStores> {
   ValueStore<IntegerId> integers_;
   ValueStore<RealId> reals_;
 
-  ValueStore<StringId> strings_;
+  std::unique_ptr<ValueStore<StringId>> owned_strings_;
+  ValueStore<StringId>* strings_;
   StringStoreWrapper<IdentifierId> identifiers_;
   StringStoreWrapper<StringLiteralId> string_literals_;
 };
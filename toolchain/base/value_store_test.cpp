@@ -7,6 +7,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <thread>
+
+#include "llvm/Support/FormatVariadic.h"
 #include "testing/base/test_raw_ostream.h"
 #include "toolchain/testing/yaml_test_helpers.h"
 
@@ -79,6 +83,57 @@ TEST(ValueStore, String) {
   EXPECT_THAT(value_stores.identifiers().Add(b).index, Eq(b_id.index));
 }
 
+TEST(ValueStore, SharedStrings) {
+  ValueStore<StringId> strings(/*thread_safe=*/true);
+  SharedValueStores value_stores1(&strings);
+  SharedValueStores value_stores2(&strings);
+  auto a_id = value_stores1.identifiers().Add("a");
+  auto b_id = value_stores2.identifiers().Add("b");
+  EXPECT_THAT(a_id.index, Not(Eq(b_id.index)));
+
+  // Strings are shared between the stores.
+  EXPECT_THAT(value_stores2.identifiers().Add("a"), Eq(a_id));
+  EXPECT_THAT(value_stores1.identifiers().Get(b_id), Eq("b"));
+  EXPECT_THAT(strings.size(), Eq(2));
+}
+
+TEST(ValueStore, ConcurrentStrings) {
+  // Enough strings to fill several chunks, added from several threads in
+  // different orders. Each thread's order is a permutation because the
+  // multiplier is odd.
+  constexpr int NumStrings = 1 << 14;
+  constexpr int NumThreads = 4;
+  auto permute = [](int t, int i) {
+    return (i * (t * 2 + 1) + t) % NumStrings;
+  };
+  llvm::SmallVector<std::string> values;
+  for (int i : llvm::seq(NumStrings)) {
+    values.push_back(llvm::formatv("s{0}", i));
+  }
+  ValueStore<StringId> strings(/*thread_safe=*/true);
+  llvm::SmallVector<llvm::SmallVector<StringId>> ids(NumThreads);
+  llvm::SmallVector<std::thread> threads;
+  for (int t : llvm::seq(NumThreads)) {
+    threads.emplace_back([&, t] {
+      for (int i : llvm::seq(NumStrings)) {
+        ids[t].push_back(strings.Add(values[permute(t, i)]));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Every thread gets the same ID for a string, however the adds interleave.
+  EXPECT_THAT(strings.size(), Eq(NumStrings));
+  for (int t : llvm::seq(NumThreads)) {
+    for (int i : llvm::seq(NumStrings)) {
+      EXPECT_THAT(strings.Get(ids[t][i]), Eq(values[permute(t, i)]));
+      EXPECT_THAT(ids[t][i], Eq(ids[0][permute(t, i)]));
+    }
+  }
+}
+
 auto MatchSharedValues(testing::Matcher<Yaml::MappingValue> integers,
                        testing::Matcher<Yaml::MappingValue> reals,
                        testing::Matcher<Yaml::MappingValue> strings) -> auto {
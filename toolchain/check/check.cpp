@@ -4,30 +4,57 @@
 
 #include "toolchain/check/check.h"
 
+#include <mutex>
+
 #include "common/check.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "toolchain/base/pretty_stack_trace_function.h"
+#include "toolchain/base/time_trace.h"
 #include "toolchain/base/value_store.h"
 #include "toolchain/check/context.h"
+#include "toolchain/check/sem_ir_cache.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/lex/token_kind.h"
 #include "toolchain/parse/tree.h"
 #include "toolchain/parse/tree_node_location_translator.h"
 #include "toolchain/sem_ir/file.h"
+#include "toolchain/sem_ir/serialize.h"
 
 namespace Carbon::Check {
 
+// Forwards diagnostics, tracking whether any were produced. Only units without
+// any diagnostics are cached, because loading from the cache skips them.
+class DiagnosticTrackingConsumer : public DiagnosticConsumer {
+ public:
+  explicit DiagnosticTrackingConsumer(DiagnosticConsumer& next_consumer)
+      : next_consumer_(&next_consumer) {}
+
+  auto HandleDiagnostic(Diagnostic diagnostic) -> void override {
+    seen_diagnostic_ = true;
+    next_consumer_->HandleDiagnostic(std::move(diagnostic));
+  }
+
+  auto seen_diagnostic() const -> bool { return seen_diagnostic_; }
+
+ private:
+  DiagnosticConsumer* next_consumer_;
+  bool seen_diagnostic_ = false;
+};
+
 struct UnitInfo {
   explicit UnitInfo(Unit& unit)
       : unit(&unit),
         translator(unit.tokens, unit.tokens->source().filename(),
                    unit.parse_tree),
-        err_tracker(*unit.consumer),
+        diagnostic_tracker(*unit.consumer),
+        err_tracker(diagnostic_tracker),
         emitter(translator, err_tracker) {}
 
   Unit* unit;
 
   // Emitter information.
   Parse::NodeLocationTranslator translator;
+  DiagnosticTrackingConsumer diagnostic_tracker;
   ErrorTrackingDiagnosticConsumer err_tracker;
   DiagnosticEmitter<Parse::Node> emitter;
 
@@ -41,6 +68,10 @@ struct UnitInfo {
   // A list of incoming imports. This will be empty for `impl` files, because
   // imports only touch `api` files.
   llvm::SmallVector<UnitInfo*> incoming_imports;
+
+  // The key for this unit in the SemIR cache. Set when the unit is checked if
+  // a cache is in use, and used for the keys of units importing it.
+  std::string cache_key;
 };
 
 // Produces and checks the IR for the provided Parse::Tree.
@@ -101,6 +132,119 @@ static auto CheckParseTree(const SemIR::File& builtin_ir, UnitInfo& unit_info,
 #endif
 }
 
+// Checks a unit, using the SemIR cache if there is one. Units are loaded from
+// the cache when possible, and otherwise checked and then stored if checking
+// produced no diagnostics.
+static auto CheckParseTreeWithCache(const SemIR::File& builtin_ir,
+                                    UnitInfo& unit_info, SemIRCache* cache,
+                                    TimeTrace* time_trace,
+                                    llvm::raw_ostream* vlog_stream) -> void {
+  const auto& source = unit_info.unit->tokens->source();
+  TimeTrace::Scope trace_scope(time_trace, source.filename(),
+                               "Check::CheckParseTree");
+  auto add_inst_count = llvm::make_scope_exit([&] {
+    if (*unit_info.unit->sem_ir) {
+      trace_scope.AddCount("insts", (*unit_info.unit->sem_ir)->insts().size());
+    }
+  });
+
+  if (!cache) {
+    CheckParseTree(builtin_ir, unit_info, vlog_stream);
+    return;
+  }
+
+  llvm::SmallVector<llvm::StringRef> import_keys;
+  for (const auto& import : unit_info.imports) {
+    import_keys.push_back(import.second->cache_key);
+  }
+  unit_info.cache_key =
+      cache->ComputeKey(source.filename(), source.text(), import_keys);
+
+  // Diagnostics from packaging and imports may already have been produced;
+  // those units are always checked.
+  bool cacheable = !unit_info.diagnostic_tracker.seen_diagnostic();
+  if (cacheable) {
+    if (auto data = cache->Lookup(unit_info.cache_key)) {
+      auto& sem_ir = unit_info.unit->sem_ir->emplace(
+          *unit_info.unit->value_stores, source.filename().str(), &builtin_ir);
+      if (SemIR::DeserializeFile(*data, sem_ir).ok()) {
+        trace_scope.AddCount("loaded_from_cache", 1);
+        if (vlog_stream) {
+          *vlog_stream << "Loaded SemIR from cache: " << source.filename()
+                       << "\n";
+        }
+        return;
+      }
+      // Fall back to checking. Shared values can't be removed, so any that
+      // were added before the failure remain, unused.
+      unit_info.unit->sem_ir->reset();
+    }
+  }
+
+  CheckParseTree(builtin_ir, unit_info, vlog_stream);
+
+  const SemIR::File& sem_ir = **unit_info.unit->sem_ir;
+  if (cacheable && !sem_ir.has_errors() &&
+      !unit_info.diagnostic_tracker.seen_diagnostic()) {
+    std::string data;
+    llvm::raw_string_ostream out(data);
+    SemIR::SerializeFile(sem_ir, out);
+    cache->Store(unit_info.cache_key, out.str());
+  }
+}
+
+// Checks units on a thread pool as their imports become ready. Each finished
+// unit releases the units importing it, which are then queued, so every unit
+// whose imports are done can be checked at the same time.
+class ParallelChecker {
+ public:
+  explicit ParallelChecker(const SemIR::File& builtin_ir,
+                           llvm::ThreadPool& thread_pool, SemIRCache* cache,
+                           TimeTrace* time_trace)
+      : builtin_ir_(&builtin_ir),
+        thread_pool_(&thread_pool),
+        cache_(cache),
+        time_trace_(time_trace) {}
+
+  // Checks the initially ready units and everything they transitively unblock.
+  // Returns the number of units checked; units in or depending on an import
+  // cycle will be left unchecked.
+  auto Run(llvm::ArrayRef<UnitInfo*> ready_to_check) -> int {
+    for (auto* unit_info : ready_to_check) {
+      Schedule(*unit_info);
+    }
+    thread_pool_->wait();
+    return checked_count_;
+  }
+
+ private:
+  // Queues a unit to be checked, after which it releases its incoming imports.
+  auto Schedule(UnitInfo& unit_info) -> void {
+    thread_pool_->async([this, &unit_info] {
+      CheckParseTreeWithCache(*builtin_ir_, unit_info, cache_, time_trace_,
+                              /*vlog_stream=*/nullptr);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++checked_count_;
+      for (auto* incoming_import : unit_info.incoming_imports) {
+        --incoming_import->imports_remaining;
+        if (incoming_import->imports_remaining == 0) {
+          Schedule(*incoming_import);
+        }
+      }
+    });
+  }
+
+  const SemIR::File* builtin_ir_;
+  llvm::ThreadPool* thread_pool_;
+  SemIRCache* cache_;
+  TimeTrace* time_trace_;
+
+  // Guards `imports_remaining` on all units, and `checked_count_`.
+  std::mutex mutex_;
+  int checked_count_ = 0;
+};
+
 // The package and library names, used as map keys.
 using ImportKey = std::pair<llvm::StringRef, llvm::StringRef>;
 
@@ -332,7 +476,9 @@ static auto BuildApiMapAndDiagnosePackaging(
 
 auto CheckParseTrees(const SemIR::File& builtin_ir,
                      llvm::MutableArrayRef<Unit> units,
-                     llvm::raw_ostream* vlog_stream) -> void {
+                     llvm::ThreadPool* thread_pool, SemIRCache* cache,
+                     TimeTrace* time_trace, llvm::raw_ostream* vlog_stream)
+    -> void {
   // Prepare diagnostic emitters in case we run into issues during package
   // checking.
   //
@@ -371,21 +517,30 @@ auto CheckParseTrees(const SemIR::File& builtin_ir,
 
   // Check everything with no dependencies. Earlier entries with dependencies
   // will be checked as soon as all their dependencies have been checked.
-  for (int check_index = 0;
-       check_index < static_cast<int>(ready_to_check.size()); ++check_index) {
-    auto* unit_info = ready_to_check[check_index];
-    CheckParseTree(builtin_ir, *unit_info, vlog_stream);
-    for (auto* incoming_import : unit_info->incoming_imports) {
-      --incoming_import->imports_remaining;
-      if (incoming_import->imports_remaining == 0) {
-        ready_to_check.push_back(incoming_import);
+  int checked_count;
+  if (thread_pool && !vlog_stream) {
+    checked_count = ParallelChecker(builtin_ir, *thread_pool, cache, time_trace)
+                        .Run(ready_to_check);
+  } else {
+    for (int check_index = 0;
+         check_index < static_cast<int>(ready_to_check.size());
+         ++check_index) {
+      auto* unit_info = ready_to_check[check_index];
+      CheckParseTreeWithCache(builtin_ir, *unit_info, cache, time_trace,
+                              vlog_stream);
+      for (auto* incoming_import : unit_info->incoming_imports) {
+        --incoming_import->imports_remaining;
+        if (incoming_import->imports_remaining == 0) {
+          ready_to_check.push_back(incoming_import);
+        }
       }
     }
+    checked_count = ready_to_check.size();
   }
 
   // If there are still units with remaining imports, it means there's a
   // dependency loop.
-  if (ready_to_check.size() < unit_infos.size()) {
+  if (checked_count < static_cast<int>(unit_infos.size())) {
     // Go through units and mask out unevaluated imports. This breaks everything
     // associated with a loop equivalently, whether it's part of it or depending
     // on a part of it.
@@ -412,7 +567,11 @@ auto CheckParseTrees(const SemIR::File& builtin_ir,
     // incomplete imports.
     for (auto& unit_info : unit_infos) {
       if (unit_info.imports_remaining > 0) {
+        TimeTrace::Scope trace_scope(
+            time_trace, unit_info.unit->tokens->source().filename(),
+            "Check::CheckParseTree");
         CheckParseTree(builtin_ir, unit_info, vlog_stream);
+        trace_scope.AddCount("insts", (*unit_info.unit->sem_ir)->insts().size());
       }
     }
   }
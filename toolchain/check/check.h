@@ -6,7 +6,10 @@
 #define CARBON_TOOLCHAIN_CHECK_CHECK_H_
 
 #include "common/ostream.h"
+#include "llvm/Support/ThreadPool.h"
+#include "toolchain/base/time_trace.h"
 #include "toolchain/base/value_store.h"
+#include "toolchain/check/sem_ir_cache.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/lex/tokenized_buffer.h"
 #include "toolchain/parse/tree.h"
@@ -32,9 +35,22 @@ struct Unit {
 
 // Checks a group of parse trees. This will use imports to decide the order of
 // checking.
+//
+// If a thread pool is provided, units are checked on it as soon as all of their
+// imports have been checked, so independent units are checked concurrently.
+// Each unit's diagnostics still go only to its own consumer. Checking is always
+// serial when verbose logging is enabled, to keep the log readable.
+//
+// If a cache is provided, units whose source and imports are unchanged since
+// they were cached are loaded rather than checked. Units that produce any
+// diagnostics are never cached.
+//
+// If a time trace is provided, checking of each unit is recorded in it.
 auto CheckParseTrees(const SemIR::File& builtin_ir,
                      llvm::MutableArrayRef<Unit> units,
-                     llvm::raw_ostream* vlog_stream) -> void;
+                     llvm::ThreadPool* thread_pool, SemIRCache* cache,
+                     TimeTrace* time_trace, llvm::raw_ostream* vlog_stream)
+    -> void;
 
 }  // namespace Carbon::Check
 
@@ -0,0 +1,57 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include "common/check.h"
+#include "toolchain/check/check.h"
+#include "toolchain/testing/benchmark_sources.h"
+#include "toolchain/testing/compile_helper.h"
+
+namespace Carbon::Check {
+namespace {
+
+template <auto MakeSources>
+void BM_Check(benchmark::State& state) {
+  Testing::CompileHelper helper(MakeSources(state.range(0)));
+
+  int64_t num_nodes = 0;
+  int64_t bytes_allocated = 0;
+  for (auto _ : state) {
+    // Each iteration checks from freshly lexed and parsed files, so that the
+    // value stores don't already hold the previous iteration's values.
+    state.PauseTiming();
+    helper.RunParse();
+    auto units = helper.GetCheckUnits();
+    state.ResumeTiming();
+
+    int64_t start_bytes = Testing::GetMallocBytes();
+    CheckParseTrees(helper.builtins(), units, /*thread_pool=*/nullptr,
+                    /*cache=*/nullptr, /*time_trace=*/nullptr,
+                    /*vlog_stream=*/nullptr);
+    bytes_allocated = Testing::GetMallocBytes() - start_bytes;
+  }
+
+  int64_t num_insts = 0;
+  for (const auto& unit : helper.units()) {
+    CARBON_CHECK(!unit->sem_ir->has_errors());
+    num_nodes += unit->parse_tree->size();
+    num_insts += unit->sem_ir->insts().size();
+  }
+  state.counters["nodes_per_second"] = benchmark::Counter(
+      num_nodes, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["insts_per_second"] = benchmark::Counter(
+      num_insts, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes_allocated"] = bytes_allocated;
+}
+
+BENCHMARK(BM_Check<Testing::DeepExpressionSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Check<Testing::ManyFunctionsSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Check<Testing::WideStructSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Check<Testing::WideTupleSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Check<Testing::ManyClassesSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Check<Testing::ImportChainSources>)->Arg(1 << 4)->Arg(1 << 8);
+
+}  // namespace
+}  // namespace Carbon::Check
@@ -4,11 +4,13 @@
 
 #include "toolchain/check/context.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
 #include "common/check.h"
 #include "common/vlog.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Sequence.h"
 #include "toolchain/check/decl_name_stack.h"
 #include "toolchain/check/inst_block_stack.h"
@@ -32,13 +34,8 @@ Context::Context(const Lex::TokenizedBuffer& tokens, DiagnosticEmitter& emitter,
       inst_block_stack_("inst_block_stack_", sem_ir, vlog_stream),
       params_or_args_stack_("params_or_args_stack_", sem_ir, vlog_stream),
       args_type_info_stack_("args_type_info_stack_", sem_ir, vlog_stream),
-      decl_name_stack_(this) {
-  // Inserts the "Error" and "Type" types as "used types" so that
-  // canonicalization can skip them. We don't emit either for lowering.
-  canonical_types_.insert({SemIR::InstId::BuiltinError, SemIR::TypeId::Error});
-  canonical_types_.insert(
-      {SemIR::InstId::BuiltinTypeType, SemIR::TypeId::TypeType});
-}
+      decl_name_stack_(this),
+      canonical_types_(/*Size=*/64) {}
 
 auto Context::TODO(Parse::Node parse_node, std::string label) -> bool {
   CARBON_DIAGNOSTIC(SemanticsTodo, Error, "Semantics TODO: `{0}`.",
@@ -52,7 +49,7 @@ auto Context::VerifyOnFinish() -> void {
   // various pieces of context go out of scope. At this point, nothing should
   // remain.
   // node_stack_ will still contain top-level entities.
-  CARBON_CHECK(name_lookup_.empty()) << name_lookup_.size();
+  CARBON_CHECK(lexical_results_.empty()) << lexical_results_.size();
   CARBON_CHECK(scope_stack_.empty()) << scope_stack_.size();
   CARBON_CHECK(inst_block_stack_.empty()) << inst_block_stack_.size();
   CARBON_CHECK(params_or_args_stack_.empty()) << params_or_args_stack_.size();
@@ -112,20 +109,49 @@ auto Context::NoteIncompleteClass(SemIR::ClassId class_id,
   }
 }
 
+// Returns the index of a name in name_lookup_. Special names, which have
+// negative IDs, are placed before identifiers.
+static auto GetNameLookupIndex(SemIR::NameId name_id) -> size_t {
+  CARBON_DCHECK(name_id.index >= SemIR::NameId::ReturnSlot.index)
+      << "Unknown special name " << name_id;
+  return name_id.index - SemIR::NameId::ReturnSlot.index;
+}
+
+auto Context::GetLexicalLookupResult(SemIR::NameId name_id)
+    -> const LexicalLookupResult* {
+  auto lookup_index = GetNameLookupIndex(name_id);
+  if (lookup_index >= name_lookup_.size() || name_lookup_[lookup_index] < 0) {
+    return nullptr;
+  }
+  return &lexical_results_[name_lookup_[lookup_index]];
+}
+
 auto Context::AddNameToLookup(Parse::Node name_node, SemIR::NameId name_id,
                               SemIR::InstId target_id) -> void {
-  if (current_scope().names.insert(name_id).second) {
-    // TODO: Reject if we previously performed a failed lookup for this name in
-    // this scope or a scope nested within it.
-    auto& lexical_results = name_lookup_[name_id];
-    CARBON_CHECK(lexical_results.empty() ||
-                 lexical_results.back().scope_index < current_scope_index())
+  auto lookup_index = GetNameLookupIndex(name_id);
+  if (lookup_index >= name_lookup_.size()) {
+    name_lookup_.resize(std::max(lookup_index + 1, name_lookup_.size() * 2),
+                        -1);
+  }
+
+  auto& innermost_index = name_lookup_[lookup_index];
+  if (innermost_index >= 0) {
+    const auto& innermost = lexical_results_[innermost_index];
+    if (innermost.scope_index == current_scope_index()) {
+      DiagnoseDuplicateName(name_node, innermost.node_id);
+      return;
+    }
+    CARBON_CHECK(innermost.scope_index < current_scope_index())
         << "Failed to clean up after scope nested within the current scope";
-    lexical_results.push_back(
-        {.node_id = target_id, .scope_index = current_scope_index()});
-  } else {
-    DiagnoseDuplicateName(name_node, name_lookup_[name_id].back().node_id);
   }
+
+  // TODO: Reject if we previously performed a failed lookup for this name in
+  // this scope or a scope nested within it.
+  lexical_results_.push_back({.node_id = target_id,
+                              .scope_index = current_scope_index(),
+                              .name_id = name_id,
+                              .shadowed_index = innermost_index});
+  innermost_index = static_cast<int32_t>(lexical_results_.size()) - 1;
 }
 
 auto Context::LookupNameInDecl(Parse::Node parse_node, SemIR::NameId name_id,
@@ -154,14 +180,9 @@ auto Context::LookupNameInDecl(Parse::Node parse_node, SemIR::NameId name_id,
     //    In this case, we're not in the correct scope to define a member of
     //    class A, so we should reject, and we achieve this by not finding the
     //    name A from the outer scope.
-    if (auto name_it = name_lookup_.find(name_id);
-        name_it != name_lookup_.end()) {
-      CARBON_CHECK(!name_it->second.empty())
-          << "Should have been erased: " << names().GetFormatted(name_id);
-      auto result = name_it->second.back();
-      if (result.scope_index == current_scope_index()) {
-        return result.node_id;
-      }
+    if (const auto* result = GetLexicalLookupResult(name_id);
+        result && result->scope_index == current_scope_index()) {
+      return result->node_id;
     }
     return SemIR::InstId::Invalid;
   } else {
@@ -178,21 +199,14 @@ auto Context::LookupUnqualifiedName(Parse::Node parse_node,
 
   // Find the results from enclosing lexical scopes. These will be combined with
   // results from non-lexical scopes such as namespaces and classes.
-  llvm::ArrayRef<LexicalLookupResult> lexical_results;
-  if (auto name_it = name_lookup_.find(name_id);
-      name_it != name_lookup_.end()) {
-    lexical_results = name_it->second;
-    CARBON_CHECK(!lexical_results.empty())
-        << "Should have been erased: " << names().GetFormatted(name_id);
-  }
+  const auto* lexical_result = GetLexicalLookupResult(name_id);
 
   // Walk the non-lexical scopes and perform lookups into each of them.
   for (auto [index, name_scope_id] : llvm::reverse(non_lexical_scope_stack_)) {
     // If the innermost lexical result is within this non-lexical scope, then
     // it shadows all further non-lexical results and we're done.
-    if (!lexical_results.empty() &&
-        lexical_results.back().scope_index > index) {
-      return lexical_results.back().node_id;
+    if (lexical_result && lexical_result->scope_index > index) {
+      return lexical_result->node_id;
     }
 
     auto non_lexical_result =
@@ -203,8 +217,8 @@ auto Context::LookupUnqualifiedName(Parse::Node parse_node,
     }
   }
 
-  if (!lexical_results.empty()) {
-    return lexical_results.back().node_id;
+  if (lexical_result) {
+    return lexical_result->node_id;
   }
 
   // We didn't find anything at all.
@@ -232,9 +246,11 @@ auto Context::LookupQualifiedName(Parse::Node parse_node, SemIR::NameId name_id,
 
 auto Context::PushScope(SemIR::InstId scope_inst_id,
                         SemIR::NameScopeId scope_id) -> void {
-  scope_stack_.push_back({.index = next_scope_index_,
-                          .scope_inst_id = scope_inst_id,
-                          .scope_id = scope_id});
+  scope_stack_.push_back(
+      {.index = next_scope_index_,
+       .scope_inst_id = scope_inst_id,
+       .scope_id = scope_id,
+       .lexical_results_begin = static_cast<int32_t>(lexical_results_.size())});
   if (scope_id.is_valid()) {
     non_lexical_scope_stack_.push_back({next_scope_index_, scope_id});
   }
@@ -247,16 +263,15 @@ auto Context::PushScope(SemIR::InstId scope_inst_id,
 
 auto Context::PopScope() -> void {
   auto scope = scope_stack_.pop_back_val();
-  for (const auto& str_id : scope.names) {
-    auto it = name_lookup_.find(str_id);
-    CARBON_CHECK(it->second.back().scope_index == scope.index)
-        << "Inconsistent scope index for name " << names().GetFormatted(str_id);
-    if (it->second.size() == 1) {
-      // Erase names that no longer resolve.
-      name_lookup_.erase(it);
-    } else {
-      it->second.pop_back();
-    }
+  // Unwind the results added in this scope, restoring the results they
+  // shadowed.
+  while (static_cast<int32_t>(lexical_results_.size()) >
+         scope.lexical_results_begin) {
+    auto result = lexical_results_.pop_back_val();
+    CARBON_CHECK(result.scope_index == scope.index)
+        << "Inconsistent scope index for name "
+        << names().GetFormatted(result.name_id);
+    name_lookup_[GetNameLookupIndex(result.name_id)] = result.shadowed_index;
   }
 
   if (scope.scope_id.is_valid()) {
@@ -915,127 +930,156 @@ auto Context::TryToCompleteType(
   return TypeCompleter(*this, diagnoser).Complete(type_id);
 }
 
-auto Context::CanonicalizeTypeImpl(
-    SemIR::InstKind kind,
-    llvm::function_ref<bool(llvm::FoldingSetNodeID& canonical_id)> profile_type,
-    llvm::function_ref<SemIR::InstId()> make_inst) -> SemIR::TypeId {
-  llvm::FoldingSetNodeID canonical_id;
-  kind.Profile(canonical_id);
-  if (!profile_type(canonical_id)) {
-    return SemIR::TypeId::Error;
-  }
-
-  void* insert_pos;
-  auto* node =
-      canonical_type_nodes_.FindNodeOrInsertPos(canonical_id, insert_pos);
-  if (node != nullptr) {
-    return node->type_id();
-  }
-
-  auto inst_id = make_inst();
-  auto type_id = types().Add({.inst_id = inst_id});
-  CARBON_CHECK(canonical_types_.insert({inst_id, type_id}).second);
-  type_node_storage_.push_back(
-      std::make_unique<TypeNode>(canonical_id, type_id));
-
-  // In a debug build, check that our insertion position is still valid. It
-  // could have been invalidated by a misbehaving `make_inst`.
-  CARBON_DCHECK([&] {
-    void* check_insert_pos;
-    auto* check_node = canonical_type_nodes_.FindNodeOrInsertPos(
-        canonical_id, check_insert_pos);
-    return !check_node && insert_pos == check_insert_pos;
-  }()) << "Type was created recursively during canonicalization";
-
-  canonical_type_nodes_.InsertNode(type_node_storage_.back().get(), insert_pos);
-  return type_id;
-}
-
-// Compute a fingerprint for a tuple type, for use as a key in a folding set.
-static auto ProfileTupleType(llvm::ArrayRef<SemIR::TypeId> type_ids,
-                             llvm::FoldingSetNodeID& canonical_id) -> void {
-  for (auto type_id : type_ids) {
-    canonical_id.AddInteger(type_id.index);
-  }
-}
-
-// Compute a fingerprint for a type, for use as a key in a folding set. Returns
-// false if not supported, which is presently the case for compile-time
-// expressions.
-// TODO: Once support is more complete, in particular ensuring that various
-// valid compile-time expressions are supported, it may be desirable to switch
-// the default to a CARBON_FATAL error.
-static auto ProfileType(Context& semantics_context, SemIR::Inst inst,
-                        llvm::FoldingSetNodeID& canonical_id) -> bool {
+auto Context::GetTypeKey(SemIR::Inst inst) -> std::optional<TypeKey> {
   switch (inst.kind()) {
     case SemIR::ArrayType::Kind: {
       auto array_type = inst.As<SemIR::ArrayType>();
-      canonical_id.AddInteger(
-          semantics_context.sem_ir().GetArrayBoundValue(array_type.bound_id));
-      canonical_id.AddInteger(array_type.element_type_id.index);
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = static_cast<int64_t>(
+                         sem_ir().GetArrayBoundValue(array_type.bound_id)),
+                     .arg1 = array_type.element_type_id.index};
     }
     case SemIR::Builtin::Kind:
-      canonical_id.AddInteger(inst.As<SemIR::Builtin>().builtin_kind.AsInt());
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = inst.As<SemIR::Builtin>().builtin_kind.AsInt()};
     case SemIR::ClassType::Kind:
-      canonical_id.AddInteger(inst.As<SemIR::ClassType>().class_id.index);
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = inst.As<SemIR::ClassType>().class_id.index};
     case SemIR::CrossRef::Kind: {
       // TODO: Cross-references should be canonicalized by looking at their
       // target rather than treating them as new unique types.
       auto xref = inst.As<SemIR::CrossRef>();
-      canonical_id.AddInteger(xref.ir_id.index);
-      canonical_id.AddInteger(xref.inst_id.index);
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = xref.ir_id.index,
+                     .arg1 = xref.inst_id.index};
     }
     case SemIR::ConstType::Kind:
-      canonical_id.AddInteger(
-          semantics_context
-              .GetUnqualifiedType(inst.As<SemIR::ConstType>().inner_id)
-              .index);
-      break;
+      return TypeKey{
+          .kind = inst.kind(),
+          .arg0 =
+              GetUnqualifiedType(inst.As<SemIR::ConstType>().inner_id).index};
     case SemIR::PointerType::Kind:
-      canonical_id.AddInteger(inst.As<SemIR::PointerType>().pointee_id.index);
-      break;
-    case SemIR::StructType::Kind: {
-      auto fields = semantics_context.inst_blocks().Get(
-          inst.As<SemIR::StructType>().fields_id);
-      for (const auto& field_id : fields) {
-        auto field =
-            semantics_context.insts().GetAs<SemIR::StructTypeField>(field_id);
-        canonical_id.AddInteger(field.name_id.index);
-        canonical_id.AddInteger(field.field_type_id.index);
-      }
-      break;
-    }
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = inst.As<SemIR::PointerType>().pointee_id.index};
+    case SemIR::StructType::Kind:
+      return TypeKey{.kind = inst.kind(),
+                     .fields = inst_blocks().Get(
+                         inst.As<SemIR::StructType>().fields_id)};
     case SemIR::TupleType::Kind:
-      ProfileTupleType(semantics_context.type_blocks().Get(
-                           inst.As<SemIR::TupleType>().elements_id),
-                       canonical_id);
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .elements = type_blocks().Get(
+                         inst.As<SemIR::TupleType>().elements_id)};
     case SemIR::UnboundFieldType::Kind: {
       auto unbound_field_type = inst.As<SemIR::UnboundFieldType>();
-      canonical_id.AddInteger(unbound_field_type.class_type_id.index);
-      canonical_id.AddInteger(unbound_field_type.field_type_id.index);
-      break;
+      return TypeKey{.kind = inst.kind(),
+                     .arg0 = unbound_field_type.class_type_id.index,
+                     .arg1 = unbound_field_type.field_type_id.index};
     }
     default: {
       // Right now, this is only expected to occur in calls from
       // ExprAsType. Diagnostics are issued there.
-      return false;
+      return std::nullopt;
     }
   }
-  return true;
+}
+
+auto Context::HashTypeKey(const TypeKey& key) -> HashCode {
+  Hasher hasher(Hasher::StaticRandomData[7]);
+  hasher.Hash(key.kind.AsInt(), key.arg0, key.arg1);
+  // Tuple elements are hashed as a single block of bytes. Struct fields are
+  // separate instructions, so their names and types are hashed one by one.
+  hasher.HashSizedBytes(llvm::ArrayRef(
+      reinterpret_cast<const std::byte*>(key.elements.data()),
+      key.elements.size() * sizeof(SemIR::TypeId)));
+  for (auto field_id : key.fields) {
+    auto field = insts().GetAs<SemIR::StructTypeField>(field_id);
+    hasher.HashDense(field.name_id.index, field.field_type_id.index);
+  }
+  return static_cast<HashCode>(hasher);
+}
+
+auto Context::TypeHasKey(SemIR::TypeId type_id, const TypeKey& key) -> bool {
+  auto inst = insts().Get(types().Get(type_id).inst_id);
+  if (inst.kind() != key.kind) {
+    return false;
+  }
+  auto type_key = GetTypeKey(inst);
+  CARBON_CHECK(type_key) << "Canonical type has no key: " << inst;
+  if (type_key->arg0 != key.arg0 || type_key->arg1 != key.arg1 ||
+      !llvm::equal(type_key->elements, key.elements)) {
+    return false;
+  }
+  return llvm::equal(type_key->fields, key.fields,
+                     [&](SemIR::InstId lhs_id, SemIR::InstId rhs_id) {
+                       auto lhs = insts().GetAs<SemIR::StructTypeField>(lhs_id);
+                       auto rhs = insts().GetAs<SemIR::StructTypeField>(rhs_id);
+                       return lhs.name_id == rhs.name_id &&
+                              lhs.field_type_id == rhs.field_type_id;
+                     });
+}
+
+auto Context::GrowCanonicalTypes() -> void {
+  llvm::SmallVector<CanonicalTypeEntry> old_types(canonical_types_.size() * 2);
+  std::swap(old_types, canonical_types_);
+  ssize_t mask = canonical_types_.size() - 1;
+  for (auto entry : old_types) {
+    if (!entry.type_id.is_valid()) {
+      continue;
+    }
+    // Only the tag is stored, so the type's slot is found by hashing it again.
+    auto key = GetTypeKey(insts().Get(types().Get(entry.type_id).inst_id));
+    CARBON_CHECK(key) << "Canonical type has no key";
+    ssize_t index = HashTypeKey(*key)
+                        .ExtractIndexAndTag<32>(canonical_types_.size())
+                        .first;
+    while (canonical_types_[index].type_id.is_valid()) {
+      index = (index + 1) & mask;
+    }
+    canonical_types_[index] = entry;
+  }
+}
+
+auto Context::CanonicalizeTypeImpl(
+    const TypeKey& key, llvm::function_ref<SemIR::InstId()> make_inst,
+    SemIR::InstId inst_id) -> SemIR::TypeId {
+  auto [index, tag] =
+      HashTypeKey(key).ExtractIndexAndTag<32>(canonical_types_.size());
+  ssize_t mask = canonical_types_.size() - 1;
+  for (; canonical_types_[index].type_id.is_valid();
+       index = (index + 1) & mask) {
+    const auto& entry = canonical_types_[index];
+    if (entry.tag == tag &&
+        (types().Get(entry.type_id).inst_id == inst_id ||
+         TypeHasKey(entry.type_id, key))) {
+      return entry.type_id;
+    }
+  }
+
+  // In a debug build, check that our insertion position is still valid. It
+  // could have been invalidated by a misbehaving `make_inst`.
+  int num_types = num_canonical_types_;
+  auto new_inst_id = make_inst();
+  CARBON_DCHECK(num_canonical_types_ == num_types)
+      << "Type was created recursively during canonicalization";
+
+  auto type_id = types().Add({.inst_id = new_inst_id});
+  canonical_types_[index] = {.tag = tag, .type_id = type_id};
+  ++num_canonical_types_;
+  if (num_canonical_types_ * 4 >
+      static_cast<int>(canonical_types_.size()) * 3) {
+    GrowCanonicalTypes();
+  }
+  return type_id;
 }
 
 auto Context::CanonicalizeTypeAndAddInstIfNew(SemIR::Inst inst)
     -> SemIR::TypeId {
-  auto profile_node = [&](llvm::FoldingSetNodeID& canonical_id) {
-    return ProfileType(*this, inst, canonical_id);
-  };
+  auto key = GetTypeKey(inst);
+  if (!key) {
+    return SemIR::TypeId::Error;
+  }
   auto make_inst = [&] { return AddConstantInst(inst); };
-  return CanonicalizeTypeImpl(inst.kind(), profile_node, make_inst);
+  return CanonicalizeTypeImpl(*key, make_inst);
 }
 
 auto Context::CanonicalizeType(SemIR::InstId inst_id) -> SemIR::TypeId {
@@ -1044,17 +1088,21 @@ auto Context::CanonicalizeType(SemIR::InstId inst_id) -> SemIR::TypeId {
   }
   inst_id = FollowNameRefs(inst_id);
 
-  auto it = canonical_types_.find(inst_id);
-  if (it != canonical_types_.end()) {
-    return it->second;
+  // The "Error" and "Type" types have fixed IDs and aren't in the canonical
+  // type table. We don't emit either for lowering.
+  if (inst_id == SemIR::InstId::BuiltinError) {
+    return SemIR::TypeId::Error;
+  }
+  if (inst_id == SemIR::InstId::BuiltinTypeType) {
+    return SemIR::TypeId::TypeType;
   }
 
-  auto inst = insts().Get(inst_id);
-  auto profile_node = [&](llvm::FoldingSetNodeID& canonical_id) {
-    return ProfileType(*this, inst, canonical_id);
-  };
+  auto key = GetTypeKey(insts().Get(inst_id));
+  if (!key) {
+    return SemIR::TypeId::Error;
+  }
   auto make_inst = [&] { return inst_id; };
-  return CanonicalizeTypeImpl(inst.kind(), profile_node, make_inst);
+  return CanonicalizeTypeImpl(*key, make_inst, inst_id);
 }
 
 auto Context::CanonicalizeStructType(Parse::Node parse_node,
@@ -1068,16 +1116,12 @@ auto Context::CanonicalizeTupleType(Parse::Node parse_node,
                                     llvm::ArrayRef<SemIR::TypeId> type_ids)
     -> SemIR::TypeId {
   // Defer allocating a SemIR::TypeBlockId until we know this is a new type.
-  auto profile_tuple = [&](llvm::FoldingSetNodeID& canonical_id) {
-    ProfileTupleType(type_ids, canonical_id);
-    return true;
-  };
   auto make_tuple_inst = [&] {
     return AddConstantInst(SemIR::TupleType{parse_node, SemIR::TypeId::TypeType,
                                             type_blocks().Add(type_ids)});
   };
-  return CanonicalizeTypeImpl(SemIR::TupleType::Kind, profile_tuple,
-                              make_tuple_inst);
+  return CanonicalizeTypeImpl(
+      {.kind = SemIR::TupleType::Kind, .elements = type_ids}, make_tuple_inst);
 }
 
 auto Context::GetBuiltinType(SemIR::BuiltinKind kind) -> SemIR::TypeId {
@@ -5,9 +5,8 @@
 #ifndef CARBON_TOOLCHAIN_CHECK_CONTEXT_H_
 #define CARBON_TOOLCHAIN_CHECK_CONTEXT_H_
 
+#include "common/hashing.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/DenseSet.h"
-#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "toolchain/check/decl_name_stack.h"
 #include "toolchain/check/inst_block_stack.h"
@@ -321,17 +320,25 @@ class Context {
   auto constants() -> SemIR::ConstantStore& { return sem_ir().constants(); }
 
  private:
-  // A FoldingSet node for a type.
-  class TypeNode : public llvm::FastFoldingSetNode {
-   public:
-    explicit TypeNode(const llvm::FoldingSetNodeID& node_id,
-                      SemIR::TypeId type_id)
-        : llvm::FastFoldingSetNode(node_id), type_id_(type_id) {}
-
-    auto type_id() -> SemIR::TypeId { return type_id_; }
+  // The identity of a type for canonicalization: its kind and the operands
+  // that distinguish it from other types of the same kind. `fields` and
+  // `elements` refer to existing storage and are compared element-wise.
+  struct TypeKey {
+    SemIR::InstKind kind;
+    int64_t arg0 = 0;
+    int32_t arg1 = 0;
+    llvm::ArrayRef<SemIR::InstId> fields = {};
+    llvm::ArrayRef<SemIR::TypeId> elements = {};
+  };
 
-   private:
-    SemIR::TypeId type_id_;
+  // A slot in the canonical type table. An invalid `type_id` marks an empty
+  // slot.
+  struct CanonicalTypeEntry {
+    // A tag from the type's hash code, separate from the bits that pick its
+    // slot. This rules out most mismatches without looking at the type's
+    // instruction.
+    uint32_t tag = 0;
+    SemIR::TypeId type_id = SemIR::TypeId::Invalid;
   };
 
   // An entry in scope_stack_.
@@ -350,9 +357,10 @@ class Context {
     // The name scope associated with this entry, if any.
     SemIR::NameScopeId scope_id;
 
-    // Names which are registered with name_lookup_, and will need to be
-    // unregistered when the scope ends.
-    llvm::DenseSet<SemIR::NameId> names;
+    // The size of lexical_results_ when this scope was pushed. Results from
+    // that index on are registered with name_lookup_ by this scope, and will
+    // need to be unregistered when the scope ends.
+    int32_t lexical_results_begin;
 
     // Whether a `returned var` was introduced in this scope, and needs to be
     // unregistered when the scope ends.
@@ -367,24 +375,48 @@ class Context {
     SemIR::InstId node_id;
     // The scope in which the node was added.
     ScopeIndex scope_index;
+    // The name that was added to lookup.
+    SemIR::NameId name_id;
+    // The index in lexical_results_ of the result for the same name that this
+    // shadows, or -1 if there is none.
+    int32_t shadowed_index;
   };
 
-  // Forms a canonical type ID for a type. This function is given two
-  // callbacks:
-  //
-  // `profile_type(canonical_id)` is called to build a fingerprint for this
-  // type. The ID should be distinct for all distinct type values with the same
-  // `kind`.
+  // Returns the innermost lexical lookup result for a name, or nullptr if the
+  // name isn't declared in any enclosing lexical scope.
+  auto GetLexicalLookupResult(SemIR::NameId name_id)
+      -> const LexicalLookupResult*;
+
+  // Returns the canonicalization key for a type instruction, or nullopt if the
+  // instruction isn't a supported type, which is presently the case for
+  // compile-time expressions.
+  // TODO: Once support is more complete, in particular ensuring that various
+  // valid compile-time expressions are supported, it may be desirable to switch
+  // the default to a CARBON_FATAL error.
+  auto GetTypeKey(SemIR::Inst inst) -> std::optional<TypeKey>;
+
+  // Computes the hash code of a key in the canonical type table.
+  auto HashTypeKey(const TypeKey& key) -> HashCode;
+
+  // Returns whether the canonical type `type_id` has the given key.
+  auto TypeHasKey(SemIR::TypeId type_id, const TypeKey& key) -> bool;
+
+  // Grows the canonical type table, rehashing its entries.
+  auto GrowCanonicalTypes() -> void;
+
+  // Forms a canonical type ID for the type with the given key.
   //
   // `make_inst()` is called to obtain a `SemIR::InstId` that describes the
   // type. It is only called if the type does not already exist, so can be used
   // to lazily build the `SemIR::Inst`. `make_inst()` is not permitted to
   // directly or indirectly canonicalize any types.
-  auto CanonicalizeTypeImpl(
-      SemIR::InstKind kind,
-      llvm::function_ref<bool(llvm::FoldingSetNodeID& canonical_id)>
-          profile_type,
-      llvm::function_ref<SemIR::InstId()> make_inst) -> SemIR::TypeId;
+  //
+  // If `inst_id` is valid, it's an instruction with this key. A type whose
+  // instruction is `inst_id` matches without comparing keys.
+  auto CanonicalizeTypeImpl(const TypeKey& key,
+                            llvm::function_ref<SemIR::InstId()> make_inst,
+                            SemIR::InstId inst_id = SemIR::InstId::Invalid)
+      -> SemIR::TypeId;
 
   // Forms a canonical type ID for a type. If the type is new, adds the
   // instruction to the current block.
@@ -448,27 +480,31 @@ class Context {
   // The stack used for qualified declaration name construction.
   DeclNameStack decl_name_stack_;
 
-  // Maps identifiers to name lookup results. Values are a stack of name lookup
-  // results in the ancestor scopes. This offers constant-time lookup of names,
-  // regardless of how many scopes exist between the name declaration and
-  // reference. The corresponding scope for each lookup result is tracked, so
-  // that lexical lookup results can be interleaved with lookup results from
-  // non-lexical scopes such as classes.
+  // Maps names to lexical lookup results, indexed by GetNameLookupIndex. Each
+  // value is the index in lexical_results_ of the innermost result for the
+  // name, or -1 if it has none. Because identifier names are dense indexes,
+  // this offers constant-time lookup of names without hashing, regardless of
+  // how many scopes exist between the name declaration and reference. The
+  // corresponding scope for each lookup result is tracked, so that lexical
+  // lookup results can be interleaved with lookup results from non-lexical
+  // scopes such as classes.
   //
-  // Names which no longer have lookup results are erased.
-  llvm::DenseMap<SemIR::NameId, llvm::SmallVector<LexicalLookupResult>>
-      name_lookup_;
-
-  // Cache of the mapping from instructions to types, to avoid recomputing the
-  // folding set ID.
-  llvm::DenseMap<SemIR::InstId, SemIR::TypeId> canonical_types_;
-
-  // Tracks the canonical representation of types that have been defined.
-  llvm::FoldingSet<TypeNode> canonical_type_nodes_;
-
-  // Storage for the nodes in canonical_type_nodes_. This stores in pointers so
-  // that FoldingSet can have stable pointers.
-  llvm::SmallVector<std::unique_ptr<TypeNode>> type_node_storage_;
+  // This grows as needed, so names past its end have no results.
+  llvm::SmallVector<int32_t> name_lookup_;
+
+  // The lexical lookup results in all open scopes, in the order they were
+  // added. Each result links to the result that it shadows. Because scopes
+  // nest, the results of the current scope are always at the end, and popping
+  // a scope truncates this.
+  llvm::SmallVector<LexicalLookupResult> lexical_results_;
+
+  // Tracks the canonical representation of types that have been defined, as
+  // an open-addressing hash table with linear probing. The size is always a
+  // power of two, and is kept at most 3/4 full.
+  llvm::SmallVector<CanonicalTypeEntry> canonical_types_;
+
+  // The number of occupied slots in canonical_types_.
+  int num_canonical_types_ = 0;
 };
 
 // Parse node handlers. Returns false for unrecoverable errors.
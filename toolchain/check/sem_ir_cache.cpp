@@ -0,0 +1,110 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "toolchain/check/sem_ir_cache.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace Carbon::Check {
+
+// The version of checking's results. Bump this whenever a change to checking
+// can produce different SemIR for the same source, so that entries written by
+// earlier toolchains are no longer used.
+static constexpr int CheckVersion = 1;
+
+// Returns a stamp identifying the running toolchain binary: its path, size and
+// modification time. This changes whenever the toolchain is rebuilt, even if
+// the version string and `CheckVersion` weren't updated.
+static auto GetBuildStamp() -> std::string {
+  std::string executable =
+      llvm::sys::fs::getMainExecutable(/*argv0=*/nullptr,
+                                       reinterpret_cast<void*>(&GetBuildStamp));
+  llvm::sys::fs::file_status status;
+  if (executable.empty() || llvm::sys::fs::status(executable, status)) {
+    // Without a stamp, only the versions distinguish toolchains.
+    return "";
+  }
+  return llvm::formatv(
+      "{0}:{1}:{2}", executable, status.getSize(),
+      status.getLastModificationTime().time_since_epoch().count());
+}
+
+SemIRCache::SemIRCache(llvm::StringRef directory,
+                       llvm::StringRef toolchain_version)
+    : directory_(directory),
+      toolchain_version_(llvm::formatv("{0}\ncheck version {1}\n{2}",
+                                       toolchain_version, CheckVersion,
+                                       GetBuildStamp())) {
+  // Errors are ignored here; they'll result in cache misses.
+  (void)llvm::sys::fs::create_directories(directory_);
+}
+
+// Adds a length-prefixed string to the hash, so that adjacent fields can't be
+// confused.
+static auto HashField(llvm::SHA256& hasher, llvm::StringRef field) -> void {
+  uint64_t size = field.size();
+  hasher.update(llvm::ArrayRef(reinterpret_cast<const uint8_t*>(&size),
+                               sizeof(size)));
+  hasher.update(field);
+}
+
+auto SemIRCache::ComputeKey(llvm::StringRef filename,
+                            llvm::StringRef source_text,
+                            llvm::ArrayRef<llvm::StringRef> import_keys) const
+    -> std::string {
+  llvm::SHA256 hasher;
+  HashField(hasher, toolchain_version_);
+  HashField(hasher, filename);
+  HashField(hasher, source_text);
+  for (auto import_key : import_keys) {
+    HashField(hasher, import_key);
+  }
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+auto SemIRCache::GetEntryPath(llvm::StringRef key) const -> std::string {
+  llvm::SmallString<256> path(directory_);
+  llvm::sys::path::append(path, key + ".semir");
+  return path.str().str();
+}
+
+auto SemIRCache::Lookup(llvm::StringRef key) -> std::optional<llvm::StringRef> {
+  // Without a null terminator, large entries are memory-mapped, and
+  // deserialization views them in place.
+  auto buffer = llvm::MemoryBuffer::getFile(GetEntryPath(key),
+                                            /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer) {
+    return std::nullopt;
+  }
+  llvm::StringRef data = (*buffer)->getBuffer();
+  std::lock_guard<std::mutex> lock(mutex_);
+  loaded_entries_.push_back(std::move(*buffer));
+  return data;
+}
+
+auto SemIRCache::Store(llvm::StringRef key, llvm::StringRef data) -> void {
+  // Write to a temporary file and rename it into place.
+  llvm::SmallString<256> model(directory_);
+  llvm::sys::path::append(model, "tmp-%%%%%%%%.semir");
+  auto temp_file = llvm::sys::fs::TempFile::create(model);
+  if (!temp_file) {
+    llvm::consumeError(temp_file.takeError());
+    return;
+  }
+  {
+    llvm::raw_fd_ostream out(temp_file->FD, /*shouldClose=*/false);
+    out << data;
+  }
+  // On failure, `keep` removes the temporary file.
+  llvm::consumeError(temp_file->keep(GetEntryPath(key)));
+}
+
+}  // namespace Carbon::Check
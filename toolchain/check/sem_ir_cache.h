@@ -0,0 +1,64 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_TOOLCHAIN_CHECK_SEM_IR_CACHE_H_
+#define CARBON_TOOLCHAIN_CHECK_SEM_IR_CACHE_H_
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace Carbon::Check {
+
+// A persistent, content-addressed cache of serialized SemIR, stored as one file
+// per entry in a directory. Keys are computed from everything that can affect
+// the result of checking a file, so entries never need to be invalidated.
+//
+// All methods are thread-safe.
+class SemIRCache {
+ public:
+  // `toolchain_version` is mixed into every key, along with a version of
+  // checking's results and a stamp of the running binary, so that different
+  // toolchain builds don't share entries.
+  explicit SemIRCache(llvm::StringRef directory,
+                      llvm::StringRef toolchain_version);
+
+  // Computes the key for a file from its name and source text, and from the
+  // keys of the files it imports, in import order.
+  auto ComputeKey(llvm::StringRef filename, llvm::StringRef source_text,
+                  llvm::ArrayRef<llvm::StringRef> import_keys) const
+      -> std::string;
+
+  // Returns the cached data for a key, or nullopt if there's no entry. The data
+  // remains valid for the lifetime of the cache.
+  auto Lookup(llvm::StringRef key) -> std::optional<llvm::StringRef>;
+
+  // Stores data for a key. Entries are written atomically, so concurrent
+  // compiles sharing a directory never see partial entries. Failures are
+  // ignored, because the cache is only an optimization.
+  auto Store(llvm::StringRef key, llvm::StringRef data) -> void;
+
+ private:
+  // Returns the path of the entry for a key.
+  auto GetEntryPath(llvm::StringRef key) const -> std::string;
+
+  std::string directory_;
+  std::string toolchain_version_;
+
+  // Guards loaded_entries_.
+  std::mutex mutex_;
+  // Entries that have been loaded, kept alive because loaded SemIR refers to
+  // their data.
+  llvm::SmallVector<std::unique_ptr<llvm::MemoryBuffer>> loaded_entries_;
+};
+
+}  // namespace Carbon::Check
+
+#endif  // CARBON_TOOLCHAIN_CHECK_SEM_IR_CACHE_H_
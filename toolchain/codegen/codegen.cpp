@@ -6,23 +6,36 @@
 
 #include <memory>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
 
 namespace Carbon {
 
 auto CodeGen::Create(llvm::Module& module, llvm::StringRef target_triple,
+                     llvm::StringRef cpu, llvm::StringRef features,
+                     OptimizationLevel optimization_level,
                      llvm::raw_pwrite_stream& errors)
     -> std::optional<CodeGen> {
-  // Initialize the target registry etc.
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmParsers();
-  llvm::InitializeAllAsmPrinters();
+  // Initialize the target registry etc. Registration isn't thread-safe, and
+  // the driver may create code generators concurrently, so only do this once.
+  static const bool initialized_targets = [] {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmParsers();
+    llvm::InitializeAllAsmPrinters();
+    return true;
+  }();
+  (void)initialized_targets;
 
   std::string error;
   const llvm::Target* target =
@@ -34,17 +47,105 @@ auto CodeGen::Create(llvm::Module& module, llvm::StringRef target_triple,
   }
   module.setTargetTriple(target_triple);
 
-  constexpr llvm::StringLiteral CPU = "generic";
-  constexpr llvm::StringLiteral Features = "";
+  if (cpu.empty()) {
+    cpu = "generic";
+  }
+
+  // Validate the CPU and features up front. Creating a target machine with
+  // invalid ones would warn directly to stderr and then ignore them.
+  std::unique_ptr<llvm::MCSubtargetInfo> subtarget_info(
+      target->createMCSubtargetInfo(target_triple, /*CPU=*/"",
+                                    /*Features=*/""));
+  if (!subtarget_info->isCPUStringValid(cpu)) {
+    errors << "ERROR: Invalid CPU for target '" << target_triple
+           << "': " << cpu << "\n";
+    return {};
+  }
+  for (const std::string& feature :
+       llvm::SubtargetFeatures(features).getFeatures()) {
+    if (!llvm::SubtargetFeatures::hasFlag(feature)) {
+      errors << "ERROR: Target feature must start with '+' or '-': "
+             << feature << "\n";
+      return {};
+    }
+    llvm::StringRef name = llvm::SubtargetFeatures::StripFlag(feature);
+    if (!llvm::any_of(subtarget_info->getAllProcessorFeatures(),
+                      [&](const llvm::SubtargetFeatureKV& known) {
+                        return name == known.Key;
+                      })) {
+      errors << "ERROR: Invalid feature for target '" << target_triple
+             << "': " << name << "\n";
+      return {};
+    }
+  }
+
+  llvm::CodeGenOptLevel codegen_opt_level;
+  switch (optimization_level) {
+    case OptimizationLevel::O0:
+      codegen_opt_level = llvm::CodeGenOptLevel::None;
+      break;
+    case OptimizationLevel::O1:
+      codegen_opt_level = llvm::CodeGenOptLevel::Less;
+      break;
+    case OptimizationLevel::O2:
+      codegen_opt_level = llvm::CodeGenOptLevel::Default;
+      break;
+    case OptimizationLevel::O3:
+      codegen_opt_level = llvm::CodeGenOptLevel::Aggressive;
+      break;
+  }
 
   llvm::TargetOptions target_opts;
   std::optional<llvm::Reloc::Model> reloc_model;
-  CodeGen codegen(module, errors);
+  CodeGen codegen(module, optimization_level, errors);
   codegen.target_machine_.reset(target->createTargetMachine(
-      target_triple, CPU, Features, target_opts, reloc_model));
+      target_triple, cpu, features, target_opts, reloc_model,
+      /*CM=*/std::nullopt, codegen_opt_level));
+  // The optimization pipeline depends on the data layout, so set it up front.
+  module.setDataLayout(codegen.target_machine_->createDataLayout());
   return codegen;
 }
 
+auto CodeGen::Optimize() -> void {
+  llvm::LoopAnalysisManager loop_analysis_manager;
+  llvm::FunctionAnalysisManager function_analysis_manager;
+  llvm::CGSCCAnalysisManager cgscc_analysis_manager;
+  llvm::ModuleAnalysisManager module_analysis_manager;
+
+  // Passing the target machine provides target-specific cost models.
+  llvm::PassBuilder pass_builder(target_machine_.get());
+  pass_builder.registerModuleAnalyses(module_analysis_manager);
+  pass_builder.registerCGSCCAnalyses(cgscc_analysis_manager);
+  pass_builder.registerFunctionAnalyses(function_analysis_manager);
+  pass_builder.registerLoopAnalyses(loop_analysis_manager);
+  pass_builder.crossRegisterProxies(
+      loop_analysis_manager, function_analysis_manager, cgscc_analysis_manager,
+      module_analysis_manager);
+
+  llvm::OptimizationLevel level;
+  switch (optimization_level_) {
+    case OptimizationLevel::O0:
+      level = llvm::OptimizationLevel::O0;
+      break;
+    case OptimizationLevel::O1:
+      level = llvm::OptimizationLevel::O1;
+      break;
+    case OptimizationLevel::O2:
+      level = llvm::OptimizationLevel::O2;
+      break;
+    case OptimizationLevel::O3:
+      level = llvm::OptimizationLevel::O3;
+      break;
+  }
+  // Like Clang, O0 still runs the few passes needed for correctness, such as
+  // inlining `alwaysinline` functions.
+  llvm::ModulePassManager pass_manager =
+      level == llvm::OptimizationLevel::O0
+          ? pass_builder.buildO0DefaultPipeline(level)
+          : pass_builder.buildPerModuleDefaultPipeline(level);
+  pass_manager.run(module_, module_analysis_manager);
+}
+
 auto CodeGen::EmitAssembly(llvm::raw_pwrite_stream& out) -> bool {
   return EmitCode(out, llvm::CodeGenFileType::AssemblyFile);
 }
@@ -53,10 +154,18 @@ auto CodeGen::EmitObject(llvm::raw_pwrite_stream& out) -> bool {
   return EmitCode(out, llvm::CodeGenFileType::ObjectFile);
 }
 
+auto CodeGen::EmitAssemblies(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs)
+    -> bool {
+  return EmitSplitCode(outs, llvm::CodeGenFileType::AssemblyFile);
+}
+
+auto CodeGen::EmitObjects(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs)
+    -> bool {
+  return EmitSplitCode(outs, llvm::CodeGenFileType::ObjectFile);
+}
+
 auto CodeGen::EmitCode(llvm::raw_pwrite_stream& out,
                        llvm::CodeGenFileType file_type) -> bool {
-  module_.setDataLayout(target_machine_->createDataLayout());
-
   // Using the legacy PM to generate the assembly since the new PM
   // does not work with this yet.
   // TODO: make the new PM work with the codegen pipeline.
@@ -71,4 +180,35 @@ auto CodeGen::EmitCode(llvm::raw_pwrite_stream& out,
   return true;
 }
 
+auto CodeGen::EmitSplitCode(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs,
+                            llvm::CodeGenFileType file_type) -> bool {
+  // Code generation for the partitions treats failing to add passes as fatal,
+  // so check for that first.
+  llvm::legacy::PassManager check_pass;
+  llvm::raw_null_ostream null_out;
+  // Note that this returns true on an error.
+  if (target_machine_->addPassesToEmitFile(check_pass, null_out, nullptr,
+                                           file_type)) {
+    errors_ << "ERROR: Unable to emit to this file.\n";
+    return false;
+  }
+
+  // Each partition is generated on its own thread, with its own target
+  // machine.
+  const llvm::TargetMachine& target_machine = *target_machine_;
+  llvm::splitCodeGen(
+      module_, outs, /*BCOSs=*/{},
+      [&]() {
+        return std::unique_ptr<llvm::TargetMachine>(
+            target_machine.getTarget().createTargetMachine(
+                target_machine.getTargetTriple().str(),
+                target_machine.getTargetCPU(),
+                target_machine.getTargetFeatureString(),
+                target_machine.Options, target_machine.getRelocationModel(),
+                target_machine.getCodeModel(), target_machine.getOptLevel()));
+      },
+      file_type);
+  return true;
+}
+
 }  // namespace Carbon
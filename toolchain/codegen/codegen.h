@@ -5,6 +5,9 @@
 #ifndef CARBON_TOOLCHAIN_CODEGEN_CODEGEN_H_
 #define CARBON_TOOLCHAIN_CODEGEN_CODEGEN_H_
 
+#include <cstdint>
+
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Target/TargetMachine.h"
 
@@ -12,9 +15,27 @@ namespace Carbon {
 
 class CodeGen {
  public:
+  // The level of optimization for both the IR optimization pipeline and code
+  // generation, corresponding to Clang's `-O0` through `-O3`.
+  enum class OptimizationLevel : int8_t {
+    O0,
+    O1,
+    O2,
+    O3,
+  };
+
+  // Creates a code generator for the target. An empty CPU selects the
+  // target's generic CPU, and features are an LLVM feature string such as
+  // `+avx2,-bmi`.
   static auto Create(llvm::Module& module, llvm::StringRef target_triple,
+                     llvm::StringRef cpu, llvm::StringRef features,
+                     OptimizationLevel optimization_level,
                      llvm::raw_pwrite_stream& errors) -> std::optional<CodeGen>;
 
+  // Runs the IR optimization pipeline for the optimization level over the
+  // module. This should be run at most once, before emitting code.
+  auto Optimize() -> void;
+
   // Generates the object code file.
   // Returns false in case of failure, and any information about the failure is
   // printed to the error stream.
@@ -31,9 +52,24 @@ class CodeGen {
   // patching the output.
   auto EmitAssembly(llvm::raw_pwrite_stream& out) -> bool;
 
+  // Generates object code with the module split into one partition per output
+  // stream, generating code for the partitions in parallel. Each partition is
+  // a separate object file, and all of them are needed to link the module.
+  // The module is modified by splitting, so this must be the last use of it.
+  // Returns false in case of failure, and any information about the failure is
+  // printed to the error stream.
+  auto EmitObjects(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs) -> bool;
+
+  // As with `EmitObjects`, but generates a textual assembly file for each
+  // partition.
+  auto EmitAssemblies(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs) -> bool;
+
  private:
-  explicit CodeGen(llvm::Module& module, llvm::raw_pwrite_stream& errors)
-      : module_(module), errors_(errors) {}
+  explicit CodeGen(llvm::Module& module, OptimizationLevel optimization_level,
+                   llvm::raw_pwrite_stream& errors)
+      : module_(module),
+        optimization_level_(optimization_level),
+        errors_(errors) {}
 
   // Using the llvm pass emits either assembly or object code to dest.
   // Returns false in case of failure, and any information about the failure is
@@ -41,7 +77,14 @@ class CodeGen {
   auto EmitCode(llvm::raw_pwrite_stream& out, llvm::CodeGenFileType file_type)
       -> bool;
 
+  // Splits the module and emits either assembly or object code for each
+  // partition. Returns false in case of failure, and any information about the
+  // failure is printed to the error stream.
+  auto EmitSplitCode(llvm::ArrayRef<llvm::raw_pwrite_stream*> outs,
+                     llvm::CodeGenFileType file_type) -> bool;
+
   llvm::Module& module_;
+  OptimizationLevel optimization_level_;
   llvm::raw_pwrite_stream& errors_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
 };
@@ -4,20 +4,30 @@
 
 #include "toolchain/driver/driver.h"
 
+#include <algorithm>
 #include <memory>
 #include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
 
 #include "common/command_line.h"
 #include "common/vlog.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/TargetParser/Host.h"
+#include "toolchain/base/time_trace.h"
 #include "toolchain/base/value_store.h"
 #include "toolchain/check/check.h"
+#include "toolchain/check/sem_ir_cache.h"
 #include "toolchain/codegen/codegen.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/diagnostics/sorting_diagnostic_consumer.h"
@@ -25,6 +35,7 @@
 #include "toolchain/lower/lower.h"
 #include "toolchain/parse/tree.h"
 #include "toolchain/sem_ir/formatter.h"
+#include "toolchain/sem_ir/serialize.h"
 #include "toolchain/source/source_buffer.h"
 
 namespace Carbon {
@@ -146,6 +157,53 @@ https://clang.llvm.org/docs/CrossCompilation.html#target-triple
           arg_b.Set(&target);
         });
 
+    b.AddStringOption(
+        {
+            .name = "target-cpu",
+            .value_name = "CPU",
+            .help = R"""(
+Select the CPU to generate code for, using LLVM's CPU names such as
+`skylake-avx512`. Passing `native` selects the host's CPU along with all of the
+features it supports, and requires the target to be the host.
+
+The default is a generic CPU for the target.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&target_cpu); });
+
+    b.AddStringOption(
+        {
+            .name = "target-features",
+            .value_name = "FEATURES",
+            .help = R"""(
+Enable or disable target features, as a comma-separated list of LLVM features
+each prefixed with `+` or `-`, such as `+avx2,-bmi2`. These are applied after
+the features of the CPU selected by `--target-cpu`.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&target_features); });
+
+    b.AddOneOfOption(
+        {
+            .name = "optimize",
+            .help = R"""(
+Selects the optimization level, corresponding to Clang's `-O` flags. The LLVM
+IR optimization pipeline for the level runs between lowering and codegen, and
+codegen optimizes to the same level. The default is no optimization.
+)""",
+        },
+        [&](auto& arg_b) {
+          arg_b.SetOneOf(
+              {
+                  arg_b.OneOfValue("0", CodeGen::OptimizationLevel::O0)
+                      .Default(true),
+                  arg_b.OneOfValue("1", CodeGen::OptimizationLevel::O1),
+                  arg_b.OneOfValue("2", CodeGen::OptimizationLevel::O2),
+                  arg_b.OneOfValue("3", CodeGen::OptimizationLevel::O3),
+              },
+              &optimize);
+        });
+
     b.AddFlag(
         {
             .name = "asm-output",
@@ -181,6 +239,87 @@ and displaying them in source order.
         },
         [&](auto& arg_b) { arg_b.Set(&stream_errors); });
 
+    b.AddIntegerOption(
+        {
+            .name = "jobs",
+            .short_name = "j",
+            .value_name = "N",
+            .help = R"""(
+The number of threads to use when running per-file compilation phases, such as
+lexing, parsing, lowering, and codegen. Jobs left over when there are fewer
+files are split between the files: large files are split into regions that are
+lexed in parallel, and files with many functions have their functions lowered
+in parallel. The default is to run on a single thread.
+
+When more than one job is used, output and diagnostics for each file are
+buffered and written in the order files were provided on the command line.
+)""",
+        },
+        [&](auto& arg_b) {
+          arg_b.Default(1);
+          arg_b.Set(&jobs);
+        });
+
+    b.AddIntegerOption(
+        {
+            .name = "codegen-threads",
+            .value_name = "N",
+            .help = R"""(
+The number of threads to use for code generation of each file. When this is
+more than one, the module is split into that many partitions, whose code is
+generated in parallel, and each partition is written to a separate output. The
+first is written to the output file and the rest are numbered, so `out.o` is
+followed by `out.1.o`, `out.2.o`, and so on. All of them are needed to link.
+
+When writing assembly to stdout, the partitions are written in order. Object
+output to stdout can't be split.
+)""",
+        },
+        [&](auto& arg_b) {
+          arg_b.Default(1);
+          arg_b.Set(&codegen_threads);
+        });
+
+    b.AddStringOption(
+        {
+            .name = "sem-ir-cache-dir",
+            .value_name = "DIR",
+            .help = R"""(
+A directory for caching checked SemIR between compiles.
+
+Files whose source and imports haven't changed since they were cached are loaded
+from the cache rather than checked again. Files with any diagnostics are never
+cached. The directory is created if it doesn't exist, and can be shared by
+concurrent compiles.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&sem_ir_cache_dir); });
+
+    b.AddStringOption(
+        {
+            .name = "time-trace",
+            .value_name = "FILE",
+            .help = R"""(
+Write the time and memory used by each phase of compiling each file to FILE, in
+the Chrome trace event format. `-` writes to stdout.
+
+The trace can be viewed with `chrome://tracing` or Perfetto. Each phase records
+counts of what it produced, such as tokens, parse nodes, or instructions.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&time_trace_file); });
+
+    b.AddStringOption(
+        {
+            .name = "time-trace-summary",
+            .value_name = "FILE",
+            .help = R"""(
+Write a YAML summary of the time and memory used by each phase of compiling each
+file to FILE. `-` writes to stdout.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&time_trace_summary_file); });
+
     b.AddFlag(
         {
             .name = "dump-shared-values",
@@ -230,6 +369,18 @@ Dump the SemIR to stdout when built.
 )""",
         },
         [&](auto& arg_b) { arg_b.Set(&dump_sem_ir); });
+    b.AddFlag(
+        {
+            .name = "dump-binary-sem-ir",
+            .help = R"""(
+Dump the SemIR to stdout in its binary form when built.
+
+The binary form is intended for tools; it's the format used by
+`--sem-ir-cache-dir`. Each file's SemIR is self-delimiting, so the output for
+several files can be split apart.
+)""",
+        },
+        [&](auto& arg_b) { arg_b.Set(&dump_binary_sem_ir); });
     b.AddFlag(
         {
             .name = "builtin-sem-ir",
@@ -260,10 +411,19 @@ Dump the generated assembly to stdout after codegen.
 
   std::string host = llvm::sys::getDefaultTargetTriple();
   llvm::StringRef target;
+  llvm::StringRef target_cpu;
+  llvm::StringRef target_features;
+  CodeGen::OptimizationLevel optimize;
 
   llvm::StringRef output_file_name;
   llvm::SmallVector<llvm::StringRef> input_file_names;
 
+  int jobs = 1;
+  int codegen_threads = 1;
+  llvm::StringRef sem_ir_cache_dir;
+  llvm::StringRef time_trace_file;
+  llvm::StringRef time_trace_summary_file;
+
   bool asm_output = false;
   bool force_obj_output = false;
   bool dump_shared_values = false;
@@ -271,6 +431,7 @@ Dump the generated assembly to stdout after codegen.
   bool dump_parse_tree = false;
   bool dump_raw_sem_ir = false;
   bool dump_sem_ir = false;
+  bool dump_binary_sem_ir = false;
   bool dump_llvm_ir = false;
   bool dump_asm = false;
   bool stream_errors = false;
@@ -356,6 +517,24 @@ auto Driver::RunCommand(llvm::ArrayRef<llvm::StringRef> args) -> bool {
 
 auto Driver::ValidateCompileOptions(const CompileOptions& options) const
     -> bool {
+  if (options.jobs < 1) {
+    error_stream_ << "ERROR: The number of jobs must be at least 1, but was "
+                  << options.jobs << ".\n";
+    return false;
+  }
+  if (options.codegen_threads < 1) {
+    error_stream_ << "ERROR: The number of codegen threads must be at least 1, "
+                     "but was "
+                  << options.codegen_threads << ".\n";
+    return false;
+  }
+  if (options.target_cpu == "native" && options.target != options.host) {
+    error_stream_ << "ERROR: `--target-cpu=native` requires the target to be "
+                     "the host, '"
+                  << options.host << "'.\n";
+    return false;
+  }
+
   using Phase = CompileOptions::Phase;
   switch (options.phase) {
     case Phase::Lex:
@@ -367,7 +546,7 @@ auto Driver::ValidateCompileOptions(const CompileOptions& options) const
       }
       [[clang::fallthrough]];
     case Phase::Parse:
-      if (options.dump_sem_ir) {
+      if (options.dump_sem_ir || options.dump_binary_sem_ir) {
         error_stream_ << "ERROR: Requested dumping the SemIR but compile phase "
                          "is limited to '"
                       << options.phase << "'.\n";
@@ -390,16 +569,54 @@ auto Driver::ValidateCompileOptions(const CompileOptions& options) const
   return true;
 }
 
+// Returns the target CPU and features to compile for. A CPU of `native` is
+// resolved to the host's CPU and the features it supports, and requested
+// features are applied after the host's.
+static auto GetTargetCpuAndFeatures(llvm::StringRef cpu,
+                                    llvm::StringRef features)
+    -> std::pair<std::string, std::string> {
+  if (cpu != "native") {
+    return {cpu.str(), features.str()};
+  }
+  llvm::SmallVector<std::string> all_features;
+  llvm::StringMap<bool> host_features;
+  if (llvm::sys::getHostCPUFeatures(host_features)) {
+    for (const auto& feature : host_features) {
+      all_features.push_back((feature.second ? "+" : "-") +
+                             feature.first().str());
+    }
+    // Sort for deterministic output.
+    llvm::sort(all_features);
+  }
+  if (!features.empty()) {
+    all_features.push_back(features.str());
+  }
+  return {llvm::sys::getHostCPUName().str(), llvm::join(all_features, ",")};
+}
+
 // Ties together information for a file being compiled.
 class Driver::CompilationUnit {
  public:
   explicit CompilationUnit(Driver* driver, const CompileOptions& options,
-                           llvm::StringRef input_file_name)
+                           llvm::StringRef input_file_name,
+                           ValueStore<StringId>* strings, int max_threads,
+                           TimeTrace* time_trace)
       : driver_(driver),
+        value_stores_(strings),
         options_(options),
         input_file_name_(input_file_name),
-        vlog_stream_(driver_->vlog_stream_),
-        stream_consumer_(driver_->error_stream_) {
+        max_threads_(max_threads),
+        time_trace_(time_trace),
+        buffered_output_stream_(buffered_output_),
+        buffered_error_stream_(buffered_errors_),
+        output_stream_(options_.jobs > 1 ? buffered_output_stream_
+                                         : driver_->output_stream_),
+        error_stream_(options_.jobs > 1 ? buffered_error_stream_
+                                        : driver_->error_stream_),
+        vlog_stream_(driver_->vlog_stream_ && options_.jobs > 1
+                         ? &error_stream_
+                         : driver_->vlog_stream_),
+        stream_consumer_(error_stream_) {
     if (vlog_stream_ != nullptr || options_.stream_errors) {
       consumer_ = &stream_consumer_;
     } else {
@@ -410,13 +627,16 @@ class Driver::CompilationUnit {
 
   // Loads source and lexes it. Returns true on success.
   auto RunLex() -> bool {
-    LogCall("SourceBuffer::CreateFromFile", [&] {
+    LogCall("SourceBuffer::CreateFromFile", [&](TimeTrace::Scope& scope) {
       if (input_file_name_ == "-") {
         source_ = SourceBuffer::CreateFromStdin(*consumer_);
       } else {
         source_ = SourceBuffer::CreateFromFile(driver_->fs_, input_file_name_,
                                                *consumer_);
       }
+      if (source_) {
+        scope.AddCount("bytes", source_->text().size());
+      }
     });
     if (!source_) {
       return false;
@@ -424,11 +644,14 @@ class Driver::CompilationUnit {
     CARBON_VLOG() << "*** SourceBuffer ***\n```\n"
                   << source_->text() << "\n```\n";
 
-    LogCall("Lex::Lex",
-            [&] { tokens_ = Lex::Lex(value_stores_, *source_, *consumer_); });
+    LogCall("Lex::Lex", [&](TimeTrace::Scope& scope) {
+      tokens_ = Lex::Lex(value_stores_, *source_, *consumer_,
+                         {.max_threads = max_threads_});
+      scope.AddCount("tokens", tokens_->size());
+    });
     if (options_.dump_tokens) {
       consumer_->Flush();
-      driver_->output_stream_ << tokens_;
+      output_stream_ << tokens_;
     }
     CARBON_VLOG() << "*** Lex::TokenizedBuffer ***\n" << tokens_;
     return !tokens_->has_errors();
@@ -438,12 +661,13 @@ class Driver::CompilationUnit {
   auto RunParse() -> bool {
     CARBON_CHECK(tokens_);
 
-    LogCall("Parse::Tree::Parse", [&] {
+    LogCall("Parse::Tree::Parse", [&](TimeTrace::Scope& scope) {
       parse_tree_ = Parse::Tree::Parse(*tokens_, *consumer_, vlog_stream_);
+      scope.AddCount("nodes", parse_tree_->size());
     });
     if (options_.dump_parse_tree) {
       consumer_->Flush();
-      parse_tree_->Print(driver_->output_stream_, options_.preorder_parse_tree);
+      parse_tree_->Print(output_stream_, options_.preorder_parse_tree);
     }
     CARBON_VLOG() << "*** Parse::Tree ***\n" << parse_tree_;
     return !parse_tree_->has_errors();
@@ -470,9 +694,9 @@ class Driver::CompilationUnit {
 
     CARBON_VLOG() << "*** Raw SemIR::File ***\n" << *sem_ir_ << "\n";
     if (options_.dump_raw_sem_ir) {
-      sem_ir_->Print(driver_->output_stream_, options_.builtin_sem_ir);
+      sem_ir_->Print(output_stream_, options_.builtin_sem_ir);
       if (options_.dump_sem_ir) {
-        driver_->output_stream_ << "\n";
+        output_stream_ << "\n";
       }
     }
 
@@ -482,7 +706,10 @@ class Driver::CompilationUnit {
     }
     if (options_.dump_sem_ir) {
       SemIR::FormatFile(*tokens_, *parse_tree_, *sem_ir_,
-                        driver_->output_stream_);
+                        output_stream_);
+    }
+    if (options_.dump_binary_sem_ir) {
+      SemIR::SerializeFile(*sem_ir_, output_stream_);
     }
     return !sem_ir_->has_errors();
   }
@@ -491,10 +718,15 @@ class Driver::CompilationUnit {
   auto RunLower() -> void {
     CARBON_CHECK(sem_ir_);
 
-    LogCall("Lower::LowerToLLVM", [&] {
+    std::tie(target_cpu_, target_features_) = GetTargetCpuAndFeatures(
+        options_.target_cpu, options_.target_features);
+    LogCall("Lower::LowerToLLVM", [&](TimeTrace::Scope& scope) {
       llvm_context_ = std::make_unique<llvm::LLVMContext>();
       module_ = Lower::LowerToLLVM(*llvm_context_, input_file_name_, *sem_ir_,
-                                   vlog_stream_);
+                                   target_cpu_, target_features_, vlog_stream_,
+                                   {.max_threads = max_threads_});
+      scope.AddCount("functions", module_->size());
+      scope.AddCount("instructions", module_->getInstructionCount());
     });
     if (vlog_stream_) {
       CARBON_VLOG() << "*** llvm::Module ***\n";
@@ -503,7 +735,7 @@ class Driver::CompilationUnit {
                      /*IsForDebug=*/true);
     }
     if (options_.dump_llvm_ir) {
-      module_->print(driver_->output_stream_, /*AAW=*/nullptr,
+      module_->print(output_stream_, /*AAW=*/nullptr,
                      /*ShouldPreserveUseListOrder=*/true);
     }
   }
@@ -512,36 +744,64 @@ class Driver::CompilationUnit {
   auto RunCodeGen() -> bool {
     CARBON_CHECK(module_);
 
+    TimeTrace::Scope trace_scope(time_trace_, input_file_name_, "CodeGen");
     CARBON_VLOG() << "*** CodeGen ***\n";
     std::optional<CodeGen> codegen =
-        CodeGen::Create(*module_, options_.target, driver_->error_stream_);
+        CodeGen::Create(*module_, options_.target, target_cpu_,
+                        target_features_, options_.optimize, error_stream_);
     if (!codegen) {
       return false;
     }
+    codegen->Optimize();
+    if (vlog_stream_) {
+      CARBON_VLOG() << "*** Optimized llvm::Module ***\n";
+      module_->print(*vlog_stream_, /*AAW=*/nullptr,
+                     /*ShouldPreserveUseListOrder=*/false,
+                     /*IsForDebug=*/true);
+    }
     if (vlog_stream_) {
       CARBON_VLOG() << "*** Assembly ***\n";
       codegen->EmitAssembly(*vlog_stream_);
     }
 
+    int num_partitions = options_.codegen_threads;
     if (options_.output_file_name == "-") {
       // TODO: the output file name, forcing object output, and requesting
       // textual assembly output are all somewhat linked flags. We should add
       // some validation that they are used correctly.
-      if (options_.force_obj_output) {
-        if (!codegen->EmitObject(driver_->output_stream_)) {
+      if (num_partitions == 1) {
+        if (!EmitCode(*codegen, {&output_stream_},
+                      /*asm_output=*/!options_.force_obj_output)) {
           return false;
         }
+      } else if (options_.force_obj_output) {
+        error_stream_ << "ERROR: Object output to stdout can't be split for "
+                         "`--codegen-threads`.\n";
+        return false;
       } else {
-        if (!codegen->EmitAssembly(driver_->output_stream_)) {
+        // Partitions are generated concurrently, so buffer them and write
+        // their assembly in order.
+        llvm::SmallVector<llvm::SmallString<0>> buffers(num_partitions);
+        llvm::SmallVector<std::unique_ptr<llvm::raw_svector_ostream>> streams;
+        llvm::SmallVector<llvm::raw_pwrite_stream*> outs;
+        for (auto& buffer : buffers) {
+          streams.push_back(
+              std::make_unique<llvm::raw_svector_ostream>(buffer));
+          outs.push_back(streams.back().get());
+        }
+        if (!EmitCode(*codegen, outs, /*asm_output=*/true)) {
           return false;
         }
+        for (const auto& buffer : buffers) {
+          output_stream_ << buffer;
+        }
       }
     } else {
       llvm::SmallString<256> output_file_name = options_.output_file_name;
       if (output_file_name.empty()) {
         if (!source_->is_regular_file()) {
           // Don't invent file names like `-.o` or `/dev/stdin.o`.
-          driver_->error_stream_
+          error_stream_
               << "ERROR: Output file name must be specified for input '"
               << input_file_name_ << "' that is not a regular file.\n";
           return false;
@@ -556,33 +816,68 @@ class Driver::CompilationUnit {
         // Currently each unit overwrites the output from the previous one in
         // this case.
       }
-      CARBON_VLOG() << "Writing output to: " << output_file_name << "\n";
-
-      std::error_code ec;
-      llvm::raw_fd_ostream output_file(output_file_name, ec,
-                                       llvm::sys::fs::OF_None);
-      if (ec) {
-        driver_->error_stream_ << "ERROR: Could not open output file '"
-                               << output_file_name << "': " << ec.message()
-                               << "\n";
-        return false;
-      }
-      if (options_.asm_output) {
-        if (!codegen->EmitAssembly(output_file)) {
-          return false;
+
+      // With multiple partitions, the first is written to the output file and
+      // the rest are numbered, so `out.o` is followed by `out.1.o`.
+      llvm::SmallVector<std::unique_ptr<llvm::raw_fd_ostream>> output_files;
+      llvm::SmallVector<llvm::raw_pwrite_stream*> outs;
+      for (int partition : llvm::seq(num_partitions)) {
+        llvm::SmallString<256> partition_file_name = output_file_name;
+        if (partition > 0) {
+          llvm::StringRef extension =
+              llvm::sys::path::extension(output_file_name);
+          llvm::sys::path::replace_extension(
+              partition_file_name,
+              llvm::Twine(".") + llvm::Twine(partition) + extension);
         }
-      } else {
-        if (!codegen->EmitObject(output_file)) {
+        CARBON_VLOG() << "Writing output to: " << partition_file_name << "\n";
+
+        std::error_code ec;
+        output_files.push_back(std::make_unique<llvm::raw_fd_ostream>(
+            partition_file_name, ec, llvm::sys::fs::OF_None));
+        if (ec) {
+          error_stream_ << "ERROR: Could not open output file '"
+                        << partition_file_name << "': " << ec.message()
+                        << "\n";
           return false;
         }
+        outs.push_back(output_files.back().get());
+      }
+      if (!EmitCode(*codegen, outs, options_.asm_output)) {
+        return false;
       }
     }
     CARBON_VLOG() << "*** CodeGen done ***\n";
     return true;
   }
 
-  // Flushes output.
-  auto Flush() -> void { consumer_->Flush(); }
+  // Emits assembly or object code to the streams, with the module split into
+  // one partition per stream when there's more than one.
+  static auto EmitCode(CodeGen& codegen,
+                       llvm::ArrayRef<llvm::raw_pwrite_stream*> outs,
+                       bool asm_output) -> bool {
+    if (outs.size() == 1) {
+      return asm_output ? codegen.EmitAssembly(*outs.front())
+                        : codegen.EmitObject(*outs.front());
+    }
+    return asm_output ? codegen.EmitAssemblies(outs)
+                      : codegen.EmitObjects(outs);
+  }
+
+  // Flushes diagnostics and any buffered output.
+  auto Flush() -> void {
+    consumer_->Flush();
+    FlushBufferedOutput();
+  }
+
+  // Writes output that was buffered while running on a thread pool to the
+  // driver's streams. This is a no-op when output isn't buffered.
+  auto FlushBufferedOutput() -> void {
+    driver_->output_stream_ << buffered_output_;
+    buffered_output_.clear();
+    driver_->error_stream_ << buffered_errors_;
+    buffered_errors_.clear();
+  }
 
   auto PrintSharedValues() const -> void {
     Yaml::Print(driver_->output_stream_,
@@ -592,11 +887,15 @@ class Driver::CompilationUnit {
   auto has_source() -> bool { return source_.has_value(); }
 
  private:
-  // Wraps a call with log statements to indicate start and end.
-  auto LogCall(llvm::StringLiteral label, llvm::function_ref<void()> fn)
-      -> void {
+  // Wraps a call with log statements to indicate start and end, and records
+  // it in the time trace.
+  auto LogCall(llvm::StringLiteral label,
+               llvm::function_ref<void(TimeTrace::Scope&)> fn) -> void {
     CARBON_VLOG() << "*** " << label << ": " << input_file_name_ << " ***\n";
-    fn();
+    {
+      TimeTrace::Scope scope(time_trace_, input_file_name_, label);
+      fn(scope);
+    }
     CARBON_VLOG() << "*** " << label << " done ***\n";
   }
 
@@ -604,8 +903,24 @@ class Driver::CompilationUnit {
   SharedValueStores value_stores_;
   const CompileOptions& options_;
   llvm::StringRef input_file_name_;
-
-  // Copied from driver_ for CARBON_VLOG.
+  // The most threads to use within this unit, such as for lexing a file or
+  // lowering its functions on several threads.
+  int max_threads_;
+  TimeTrace* time_trace_;
+
+  // When running with multiple jobs, output is buffered here so that it can be
+  // written in argument order.
+  llvm::SmallString<0> buffered_output_;
+  llvm::SmallString<0> buffered_errors_;
+  llvm::raw_svector_ostream buffered_output_stream_;
+  llvm::raw_svector_ostream buffered_error_stream_;
+
+  // Either the driver's streams, or the buffered streams above.
+  llvm::raw_pwrite_stream& output_stream_;
+  llvm::raw_pwrite_stream& error_stream_;
+
+  // Copied from driver_ for CARBON_VLOG, redirected to error_stream_ when
+  // buffering.
   llvm::raw_pwrite_stream* vlog_stream_;
 
   // Diagnostics are sent to consumer_, with optional sorting.
@@ -620,6 +935,10 @@ class Driver::CompilationUnit {
   std::optional<SemIR::File> sem_ir_;
   std::unique_ptr<llvm::LLVMContext> llvm_context_;
   std::unique_ptr<llvm::Module> module_;
+
+  // The resolved target CPU and features, set when lowering.
+  std::string target_cpu_;
+  std::string target_features_;
 };
 
 auto Driver::Compile(const CompileOptions& options) -> bool {
@@ -627,6 +946,58 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
     return false;
   }
 
+  if (options.time_trace_file.empty() &&
+      options.time_trace_summary_file.empty()) {
+    return CompileUnits(options, /*time_trace=*/nullptr);
+  }
+
+  TimeTrace time_trace;
+  bool success = CompileUnits(options, &time_trace);
+
+  // Writes a report to a file, or to stdout for `-`.
+  auto write_report =
+      [&](llvm::StringRef file_name,
+          llvm::function_ref<auto(llvm::raw_ostream&)->void> print) -> bool {
+    if (file_name.empty()) {
+      return true;
+    }
+    if (file_name == "-") {
+      print(output_stream_);
+      return true;
+    }
+    std::error_code ec;
+    llvm::raw_fd_ostream out(file_name, ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+      error_stream_ << "ERROR: Could not open time trace file '" << file_name
+                    << "': " << ec.message() << "\n";
+      return false;
+    }
+    print(out);
+    return true;
+  };
+  success &= write_report(options.time_trace_file, [&](llvm::raw_ostream& out) {
+    time_trace.PrintChromeTrace(out);
+  });
+  success &= write_report(
+      options.time_trace_summary_file,
+      [&](llvm::raw_ostream& out) { time_trace.PrintSummary(out); });
+  return success;
+}
+
+auto Driver::CompileUnits(const CompileOptions& options, TimeTrace* time_trace)
+    -> bool {
+  // The cache must outlive the units, because SemIR loaded from it refers to
+  // its data.
+  std::optional<Check::SemIRCache> sem_ir_cache;
+  if (!options.sem_ir_cache_dir.empty()) {
+    sem_ir_cache.emplace(options.sem_ir_cache_dir, Options::Info.version);
+  }
+
+  // Strings are interned once for all units, so that identical identifiers
+  // have the same ID in every file. Adding only locks with multiple jobs, in
+  // which case IDs depend on how units are scheduled.
+  ValueStore<StringId> strings(/*thread_safe=*/options.jobs > 1);
+
   llvm::SmallVector<std::unique_ptr<CompilationUnit>> units;
   auto flush = llvm::make_scope_exit([&]() {
     // The diagnostics consumer must be flushed before compilation artifacts are
@@ -644,16 +1015,51 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
       }
     }
   });
+  // Units run concurrently on the pool below, so they split the jobs between
+  // them rather than each starting a pool of `--jobs` threads.
+  int max_threads_per_unit = std::max<int>(
+      1, options.jobs / std::max<int>(1, options.input_file_names.size()));
   for (const auto& input_file_name : options.input_file_names) {
-    units.push_back(
-        std::make_unique<CompilationUnit>(this, options, input_file_name));
+    units.push_back(std::make_unique<CompilationUnit>(
+        this, options, input_file_name, &strings, max_threads_per_unit,
+        time_trace));
   }
 
-  // Lex.
-  bool success_before_lower = true;
-  for (auto& unit : units) {
-    success_before_lower &= unit->RunLex();
+  // Runs a phase over every unit, returning true if it succeeded for all of
+  // them. With multiple jobs, units run concurrently on a thread pool, and
+  // their buffered output is written afterwards in argument order.
+  std::optional<llvm::ThreadPool> pool;
+  if (options.jobs > 1) {
+    pool.emplace(llvm::hardware_concurrency(options.jobs));
   }
+  auto run_phase =
+      [&](llvm::function_ref<auto(CompilationUnit&)->bool> run) -> bool {
+    bool success = true;
+    if (!pool) {
+      for (auto& unit : units) {
+        success &= run(*unit);
+      }
+      return success;
+    }
+    // Avoid `std::vector<bool>` because elements are written from different
+    // threads.
+    llvm::SmallVector<char> results(units.size(), true);
+    for (auto [unit, result] : llvm::zip(units, results)) {
+      pool->async([&run, &unit_ref = *unit, &result_ref = result] {
+        result_ref = run(unit_ref);
+      });
+    }
+    pool->wait();
+    for (auto [unit, result] : llvm::zip(units, results)) {
+      unit->FlushBufferedOutput();
+      success &= static_cast<bool>(result);
+    }
+    return success;
+  };
+
+  // Lex.
+  bool success_before_lower =
+      run_phase([](CompilationUnit& unit) { return unit.RunLex(); });
   if (options.phase == CompileOptions::Phase::Lex) {
     return success_before_lower;
   }
@@ -662,11 +1068,9 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
   // anything failed, so don't need this.
 
   // Parse.
-  for (auto& unit : units) {
-    if (unit->has_source()) {
-      success_before_lower &= unit->RunParse();
-    }
-  }
+  success_before_lower &= run_phase([](CompilationUnit& unit) {
+    return !unit.has_source() || unit.RunParse();
+  });
   if (options.phase == CompileOptions::Phase::Parse) {
     return success_before_lower;
   }
@@ -682,13 +1086,13 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
   }
   CARBON_VLOG() << "*** Check::CheckParseTrees ***\n";
   Check::CheckParseTrees(builtins, llvm::MutableArrayRef(check_units),
+                         pool ? &*pool : nullptr,
+                         sem_ir_cache ? &*sem_ir_cache : nullptr, time_trace,
                          vlog_stream_);
   CARBON_VLOG() << "*** Check::CheckParseTrees done ***\n";
-  for (auto& unit : units) {
-    if (unit->has_source()) {
-      success_before_lower &= unit->PostCheck();
-    }
-  }
+  success_before_lower &= run_phase([](CompilationUnit& unit) {
+    return !unit.has_source() || unit.PostCheck();
+  });
   if (options.phase == CompileOptions::Phase::Check) {
     return success_before_lower;
   }
@@ -700,9 +1104,10 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
   }
 
   // Lower.
-  for (auto& unit : units) {
-    unit->RunLower();
-  }
+  run_phase([](CompilationUnit& unit) {
+    unit.RunLower();
+    return true;
+  });
   if (options.phase == CompileOptions::Phase::Lower) {
     return true;
   }
@@ -710,11 +1115,7 @@ auto Driver::Compile(const CompileOptions& options) -> bool {
       << "CodeGen should be the last stage";
 
   // Codegen.
-  bool codegen_success = true;
-  for (auto& unit : units) {
-    codegen_success &= unit->RunCodeGen();
-  }
-  return codegen_success;
+  return run_phase([](CompilationUnit& unit) { return unit.RunCodeGen(); });
 }
 
 }  // namespace Carbon
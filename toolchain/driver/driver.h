@@ -13,6 +13,8 @@
 
 namespace Carbon {
 
+class TimeTrace;
+
 // Command line interface driver.
 //
 // Provides simple API to parse and run command lines for Carbon.  It is
@@ -53,6 +55,11 @@ class Driver {
   // Implements the compile subcommand of the driver.
   auto Compile(const CompileOptions& options) -> bool;
 
+  // Compiles the input files of the compile subcommand, after options are
+  // validated. Phases are recorded in `time_trace` when it's non-null.
+  auto CompileUnits(const CompileOptions& options, TimeTrace* time_trace)
+      -> bool;
+
   llvm::vfs::FileSystem& fs_;
   llvm::raw_pwrite_stream& output_stream_;
   llvm::raw_pwrite_stream& error_stream_;
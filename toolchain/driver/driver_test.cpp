@@ -9,12 +9,15 @@
 
 #include <filesystem>
 #include <fstream>
+#include <string>
 #include <utility>
 
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
 #include "testing/base/test_raw_ostream.h"
+#include "toolchain/sem_ir/serialize.h"
 #include "toolchain/testing/yaml_test_helpers.h"
 
 namespace Carbon {
@@ -24,6 +27,7 @@ using ::Carbon::Testing::TestRawOstream;
 using ::testing::_;
 using ::testing::ContainsRegex;
 using ::testing::HasSubstr;
+using ::testing::Not;
 using ::testing::StrEq;
 
 namespace Yaml = ::Carbon::Testing::Yaml;
@@ -122,6 +126,12 @@ TEST_F(DriverTest, CompileCommandErrors) {
       driver_.RunCommand({"compile", "--output=/dev/empty", empty_file}));
   EXPECT_THAT(test_error_stream_.TakeStr(),
               ContainsRegex("ERROR: .*/dev/empty.*"));
+
+  // Invalid number of jobs.
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--jobs=0", empty_file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              StrEq("ERROR: The number of jobs must be at least 1, but was "
+                    "0.\n"));
 }
 
 TEST_F(DriverTest, DumpTokens) {
@@ -134,6 +144,21 @@ TEST_F(DriverTest, DumpTokens) {
               Yaml::IsYaml(_));
 }
 
+TEST_F(DriverTest, SingleJobStreams) {
+  // With one job, units write directly to the driver's streams instead of
+  // buffering.
+  auto file = CreateTestFile("Hello World");
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--jobs=1", "--phase=lex", "--dump-tokens", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  EXPECT_THAT(test_output_stream_.TakeStr(), HasSubstr("Hello"));
+
+  auto bad_file = CreateTestFile("fn F() {", "bad.carbon");
+  EXPECT_FALSE(driver_.RunCommand(
+      {"compile", "--jobs=1", "--phase=parse", bad_file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), HasSubstr("bad.carbon"));
+}
+
 TEST_F(DriverTest, DumpParseTree) {
   auto file = CreateTestFile("var v: i32 = 42;");
   EXPECT_TRUE(driver_.RunCommand(
@@ -144,6 +169,19 @@ TEST_F(DriverTest, DumpParseTree) {
               Yaml::IsYaml(_));
 }
 
+TEST_F(DriverTest, DumpBinarySemIR) {
+  auto file = CreateTestFile("fn F() -> i32 { return 1; }");
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--phase=check", "--dump-binary-sem-ir", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  // Copy the output into a buffer to get the required alignment.
+  auto buffer =
+      llvm::MemoryBuffer::getMemBufferCopy(test_output_stream_.TakeStr());
+  auto filename = SemIR::GetSerializedFilename(buffer->getBuffer());
+  ASSERT_TRUE(filename.ok()) << filename.error();
+  EXPECT_THAT(*filename, StrEq("test_file.carbon"));
+}
+
 TEST_F(DriverTest, StdoutOutput) {
   // Use explicit filenames so we can look for those to validate output.
   CreateTestFile("fn Main() -> i32 { return 0; }", "test.carbon");
@@ -165,6 +203,150 @@ TEST_F(DriverTest, StdoutOutput) {
   EXPECT_TRUE(result->get()->isObject());
 }
 
+TEST_F(DriverTest, Optimize) {
+  CreateTestFile(R"(
+    fn Add(a: i32, b: i32) -> i32 { return a + b; }
+    fn Main() -> i32 {
+      var x: i32 = Add(1, 2);
+      return x;
+    }
+  )",
+                 "test.carbon");
+
+  for (llvm::StringRef level : {"0", "1", "2", "3"}) {
+    std::string flag = ("--optimize=" + level).str();
+    EXPECT_TRUE(
+        driver_.RunCommand({"compile", "--output=-", flag, "test.carbon"}));
+    EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+    EXPECT_THAT(test_output_stream_.TakeStr(), ContainsRegex("Main:"));
+  }
+
+  EXPECT_FALSE(driver_.RunCommand(
+      {"compile", "--output=-", "--optimize=4", "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), HasSubstr("ERROR"));
+}
+
+TEST_F(DriverTest, TargetCpuAndFeatures) {
+  auto file = CreateTestFile("fn Main() -> i32 { return 0; }");
+
+  // The CPU and features are recorded on functions.
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--phase=lower", "--dump-llvm-ir",
+       "--target=x86_64-unknown-linux-gnu", "--target-cpu=skylake-avx512",
+       "--target-features=-avx512vl", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  std::string ir = test_output_stream_.TakeStr();
+  EXPECT_THAT(ir, HasSubstr(R"("target-cpu"="skylake-avx512")"));
+  EXPECT_THAT(ir, HasSubstr(R"("target-features"="-avx512vl")"));
+
+  // And used for codegen.
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--output=-", "--target=x86_64-unknown-linux-gnu",
+       "--target-cpu=skylake-avx512", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  EXPECT_THAT(test_output_stream_.TakeStr(), ContainsRegex("Main:"));
+
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--output=-",
+                                   "--target=x86_64-unknown-linux-gnu",
+                                   "--target-cpu=not-a-cpu", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              HasSubstr("ERROR: Invalid CPU for target"));
+
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--output=-",
+                                   "--target=x86_64-unknown-linux-gnu",
+                                   "--target-features=+avx2,+not-a-feature",
+                                   file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              HasSubstr("ERROR: Invalid feature for target "
+                        "'x86_64-unknown-linux-gnu': not-a-feature"));
+
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--output=-",
+                                   "--target=x86_64-unknown-linux-gnu",
+                                   "--target-features=avx2", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              HasSubstr("ERROR: Target feature must start with '+' or '-'"));
+}
+
+TEST_F(DriverTest, TargetCpuNative) {
+  auto file = CreateTestFile("fn Main() -> i32 { return 0; }");
+
+  EXPECT_TRUE(driver_.RunCommand({"compile", "--phase=lower", "--dump-llvm-ir",
+                                  "--target-cpu=native", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  EXPECT_THAT(test_output_stream_.TakeStr(), HasSubstr(R"("target-cpu"=)"));
+
+  // Native requires compiling for the host.
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--target=not-the-host",
+                                   "--target-cpu=native", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              HasSubstr("requires the target to be the host"));
+}
+
+TEST_F(DriverTest, ParallelLowering) {
+  // Enough functions to be split across threads, calling each other across
+  // the splits.
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  constexpr int NumFunctions = 300;
+  for (int i = 0; i < NumFunctions; ++i) {
+    os << "fn F" << i << "(a: i32) -> i32 { return ";
+    if (i > 0) {
+      os << "F" << (i * 7 + 3) % i << "(a) + ";
+    }
+    os << i << "; }\n";
+  }
+  os << "fn Run() -> i32 { return F" << NumFunctions - 1 << "(1); }\n";
+  CreateTestFile(source, "test.carbon");
+
+  for (llvm::StringRef jobs : {"--jobs=1", "--jobs=4"}) {
+    EXPECT_TRUE(driver_.RunCommand({"compile", "--phase=lower",
+                                    "--dump-llvm-ir", jobs, "test.carbon"}));
+    EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+    std::string ir = test_output_stream_.TakeStr();
+    for (int i = 0; i < NumFunctions; ++i) {
+      EXPECT_THAT(ir, HasSubstr(llvm::formatv("define i32 @F{0}(", i).str()))
+          << jobs;
+    }
+    EXPECT_THAT(ir, HasSubstr("define i32 @main("));
+  }
+
+  // The linked module can be compiled.
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--output=-", "--jobs=4", "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  EXPECT_THAT(test_output_stream_.TakeStr(), ContainsRegex("main:"));
+}
+
+TEST_F(DriverTest, MultipleFilesWithJobs) {
+  // Files sharing identifiers, which are seen in a different order in each.
+  constexpr int NumFiles = 8;
+  llvm::SmallVector<std::string> file_names;
+  for (int i = 0; i < NumFiles; ++i) {
+    std::string source;
+    llvm::raw_string_ostream os(source);
+    for (int j = 0; j < NumFiles; ++j) {
+      os << "fn F" << (i + j) % NumFiles << "() {}\n";
+    }
+    file_names.push_back(llvm::formatv("test{0}.carbon", i).str());
+    CreateTestFile(source, file_names.back());
+  }
+
+  auto compile = [&](llvm::StringRef jobs) -> std::string {
+    llvm::SmallVector<llvm::StringRef> args = {"compile", "--phase=check",
+                                               "--dump-sem-ir", jobs};
+    args.append(file_names.begin(), file_names.end());
+    EXPECT_TRUE(driver_.RunCommand(args));
+    EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+    return test_output_stream_.TakeStr();
+  };
+  // String IDs depend on how files are scheduled, but the textual IR, which
+  // prints names rather than IDs, doesn't.
+  std::string serial = compile("--jobs=1");
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(compile("--jobs=4"), StrEq(serial));
+  }
+}
+
 TEST_F(DriverTest, FileOutput) {
   auto scope = ScopedTempWorkingDir();
 
@@ -191,5 +373,143 @@ TEST_F(DriverTest, FileOutput) {
   EXPECT_THAT(ReadFile("test.s"), ContainsRegex("Main:"));
 }
 
+TEST_F(DriverTest, CodeGenThreads) {
+  auto scope = ScopedTempWorkingDir();
+
+  CreateTestFile(R"(
+    fn A() -> i32 { return 1; }
+    fn B() -> i32 { return A() + 2; }
+    fn Main() -> i32 { return B(); }
+  )",
+                 "test.carbon");
+
+  // Each partition is written to its own object file.
+  EXPECT_TRUE(
+      driver_.RunCommand({"compile", "--codegen-threads=3", "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  for (llvm::StringRef file_name : {"test.o", "test.1.o", "test.2.o"}) {
+    auto result = llvm::object::createBinary(file_name);
+    if (auto error = result.takeError()) {
+      FAIL() << file_name.str() << ": " << toString(std::move(error));
+    }
+    EXPECT_TRUE(result->getBinary()->isObject()) << file_name.str();
+  }
+
+  // Assembly written to stdout has every partition, in order.
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--output=-", "--codegen-threads=2", "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  std::string assembly = test_output_stream_.TakeStr();
+  for (llvm::StringRef label : {"A:", "B:", "Main:"}) {
+    EXPECT_THAT(assembly, HasSubstr(label.str()));
+  }
+
+  EXPECT_FALSE(driver_.RunCommand({"compile", "--output=-",
+                                   "--force-obj-output", "--codegen-threads=2",
+                                   "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), HasSubstr("ERROR"));
+
+  EXPECT_FALSE(
+      driver_.RunCommand({"compile", "--codegen-threads=0", "test.carbon"}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              StrEq("ERROR: The number of codegen threads must be at least 1, "
+                    "but was 0.\n"));
+}
+
+TEST_F(DriverTest, TimeTrace) {
+  auto scope = ScopedTempWorkingDir();
+
+  auto file = CreateTestFile("fn Main() -> i32 { return 0; }");
+  EXPECT_TRUE(driver_.RunCommand({"compile", "--phase=lower",
+                                  "--time-trace=trace.json",
+                                  "--time-trace-summary=-", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+
+  // The summary has an entry for each phase.
+  std::string summary = test_output_stream_.TakeStr();
+  EXPECT_THAT(Yaml::Value::FromText(summary), Yaml::IsYaml(_));
+  for (llvm::StringRef phase :
+       {"SourceBuffer::CreateFromFile", "Lex::Lex", "Parse::Tree::Parse",
+        "Check::CheckParseTree", "Lower::LowerToLLVM"}) {
+    EXPECT_THAT(summary, HasSubstr((phase + ":").str()));
+  }
+  EXPECT_THAT(summary, HasSubstr("tokens:"));
+  EXPECT_THAT(summary, HasSubstr("insts:"));
+
+  // The trace is JSON with an event for each phase.
+  auto trace = llvm::json::parse(ReadFile("trace.json"));
+  if (auto error = trace.takeError()) {
+    FAIL() << toString(std::move(error));
+  }
+  const auto* events = trace->getAsObject()->getArray("traceEvents");
+  ASSERT_TRUE(events != nullptr);
+  EXPECT_EQ(events->size(), 5U);
+}
+
+TEST_F(DriverTest, SemIRCache) {
+  auto scope = ScopedTempWorkingDir();
+
+  auto file = CreateTestFile(R"(
+    fn F(a: i32, b: (i32, i32)) -> i32 {
+      var c: {.x: i32} = {.x = b[0]};
+      return a + c.x;
+    }
+  )");
+
+  // The first compile populates the cache.
+  EXPECT_TRUE(driver_.RunCommand({"compile", "--phase=check", "--dump-sem-ir",
+                                  "--sem-ir-cache-dir=cache", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  std::string checked_sem_ir = test_output_stream_.TakeStr();
+  EXPECT_FALSE(std::filesystem::is_empty("cache"));
+
+  // The second compile loads from it, producing the same SemIR.
+  EXPECT_TRUE(driver_.RunCommand({"-v", "compile", "--phase=check",
+                                  "--dump-sem-ir", "--sem-ir-cache-dir=cache",
+                                  file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              HasSubstr("Loaded SemIR from cache: test_file.carbon"));
+  EXPECT_THAT(test_output_stream_.TakeStr(), StrEq(checked_sem_ir));
+
+  // Lowering works from cached SemIR.
+  EXPECT_TRUE(driver_.RunCommand(
+      {"compile", "--phase=lower", "--sem-ir-cache-dir=cache", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+}
+
+TEST_F(DriverTest, SemIRCacheCorrupt) {
+  auto scope = ScopedTempWorkingDir();
+
+  auto file = CreateTestFile(R"(
+    fn F(a: i32, b: (i32, i32)) -> i32 {
+      var c: {.x: i32} = {.x = b[0]};
+      return a + c.x;
+    }
+  )");
+
+  EXPECT_TRUE(driver_.RunCommand({"compile", "--phase=check", "--dump-sem-ir",
+                                  "--sem-ir-cache-dir=cache", file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(), StrEq(""));
+  std::string checked_sem_ir = test_output_stream_.TakeStr();
+
+  // Overwrite the back half of each cache entry, which holds instructions and
+  // blocks, with IDs and kinds that are out of range.
+  for (const auto& entry : std::filesystem::directory_iterator("cache")) {
+    auto size = std::filesystem::file_size(entry.path());
+    std::fstream cache_file(entry.path(),
+                            std::ios::in | std::ios::out | std::ios::binary);
+    cache_file.seekp(size / 2);
+    cache_file << std::string(size - size / 2, '\x7F');
+  }
+
+  // The corrupt entry is a cache miss, and the file is checked again.
+  EXPECT_TRUE(driver_.RunCommand({"-v", "compile", "--phase=check",
+                                  "--dump-sem-ir", "--sem-ir-cache-dir=cache",
+                                  file}));
+  EXPECT_THAT(test_error_stream_.TakeStr(),
+              Not(HasSubstr("Loaded SemIR from cache")));
+  EXPECT_THAT(test_output_stream_.TakeStr(), StrEq(checked_sem_ir));
+}
+
 }  // namespace
 }  // namespace Carbon
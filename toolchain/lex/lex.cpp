@@ -4,12 +4,17 @@
 
 #include "toolchain/lex/lex.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <limits>
+#include <string_view>
 
 #include "common/check.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/ThreadPool.h"
 #include "toolchain/base/value_store.h"
 #include "toolchain/lex/character_set.h"
 #include "toolchain/lex/helpers.h"
@@ -29,6 +34,74 @@
 
 namespace Carbon::Lex {
 
+namespace {
+// Scanners using vectors wider than the baseline compilation supports, which
+// are selected at runtime based on the host CPU. Each scans a prefix of the
+// text in bulk, falling back to scalar code for the tail.
+struct WideScanners {
+  using ScanFunctionT = auto(llvm::StringRef text, ssize_t position)
+      -> ssize_t;
+  using PrefixEqualFunctionT = auto(const char* lhs, const char* rhs,
+                                    ssize_t size) -> bool;
+
+  // Returns the position of the first non-identifier byte at or after
+  // `position`.
+  ScanFunctionT* scan_identifier;
+  // Returns the position of the first byte at or after `position` that isn't a
+  // space or tab.
+  ScanFunctionT* skip_horizontal_whitespace;
+  // Returns whether the first `size` bytes of `lhs` and `rhs` are equal. `size`
+  // must be at most `width`, and both must have `width` readable bytes.
+  PrefixEqualFunctionT* prefix_equal;
+
+  // The number of bytes processed at once.
+  ssize_t width;
+};
+}  // namespace
+
+// Returns the scanners to use for the host CPU and `SetMaxVectorWidth`, or null
+// if only the baseline code should be used.
+static auto GetWideScanners() -> const WideScanners*;
+
+namespace {
+// One of the regions of lines that a large source buffer is split into, to be
+// lexed concurrently and then stitched together.
+struct LexedRegion {
+  explicit LexedRegion(ValueStore<StringId>* strings) : value_stores(strings) {}
+
+  // The values for the region's tokens. Strings are added directly to the
+  // shared string store, and integers and reals are added to the shared value
+  // stores when stitching.
+  SharedValueStores value_stores;
+
+  std::optional<TokenizedBuffer> buffer;
+
+  // Closing symbols whose opening symbol is in an earlier region.
+  llvm::SmallVector<Token> unmatched_closing_tokens;
+
+  // Opening symbols still open at the end of the region.
+  llvm::SmallVector<Token> open_groups;
+
+  // Whether lexing the region produced any diagnostics. Stitching can't
+  // reproduce the order and context of diagnostics, so if there are any, the
+  // whole source is lexed again on one thread instead.
+  bool has_diagnostics = false;
+};
+
+// Records whether there were any diagnostics, discarding them.
+class RecordingDiagnosticConsumer : public DiagnosticConsumer {
+ public:
+  auto HandleDiagnostic(Diagnostic /*diagnostic*/) -> void override {
+    seen_diagnostic_ = true;
+  }
+
+  auto seen_diagnostic() const -> bool { return seen_diagnostic_; }
+
+ private:
+  bool seen_diagnostic_ = false;
+};
+}  // namespace
+
 // Implementation of the lexer logic itself.
 //
 // The design is that lexing can loop over the source buffer, consuming it into
@@ -80,14 +153,16 @@ class [[clang::internal_linkage]] Lexer {
         translator_(&buffer_),
         emitter_(translator_, consumer_),
         token_translator_(&buffer_),
-        token_emitter_(token_translator_, consumer_) {}
+        token_emitter_(token_translator_, consumer_),
+        wide_scanners_(GetWideScanners()) {}
 
-  // Find all line endings and create the line data structures.
+  // Find all line endings from `start` and create the line data structures.
   //
   // Explicitly kept out-of-line because this is a significant loop that is
   // useful to have in the profile and it doesn't simplify by inlining at all.
   // But because it can, the compiler will flatten this otherwise.
-  [[gnu::noinline]] auto CreateLines(llvm::StringRef source_text) -> void;
+  [[gnu::noinline]] auto CreateLines(llvm::StringRef source_text, ssize_t start)
+      -> void;
 
   auto current_line() -> Line { return Line(line_index_); }
 
@@ -161,11 +236,54 @@ class [[clang::internal_linkage]] Lexer {
 
   auto LexEndOfFile(llvm::StringRef source_text, ssize_t position) -> void;
 
+  // Lexes `source_text` from `start`, which must be the start of a line,
+  // through to its end.
+  auto LexLines(llvm::StringRef source_text, ssize_t start) -> void;
+
   // The main entry point for dispatching through the lexer's table. This method
   // should always fully consume the source text.
   auto Lex() && -> TokenizedBuffer;
 
+  // Lexes the lines from `start` up to `end` into `region`. Both must be the
+  // starts of lines, or `end` may be the end of the source.
+  //
+  // Regions after the first start with a placeholder `StartOfFile` token, and
+  // record closing symbols whose opening symbol may be in an earlier region
+  // instead of diagnosing them. Regions before the last end without an
+  // `EndOfFile` token, leaving groups open, and with an empty line at `end`.
+  auto LexRegion(LexedRegion& region, ssize_t start, ssize_t end) && -> void;
+
+  // Lexes `source` by splitting it into regions which are lexed concurrently,
+  // then stitched together. Regions add strings directly to the shared string
+  // store, so the source is lexed on a single thread instead if the store isn't
+  // thread-safe. It's also lexed on a single thread if it's too small to split,
+  // or if there were diagnostics.
+  static auto LexInParallel(SharedValueStores& value_stores,
+                            SourceBuffer& source, DiagnosticConsumer& consumer,
+                            ParallelLexOptions parallel) -> TokenizedBuffer;
+
+  // Lexes `source` by lexing the lines touched by `edit` and stitching them
+  // between the tokens of the other lines in `old_tokens`. The source is lexed
+  // from scratch instead if the edit can't be lexed in isolation or if there
+  // were diagnostics.
+  static auto Relex(SharedValueStores& value_stores, SourceBuffer& source,
+                    const TokenizedBuffer& old_tokens, SourceEdit edit,
+                    DiagnosticConsumer& consumer) -> RelexResult;
+
  private:
+  // Adds the integer or real value of `info`, a token lexed into `region`, to
+  // `value_stores` and updates its payload to match. Strings are already in
+  // the shared string store.
+  static auto StitchTokenValue(SharedValueStores& value_stores,
+                               LexedRegion& region,
+                               TokenizedBuffer::TokenInfo& info) -> void;
+
+  // Moves the allocator of `region`'s buffer, if it was lexed, into `buffer`.
+  // The region's computed string literals are in the shared string store, so
+  // they must live as long as the buffer that's returned.
+  static auto KeepRegionStrings(TokenizedBuffer& buffer, LexedRegion& region)
+      -> void;
+
   TokenizedBuffer buffer_;
 
   ssize_t line_index_;
@@ -179,6 +297,17 @@ class [[clang::internal_linkage]] Lexer {
 
   TokenLocationTranslator token_translator_;
   TokenDiagnosticEmitter token_emitter_;
+
+  // Null unless the host CPU supports wider vectors than the baseline.
+  const WideScanners* wide_scanners_;
+
+  // When lexing a region after the first, closing symbols without an opening
+  // symbol in the region. Null otherwise.
+  llvm::SmallVector<Token>* unmatched_closing_tokens_ = nullptr;
+
+  // Whether lexing reaches the end of the source, rather than the end of a
+  // region before the last.
+  bool lexes_end_of_source_ = true;
 };
 
 // TODO: Move Overload and VariantMatch somewhere more central.
@@ -356,7 +485,8 @@ static constexpr NibbleLUT LowLUT = {
     .nibble_f = 0b1000'0101,
 };
 
-static auto ScanForIdentifierPrefixX86(llvm::StringRef text)
+static auto ScanForIdentifierPrefixX86(llvm::StringRef text,
+                                       const WideScanners* wide_scanners)
     -> llvm::StringRef {
   const auto high_lut = HighLUT.Load();
   const auto low_lut = LowLUT.Load();
@@ -410,13 +540,212 @@ static auto ScanForIdentifierPrefixX86(llvm::StringRef text)
       return text.substr(0, i);
     }
     i += 16;
+
+    // Past the first block, the identifier is long enough to be worth scanning
+    // with wider vectors when we have them.
+    if (wide_scanners != nullptr) {
+      return text.substr(0, wide_scanners->scan_identifier(text, i));
+    }
   }
 
   return ScanForIdentifierPrefixScalar(text, i);
 }
 
+// The AVX2 and AVX-512 scanners below are compiled for those targets regardless
+// of the baseline, and only called when the host CPU supports them.
+//
+// The identifier scanners use the same nibble LUTs as the SSE code, broadcast
+// to each 128-bit lane because the byte shuffles operate within lanes.
+[[gnu::target("avx2")]] static auto ScanForIdentifierAVX2(
+    llvm::StringRef text, ssize_t i) -> ssize_t {
+  const auto high_lut = _mm256_broadcastsi128_si256(HighLUT.Load());
+  const auto low_lut = _mm256_broadcastsi128_si256(LowLUT.Load());
+
+  const ssize_t size = text.size();
+  while ((i + 32) <= size) {
+    __m256i input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+    if (_mm256_movemask_epi8(input) != 0) {
+      break;
+    }
+
+    __m256i low_mask = _mm256_shuffle_epi8(low_lut, input);
+    __m256i input_high =
+        _mm256_and_si256(_mm256_srli_epi32(input, 4), _mm256_set1_epi8(0x0f));
+    __m256i high_mask = _mm256_shuffle_epi8(high_lut, input_high);
+    __m256i mask = _mm256_and_si256(low_mask, high_mask);
+
+    auto tail_ascii_mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(mask, _mm256_setzero_si256())));
+    if (tail_ascii_mask != 0) {
+      return i + __builtin_ctz(tail_ascii_mask);
+    }
+    i += 32;
+  }
+
+  return ScanForIdentifierPrefixScalar(text, i).size();
+}
+
+[[gnu::target("avx512f,avx512bw")]] static auto ScanForIdentifierAVX512(
+    llvm::StringRef text, ssize_t i) -> ssize_t {
+  const auto high_lut = _mm512_broadcast_i32x4(HighLUT.Load());
+  const auto low_lut = _mm512_broadcast_i32x4(LowLUT.Load());
+
+  const ssize_t size = text.size();
+  while ((i + 64) <= size) {
+    __m512i input = _mm512_loadu_si512(text.data() + i);
+    if (_mm512_movepi8_mask(input) != 0) {
+      break;
+    }
+
+    __m512i low_mask = _mm512_shuffle_epi8(low_lut, input);
+    __m512i input_high =
+        _mm512_and_si512(_mm512_srli_epi32(input, 4), _mm512_set1_epi8(0x0f));
+    __m512i high_mask = _mm512_shuffle_epi8(high_lut, input_high);
+
+    // Test the two masks against each other directly into a mask register,
+    // setting bits for the bytes where they have no bits in common.
+    __mmask64 tail_ascii_mask = _mm512_testn_epi8_mask(low_mask, high_mask);
+    if (tail_ascii_mask != 0) {
+      return i + __builtin_ctzll(tail_ascii_mask);
+    }
+    i += 64;
+  }
+
+  return ScanForIdentifierPrefixScalar(text, i).size();
+}
+
+static auto SkipHorizontalWhitespaceScalar(llvm::StringRef text, ssize_t i)
+    -> ssize_t {
+  const ssize_t size = text.size();
+  while (i < size && (text[i] == ' ' || text[i] == '\t')) {
+    ++i;
+  }
+  return i;
+}
+
+[[gnu::target("avx2")]] static auto SkipHorizontalWhitespaceAVX2(
+    llvm::StringRef text, ssize_t i) -> ssize_t {
+  const auto spaces = _mm256_set1_epi8(' ');
+  const auto tabs = _mm256_set1_epi8('\t');
+
+  const ssize_t size = text.size();
+  while ((i + 32) <= size) {
+    __m256i input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+    auto whitespace_mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(input, spaces),
+                                             _mm256_cmpeq_epi8(input, tabs))));
+    if (whitespace_mask != 0xFFFF'FFFF) {
+      return i + __builtin_ctz(~whitespace_mask);
+    }
+    i += 32;
+  }
+
+  return SkipHorizontalWhitespaceScalar(text, i);
+}
+
+[[gnu::target("avx512f,avx512bw")]] static auto SkipHorizontalWhitespaceAVX512(
+    llvm::StringRef text, ssize_t i) -> ssize_t {
+  const auto spaces = _mm512_set1_epi8(' ');
+  const auto tabs = _mm512_set1_epi8('\t');
+
+  const ssize_t size = text.size();
+  while ((i + 64) <= size) {
+    __m512i input = _mm512_loadu_si512(text.data() + i);
+    __mmask64 whitespace_mask = _mm512_cmpeq_epi8_mask(input, spaces) |
+                                _mm512_cmpeq_epi8_mask(input, tabs);
+    if (~whitespace_mask != 0) {
+      return i + __builtin_ctzll(~whitespace_mask);
+    }
+    i += 64;
+  }
+
+  return SkipHorizontalWhitespaceScalar(text, i);
+}
+
+// 32 bytes of ones followed by 32 bytes of zeros. Loading 32 bytes starting at
+// `32 - size` gives a mask of the first `size` bytes.
+alignas(64) static constexpr std::array<uint8_t, 64> AVX2PrefixMaskBytes = [] {
+  std::array<uint8_t, 64> bytes = {};
+  for (int i = 0; i < 32; ++i) {
+    bytes[i] = 0xFF;
+  }
+  return bytes;
+}();
+
+[[gnu::target("avx2")]] static auto PrefixEqualAVX2(const char* lhs,
+                                                    const char* rhs,
+                                                    ssize_t size) -> bool {
+  auto mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      AVX2PrefixMaskBytes.data() + 32 - size));
+  auto diff = _mm256_xor_si256(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs)));
+  return _mm256_testz_si256(diff, mask);
+}
+
+[[gnu::target("avx512f,avx512bw")]] static auto PrefixEqualAVX512(
+    const char* lhs, const char* rhs, ssize_t size) -> bool {
+  __mmask64 mask = size == 64 ? ~0ULL : (1ULL << size) - 1;
+  return _mm512_mask_cmpneq_epi8_mask(mask, _mm512_loadu_si512(lhs),
+                                      _mm512_loadu_si512(rhs)) == 0;
+}
+
+static constexpr WideScanners AVX2Scanners = {
+    .scan_identifier = ScanForIdentifierAVX2,
+    .skip_horizontal_whitespace = SkipHorizontalWhitespaceAVX2,
+    .prefix_equal = PrefixEqualAVX2,
+    .width = 32,
+};
+
+static constexpr WideScanners AVX512Scanners = {
+    .scan_identifier = ScanForIdentifierAVX512,
+    .skip_horizontal_whitespace = SkipHorizontalWhitespaceAVX512,
+    .prefix_equal = PrefixEqualAVX512,
+    .width = 64,
+};
+
 #endif  // CARBON_USE_SIMD && __x86_64__
 
+auto GetHostVectorWidth() -> VectorWidth {
+  static const VectorWidth host_width = [] {
+#if CARBON_USE_SIMD && __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw")) {
+      return VectorWidth::Bits512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return VectorWidth::Bits256;
+    }
+#endif
+    return VectorWidth::Baseline;
+  }();
+  return host_width;
+}
+
+static std::atomic<VectorWidth> max_vector_width = VectorWidth::Bits512;
+
+auto SetMaxVectorWidth(VectorWidth width) -> VectorWidth {
+  return max_vector_width.exchange(width, std::memory_order_relaxed);
+}
+
+static auto GetWideScanners() -> const WideScanners* {
+#if CARBON_USE_SIMD && __x86_64__
+  switch (std::min(GetHostVectorWidth(),
+                   max_vector_width.load(std::memory_order_relaxed))) {
+    case VectorWidth::Baseline:
+      return nullptr;
+    case VectorWidth::Bits256:
+      return &AVX2Scanners;
+    case VectorWidth::Bits512:
+      return &AVX512Scanners;
+  }
+#endif
+  return nullptr;
+}
+
 // Scans the provided text and returns the prefix `StringRef` of contiguous
 // identifier characters.
 //
@@ -432,10 +761,12 @@ static auto ScanForIdentifierPrefixX86(llvm::StringRef text)
 // Some work has been done to ensure the hot loop, while optimized, retains
 // enough information to add Unicode handling without completely destroying the
 // relevant optimizations.
-static auto ScanForIdentifierPrefix(llvm::StringRef text) -> llvm::StringRef {
+static auto ScanForIdentifierPrefix(llvm::StringRef text,
+                                    const WideScanners* wide_scanners)
+    -> llvm::StringRef {
   // Dispatch to an optimized architecture optimized routine.
 #if CARBON_USE_SIMD && __x86_64__
-  return ScanForIdentifierPrefixX86(text);
+  return ScanForIdentifierPrefixX86(text, wide_scanners);
 #elif CARBON_USE_SIMD && __ARM_NEON
   // Somewhat surprisingly, there is basically nothing worth doing in SIMD on
   // Arm to optimize this scan. The Neon SIMD operations end up requiring you to
@@ -454,9 +785,104 @@ static auto ScanForIdentifierPrefix(llvm::StringRef text) -> llvm::StringRef {
   // scanner, and so currently we just use a boring scalar loop that pipelines
   // well.
 #endif
+  static_cast<void>(wide_scanners);
   return ScanForIdentifierPrefixScalar(text, 0);
 }
 
+// Keywords are recognized with a perfect hash table, computed at compile time
+// from token_kind.def. Looking up an identifier takes one hash and one string
+// comparison, rather than comparing against each keyword of the same length.
+namespace {
+struct KeywordInfo {
+  std::string_view spelling;
+  TokenKind kind;
+};
+}  // namespace
+
+// The keywords, after an empty entry for empty slots in the hash table. As
+// identifiers are never empty, it never matches.
+static constexpr KeywordInfo Keywords[] = {
+    {"", TokenKind::Error},
+#define CARBON_KEYWORD_TOKEN(Name, Spelling) {Spelling, TokenKind::Name},
+#include "toolchain/lex/token_kind.def"
+};
+
+static constexpr size_t MaxKeywordLength = [] {
+  size_t max_length = 0;
+  for (const auto& keyword : Keywords) {
+    max_length = std::max(max_length, keyword.spelling.size());
+  }
+  return max_length;
+}();
+
+// Packs the length and the first two and last two bytes of `text` into a key to
+// hash. These are enough to distinguish every keyword. `text` must be non-empty
+// and at most `MaxKeywordLength` bytes.
+static constexpr auto KeywordKey(std::string_view text) -> uint64_t {
+  size_t size = text.size();
+  auto byte = [&](size_t i) -> uint64_t {
+    return static_cast<uint8_t>(text[i]);
+  };
+  return byte(0) | byte(std::min<size_t>(1, size - 1)) << 8 |
+         byte(size > 1 ? size - 2 : 0) << 16 | byte(size - 1) << 24 |
+         static_cast<uint64_t>(size) << 32;
+}
+
+namespace {
+struct KeywordHashTable {
+  static constexpr int Bits = 9;
+
+  constexpr auto Slot(uint64_t key) const -> size_t {
+    return (key * multiplier) >> (64 - Bits);
+  }
+
+  // The multiplier for the hash, or zero if none was found that hashes each
+  // keyword to a different slot.
+  uint64_t multiplier = 0;
+  // The index into `Keywords` for each slot.
+  std::array<uint8_t, 1 << Bits> slots = {};
+};
+}  // namespace
+
+static_assert(std::size(Keywords) <= std::numeric_limits<uint8_t>::max(),
+              "Too many keywords to index with `uint8_t`.");
+
+static constexpr KeywordHashTable KeywordTable = [] {
+  KeywordHashTable table;
+  // Search through multipliers that are well distributed odd numbers until one
+  // hashes each keyword to a different slot. With the table size here, this
+  // takes a few tens of attempts.
+  for (uint64_t attempt = 1; attempt <= 1000; ++attempt) {
+    table.multiplier = (0x9E37'79B9'7F4A'7C15 * attempt) | 1;
+    table.slots = {};
+    bool collided = false;
+    for (size_t i = 1; i < std::size(Keywords) && !collided; ++i) {
+      auto& slot = table.slots[table.Slot(KeywordKey(Keywords[i].spelling))];
+      collided = slot != 0;
+      slot = i;
+    }
+    if (!collided) {
+      return table;
+    }
+  }
+  return KeywordHashTable();
+}();
+static_assert(KeywordTable.multiplier != 0,
+              "Unable to find a perfect hash for the keywords; try increasing "
+              "`KeywordHashTable::Bits`.");
+
+// Returns the keyword kind spelled by `text`, or `Error` if it isn't a
+// keyword. `text` must be non-empty.
+static auto LookupKeyword(llvm::StringRef text) -> TokenKind {
+  if (text.size() > MaxKeywordLength) {
+    return TokenKind::Error;
+  }
+  std::string_view text_view = text;
+  const auto& keyword =
+      Keywords[KeywordTable.slots[KeywordTable.Slot(KeywordKey(text_view))]];
+  return keyword.spelling == text_view ? keyword.kind : TokenKind::Error;
+}
+
 using DispatchFunctionT = auto(Lexer& lexer, llvm::StringRef source_text,
                                ssize_t position) -> void;
 using DispatchTableT = std::array<DispatchFunctionT*, 256>;
@@ -650,18 +1076,20 @@ static auto DispatchNext(Lexer& lexer, llvm::StringRef source_text,
   lexer.LexEndOfFile(source_text, position);
 }
 
-auto Lexer::Lex() && -> TokenizedBuffer {
-  llvm::StringRef source_text = buffer_.source_->text();
-
+auto Lexer::LexLines(llvm::StringRef source_text, ssize_t start) -> void {
   // First build up our line data structures.
-  CreateLines(source_text);
+  CreateLines(source_text, start);
 
-  ssize_t position = 0;
+  ssize_t position = start;
   LexStartOfFile(source_text, position);
 
   // Manually enter the dispatch loop. This call will tail-recurse through the
   // dispatch table until everything from source_text is consumed.
   DispatchNext(*this, source_text, position);
+}
+
+auto Lexer::Lex() && -> TokenizedBuffer {
+  LexLines(buffer_.source_->text(), 0);
 
   if (consumer_.seen_error()) {
     buffer_.has_errors_ = true;
@@ -670,7 +1098,25 @@ auto Lexer::Lex() && -> TokenizedBuffer {
   return std::move(buffer_);
 }
 
-auto Lexer::CreateLines(llvm::StringRef source_text) -> void {
+auto Lexer::LexRegion(LexedRegion& region, ssize_t start, ssize_t end) &&
+    -> void {
+  llvm::StringRef source_text = buffer_.source_->text();
+  lexes_end_of_source_ = end == static_cast<ssize_t>(source_text.size());
+  if (start != 0) {
+    unmatched_closing_tokens_ = &region.unmatched_closing_tokens;
+  }
+
+  // Lexing stops at the end of the text, so truncate it to end the region.
+  // Tokens other than block string literals can't span lines, and those would
+  // be diagnosed as unterminated.
+  LexLines(source_text.substr(0, end), start);
+
+  region.open_groups = std::move(open_groups_);
+  region.buffer = std::move(buffer_);
+}
+
+auto Lexer::CreateLines(llvm::StringRef source_text, ssize_t start)
+    -> void {
   // We currently use `memchr` here which typically is well optimized to use
   // SIMD or other significantly faster than byte-wise scanning. We also use
   // carefully selected variables and the `ssize_t` type for performance and
@@ -683,7 +1129,6 @@ auto Lexer::CreateLines(llvm::StringRef source_text) -> void {
   // baseline performance target when adding those features.
   const char* const text = source_text.data();
   const ssize_t size = source_text.size();
-  ssize_t start = 0;
   while (const char* nl = reinterpret_cast<const char*>(
              memchr(&text[start], '\n', size - start))) {
     ssize_t nl_index = nl - text;
@@ -709,13 +1154,21 @@ auto Lexer::CreateLines(llvm::StringRef source_text) -> void {
 auto Lexer::SkipHorizontalWhitespace(llvm::StringRef source_text,
                                      ssize_t& position) -> void {
   // Handle adjacent whitespace quickly. This comes up frequently for example
-  // due to indentation. We don't expect *huge* runs, so just use a scalar
+  // due to indentation. We don't expect *huge* runs, so start with a scalar
   // loop. While still scalar, this avoids repeated table dispatch and marking
-  // whitespace.
-  while (position < static_cast<ssize_t>(source_text.size()) &&
+  // whitespace. Longer runs, such as deep indentation, are finished with wider
+  // vectors when we have them.
+  const ssize_t size = source_text.size();
+  const ssize_t scalar_end =
+      wide_scanners_ ? std::min<ssize_t>(position + 16, size) : size;
+  while (position < scalar_end &&
          (source_text[position] == ' ' || source_text[position] == '\t')) {
     ++position;
   }
+  if (LLVM_UNLIKELY(position == scalar_end) && position < size) {
+    position =
+        wide_scanners_->skip_horizontal_whitespace(source_text, position);
+  }
 }
 
 auto Lexer::LexHorizontalWhitespace(llvm::StringRef source_text,
@@ -801,9 +1254,7 @@ auto Lexer::LexComment(llvm::StringRef source_text, ssize_t& position) -> void {
   //
   // When we have SIMD support this is even more important for speed, as short
   // indents can be scanned extremely quickly with SIMD and we expect these to
-  // be the dominant cases.
-  //
-  // TODO: We should extend this to 32-byte SIMD on platforms with support.
+  // be the dominant cases. Deeper indents use wider vectors when we have them.
   constexpr int MaxIndent = 13;
   const int indent = line_info->indent;
   const ssize_t first_line_start = line_info->start;
@@ -869,6 +1320,17 @@ auto Lexer::LexComment(llvm::StringRef source_text, ssize_t& position) -> void {
     // should really fall through to the generic skipping logic, but the code
     // organization will need to change significantly to allow that.
   } else {
+    if (wide_scanners_ && prefix_size <= wide_scanners_->width) {
+      const char* exemplar = source_text.data() + first_line_start;
+      while (position + wide_scanners_->width <
+                 static_cast<ssize_t>(source_text.size()) &&
+             wide_scanners_->prefix_equal(
+                 exemplar, source_text.data() + position, prefix_size)) {
+        skip_to_next_line();
+      }
+    }
+    // This also finishes any lines too close to the end of the buffer for the
+    // wide scanner.
     while (position + prefix_size < static_cast<ssize_t>(source_text.size()) &&
            memcmp(source_text.data() + first_line_start,
                   source_text.data() + position, prefix_size) == 0) {
@@ -1012,8 +1474,14 @@ auto Lexer::LexClosingSymbolToken(llvm::StringRef source_text, TokenKind kind,
     return token;
   };
 
-  // If we have no open groups, this is an error.
+  // If we have no open groups, this is an error, unless an earlier region may
+  // have the opening symbol. That's matched when stitching regions together.
   if (LLVM_UNLIKELY(open_groups_.empty())) {
+    if (unmatched_closing_tokens_ != nullptr) {
+      Token token = LexOneCharSymbolToken(source_text, kind, position);
+      unmatched_closing_tokens_->push_back(token);
+      return token;
+    }
     return unmatched_error();
   }
 
@@ -1161,7 +1629,7 @@ auto Lexer::LexKeywordOrIdentifier(llvm::StringRef source_text,
 
   // Take the valid characters off the front of the source buffer.
   llvm::StringRef identifier_text =
-      ScanForIdentifierPrefix(source_text.substr(position));
+      ScanForIdentifierPrefix(source_text.substr(position), wide_scanners_);
   CARBON_CHECK(!identifier_text.empty()) << "Must have at least one character!";
   position += identifier_text.size();
 
@@ -1171,10 +1639,7 @@ auto Lexer::LexKeywordOrIdentifier(llvm::StringRef source_text,
   }
 
   // Check if the text matches a keyword token, and if so use that.
-  TokenKind kind = llvm::StringSwitch<TokenKind>(identifier_text)
-#define CARBON_KEYWORD_TOKEN(Name, Spelling) .Case(Spelling, TokenKind::Name)
-#include "toolchain/lex/token_kind.def"
-                       .Default(TokenKind::Error);
+  TokenKind kind = LookupKeyword(identifier_text);
   if (kind != TokenKind::Error) {
     return buffer_.AddToken(
         {.kind = kind, .token_line = current_line(), .column = column});
@@ -1208,7 +1673,8 @@ auto Lexer::LexKeywordOrIdentifierMaybeRaw(llvm::StringRef source_text,
 
   // Take the valid characters off the front of the source buffer.
   llvm::StringRef identifier_text =
-      ScanForIdentifierPrefix(source_text.substr(position + 2));
+      ScanForIdentifierPrefix(source_text.substr(position + 2),
+                              wide_scanners_);
   CARBON_CHECK(!identifier_text.empty()) << "Must have at least one character!";
   position += identifier_text.size() + 2;
 
@@ -1277,13 +1743,17 @@ auto Lexer::LexStartOfFile(llvm::StringRef source_text, ssize_t& position)
   // first line.
   SkipHorizontalWhitespace(source_text, position);
   auto* line_info = current_line_info();
-  CARBON_CHECK(line_info->start == 0);
-  line_info->indent = position;
+  line_info->indent = position - line_info->start;
 }
 
 auto Lexer::LexEndOfFile(llvm::StringRef source_text, ssize_t position)
     -> void {
   CARBON_CHECK(position == static_cast<ssize_t>(source_text.size()));
+  // The end of a region before the last is stitched to the next region.
+  if (!lexes_end_of_source_) {
+    return;
+  }
+
   // Check if the last line is empty and not the first line (and only). If so,
   // re-pin the last line to be the prior one so that diagnostics and editors
   // can treat newlines as terminators even though we internally handle them
@@ -1312,9 +1782,442 @@ auto Lexer::LexEndOfFile(llvm::StringRef source_text, ssize_t position)
                     .column = ComputeColumn(position)});
 }
 
+auto Lexer::LexInParallel(SharedValueStores& value_stores,
+                          SourceBuffer& source, DiagnosticConsumer& consumer,
+                          ParallelLexOptions parallel) -> TokenizedBuffer {
+  llvm::StringRef source_text = source.text();
+  const ssize_t size = source_text.size();
+  int64_t max_regions = std::min<int64_t>(
+      parallel.max_threads,
+      size / std::max<int64_t>(parallel.min_bytes_per_thread, 1));
+  if (max_regions <= 1 || !value_stores.strings().thread_safe()) {
+    return Lexer(value_stores, source, consumer).Lex();
+  }
+
+  // Split the source at the starts of the lines following evenly spaced
+  // offsets. Only block string literals span lines, so track whether each
+  // candidate is inside one by the parity of the `'''` delimiters before it,
+  // and move past the closing delimiter if so. This can be fooled by a
+  // delimiter in a comment or a simple string, but the region lexed from the
+  // wrong state will diagnose an error and we fall back.
+  const char* text = source_text.data();
+  auto find_delimiter = [&](ssize_t offset) -> ssize_t {
+    while (offset < size) {
+      const char* quote = reinterpret_cast<const char*>(
+          memchr(text + offset, '\'', size - offset));
+      if (quote == nullptr) {
+        break;
+      }
+      offset = quote - text;
+      if (offset + 2 < size && quote[1] == '\'' && quote[2] == '\'') {
+        return offset;
+      }
+      ++offset;
+    }
+    return size;
+  };
+  auto next_line_start = [&](ssize_t offset) -> ssize_t {
+    const char* newline = reinterpret_cast<const char*>(
+        memchr(text + offset, '\n', size - offset));
+    return newline == nullptr ? size : newline + 1 - text;
+  };
+  // The next delimiter not yet stepped over, which opens a block string.
+  ssize_t delimiter = find_delimiter(0);
+  llvm::SmallVector<ssize_t> bounds = {0};
+  for (int64_t i = 1; i < max_regions; ++i) {
+    ssize_t bound = next_line_start(
+        std::max<ssize_t>(bounds.back(), size * i / max_regions));
+    // Step over the block strings opened before the bound, moving the bound
+    // past the line of a closing delimiter that follows it.
+    while (delimiter < bound) {
+      delimiter = find_delimiter(delimiter + 3);
+      if (delimiter == size) {
+        bound = size;
+        break;
+      }
+      bound = std::max(bound, next_line_start(delimiter + 3));
+      delimiter = find_delimiter(delimiter + 3);
+    }
+    if (bound >= size) {
+      break;
+    }
+    bounds.push_back(bound);
+  }
+  bounds.push_back(size);
+  int num_regions = bounds.size() - 1;
+  if (num_regions <= 1) {
+    return Lexer(value_stores, source, consumer).Lex();
+  }
+
+  llvm::SmallVector<std::unique_ptr<LexedRegion>> regions;
+  for ([[maybe_unused]] int i : llvm::seq(num_regions)) {
+    regions.push_back(std::make_unique<LexedRegion>(&value_stores.strings()));
+  }
+  auto lex_on_one_thread = [&]() -> TokenizedBuffer {
+    TokenizedBuffer buffer = Lexer(value_stores, source, consumer).Lex();
+    for (auto& region : regions) {
+      KeepRegionStrings(buffer, *region);
+    }
+    return buffer;
+  };
+  auto lex_region = [&](int i) {
+    RecordingDiagnosticConsumer consumer;
+    Lexer(regions[i]->value_stores, source, consumer)
+        .LexRegion(*regions[i], bounds[i], bounds[i + 1]);
+    regions[i]->has_diagnostics = consumer.seen_diagnostic();
+  };
+  {
+    // The calling thread lexes the first region.
+    llvm::ThreadPool pool(llvm::hardware_concurrency(num_regions - 1));
+    for (int i : llvm::seq(1, num_regions)) {
+      pool.async(lex_region, i);
+    }
+    lex_region(0);
+    pool.wait();
+  }
+  if (llvm::any_of(regions, [](const auto& region) {
+        return region->has_diagnostics;
+      })) {
+    return lex_on_one_thread();
+  }
+
+  // The index of the first token and line of each region once stitched. After
+  // the first, each region's placeholder `StartOfFile` token is dropped. Before
+  // the last, each region's empty line at its end is dropped, as it's the first
+  // line of the next region.
+  llvm::SmallVector<int> token_offsets;
+  llvm::SmallVector<int> line_offsets;
+  int num_tokens = 0;
+  int num_lines = 0;
+  for (int i : llvm::seq(num_regions)) {
+    const TokenizedBuffer& buffer = *regions[i]->buffer;
+    token_offsets.push_back(num_tokens - (i == 0 ? 0 : 1));
+    line_offsets.push_back(num_lines);
+    num_tokens += buffer.token_infos_.size() - (i == 0 ? 0 : 1);
+    num_lines += buffer.line_infos_.size() - (i + 1 == num_regions ? 0 : 1);
+  }
+  auto stitched_token = [&](int region_index, Token token) {
+    return Token(token_offsets[region_index] + token.index);
+  };
+
+  // Match closing symbols with opening symbols in earlier regions, tracking
+  // open groups by their region index and token within the region. This is
+  // done before changing anything so that we can still fall back to lexing on
+  // one thread when they don't match, which is diagnosed.
+  llvm::SmallVector<std::pair<int, Token>> open_groups;
+  llvm::SmallVector<std::pair<Token, Token>> stitched_groups;
+  for (int i : llvm::seq(num_regions)) {
+    LexedRegion& region = *regions[i];
+    for (Token closing_token : region.unmatched_closing_tokens) {
+      if (open_groups.empty()) {
+        return lex_on_one_thread();
+      }
+      auto [opening_region, opening_token] = open_groups.pop_back_val();
+      if (regions[opening_region]->buffer->GetKind(opening_token) !=
+          region.buffer->GetKind(closing_token).opening_symbol()) {
+        return lex_on_one_thread();
+      }
+      stitched_groups.push_back({stitched_token(opening_region, opening_token),
+                                 stitched_token(i, closing_token)});
+    }
+    for (Token opening_token : region.open_groups) {
+      open_groups.push_back({i, opening_token});
+    }
+  }
+  if (!open_groups.empty()) {
+    return lex_on_one_thread();
+  }
+
+  // Copy the lines and tokens into one buffer, adjusting their indices.
+  // Integers and reals are added to the shared value stores in token order, so
+  // they get the same IDs as when lexing on one thread.
+  TokenizedBuffer stitched(value_stores, source);
+  stitched.line_infos_.reserve(num_lines);
+  stitched.token_infos_.reserve(num_tokens);
+  for (int i : llvm::seq(num_regions)) {
+    LexedRegion& region = *regions[i];
+    TokenizedBuffer& buffer = *region.buffer;
+
+    llvm::ArrayRef<TokenizedBuffer::LineInfo> lines = buffer.line_infos_;
+    if (i + 1 != num_regions) {
+      CARBON_CHECK(lines.back().start == bounds[i + 1]);
+      lines = lines.drop_back();
+    }
+    stitched.line_infos_.append(lines.begin(), lines.end());
+
+    for (int token_index : llvm::seq<int>(i == 0 ? 0 : 1, buffer.size())) {
+      TokenizedBuffer::TokenInfo info = buffer.token_infos_[token_index];
+      info.token_line = Line(info.token_line.index + line_offsets[i]);
+      StitchTokenValue(value_stores, region, info);
+      if (info.kind.is_opening_symbol()) {
+        if (info.closing_token.is_valid()) {
+          info.closing_token = stitched_token(i, info.closing_token);
+        }
+      } else if (info.kind.is_closing_symbol()) {
+        if (info.opening_token.is_valid()) {
+          info.opening_token = stitched_token(i, info.opening_token);
+        }
+      }
+      stitched.AddToken(info);
+    }
+    KeepRegionStrings(stitched, region);
+  }
+  for (auto [opening_token, closing_token] : stitched_groups) {
+    stitched.GetTokenInfo(opening_token).closing_token = closing_token;
+    stitched.GetTokenInfo(closing_token).opening_token = opening_token;
+  }
+  return stitched;
+}
+
+auto Lexer::StitchTokenValue(SharedValueStores& value_stores,
+                             LexedRegion& region,
+                             TokenizedBuffer::TokenInfo& info) -> void {
+  SharedValueStores& region_values = region.value_stores;
+  if (info.kind == TokenKind::IntegerLiteral ||
+      info.kind.is_sized_type_literal()) {
+    info.integer_id = value_stores.integers().Add(
+        std::move(region_values.integers().Get(info.integer_id)));
+  } else if (info.kind == TokenKind::RealLiteral) {
+    info.real_id = value_stores.reals().Add(
+        std::move(region_values.reals().Get(info.real_id)));
+  }
+}
+
+auto Lexer::KeepRegionStrings(TokenizedBuffer& buffer, LexedRegion& region)
+    -> void {
+  if (region.buffer) {
+    buffer.region_allocators_.push_back(std::move(region.buffer->allocator_));
+  }
+}
+
+auto Lexer::Relex(SharedValueStores& value_stores, SourceBuffer& source,
+                  const TokenizedBuffer& old_tokens, SourceEdit edit,
+                  DiagnosticConsumer& consumer) -> RelexResult {
+  CARBON_CHECK(old_tokens.value_stores_ == &value_stores)
+      << "Relexing must use the value stores of the old tokens.";
+  const int64_t old_size = old_tokens.source_->text().size();
+  const int64_t size = source.text().size();
+  CARBON_CHECK(edit.offset >= 0 && edit.removed_length >= 0 &&
+               edit.inserted_length >= 0 &&
+               edit.offset + edit.removed_length <= old_size &&
+               old_size - edit.removed_length + edit.inserted_length == size)
+      << "Edit doesn't match the sources.";
+  LexedRegion region(&value_stores.strings());
+  auto lex_from_scratch = [&]() -> RelexResult {
+    TokenizedBuffer buffer = Lexer(value_stores, source, consumer).Lex();
+    KeepRegionStrings(buffer, region);
+    return {.tokens = std::move(buffer)};
+  };
+  if (old_tokens.has_errors_) {
+    return lex_from_scratch();
+  }
+  const int64_t byte_delta = edit.inserted_length - edit.removed_length;
+
+  // Find the lines touched by the edit, from `first_line` up to `end_line`.
+  // These are relexed from the start of the first line up to the start of the
+  // line after them in the new source, or its end. The old lines always end
+  // with an empty line at the end of the source.
+  llvm::ArrayRef<TokenizedBuffer::LineInfo> old_lines = old_tokens.line_infos_;
+  auto line_containing = [&](int64_t offset) -> int {
+    return llvm::partition_point(old_lines,
+                                 [&](const TokenizedBuffer::LineInfo& line) {
+                                   return line.start <= offset;
+                                 }) -
+           old_lines.begin() - 1;
+  };
+  int first_line = line_containing(edit.offset);
+  int end_line = line_containing(edit.offset + edit.removed_length) + 1;
+  bool reaches_end = end_line + 1 >= static_cast<int>(old_lines.size());
+  if (reaches_end) {
+    end_line = old_lines.size();
+    // The `EndOfFile` token is placed on the line before a trailing empty
+    // line, which requires lexing that line too.
+    first_line = std::max(std::min<int>(first_line, old_lines.size() - 2), 0);
+  }
+  ssize_t start = old_lines[first_line].start;
+  ssize_t end = reaches_end ? size : old_lines[end_line].start + byte_delta;
+
+  // The old tokens before and after the relexed lines.
+  llvm::ArrayRef<TokenizedBuffer::TokenInfo> old_infos =
+      old_tokens.token_infos_;
+  auto first_token_on_line = [&](int line) -> int {
+    return llvm::partition_point(old_infos,
+                                 [&](const TokenizedBuffer::TokenInfo& info) {
+                                   return info.token_line.index < line;
+                                 }) -
+           old_infos.begin();
+  };
+  int prefix_end = first_token_on_line(first_line);
+  int suffix_begin = reaches_end ? static_cast<int>(old_infos.size())
+                                 : first_token_on_line(end_line);
+
+  // Only block string literals span lines. If one spans the start of the
+  // relexed lines or the line after them, they can't be lexed in isolation.
+  auto token_spans_line = [&](int next_token, int line) -> bool {
+    if (next_token == 0) {
+      return false;
+    }
+    Token token(next_token - 1);
+    const auto& info = old_tokens.GetTokenInfo(token);
+    return info.kind == TokenKind::StringLiteral &&
+           old_lines[info.token_line.index].start + info.column +
+                   static_cast<int64_t>(old_tokens.GetTokenText(token).size()) >
+               old_lines[line].start;
+  };
+  if (token_spans_line(prefix_end, first_line) ||
+      (!reaches_end && token_spans_line(suffix_begin, end_line))) {
+    return lex_from_scratch();
+  }
+
+  RecordingDiagnosticConsumer region_consumer;
+  Lexer(region.value_stores, source, region_consumer)
+      .LexRegion(region, start, end);
+  if (region_consumer.seen_diagnostic()) {
+    return lex_from_scratch();
+  }
+  const TokenizedBuffer& region_buffer = *region.buffer;
+
+  // Copy the old lines and tokens around the region's, adjusting their
+  // positions. After the first line, the region's placeholder `StartOfFile`
+  // token is dropped. Before the end, the region's empty line at its end is
+  // dropped, as it's the first old line after it.
+  llvm::ArrayRef<TokenizedBuffer::LineInfo> region_lines =
+      region_buffer.line_infos_;
+  if (!reaches_end) {
+    CARBON_CHECK(region_lines.back().start == end);
+    region_lines = region_lines.drop_back();
+  }
+  int region_token_begin = start == 0 ? 0 : 1;
+  int line_delta = first_line + region_lines.size() - end_line;
+
+  TokenizedBuffer relexed(value_stores, source);
+  relexed.line_infos_.reserve(old_lines.size() + line_delta);
+  relexed.line_infos_.append(old_lines.begin(), old_lines.begin() + first_line);
+  relexed.line_infos_.append(region_lines.begin(), region_lines.end());
+  for (TokenizedBuffer::LineInfo line : old_lines.drop_front(end_line)) {
+    line.start += byte_delta;
+    relexed.line_infos_.push_back(line);
+  }
+
+  relexed.token_infos_.reserve(prefix_end +
+                               (region_buffer.size() - region_token_begin) +
+                               (old_infos.size() - suffix_begin));
+  for (const auto& info : old_infos.take_front(prefix_end)) {
+    relexed.AddToken(info);
+  }
+
+  // Opening and closing symbols are matched again only within the region.
+  // Those in the region that match a symbol outside of it must pair up with
+  // the same symbols as the old region's did, which holds when both regions
+  // leave the same kinds of symbols unmatched. Otherwise, lexing from scratch
+  // finds the new groups and diagnoses mismatches.
+  llvm::SmallVector<Token> open_groups;
+  llvm::SmallVector<Token> unmatched_closing;
+  for (int token_index :
+       llvm::seq<int>(region_token_begin, region_buffer.size())) {
+    TokenizedBuffer::TokenInfo info = region_buffer.token_infos_[token_index];
+    info.token_line = Line(info.token_line.index + first_line);
+    StitchTokenValue(value_stores, region, info);
+    Token token = relexed.AddToken(info);
+    if (info.kind.is_opening_symbol()) {
+      open_groups.push_back(token);
+    } else if (info.kind.is_closing_symbol()) {
+      if (open_groups.empty()) {
+        unmatched_closing.push_back(token);
+        continue;
+      }
+      Token opening_token = open_groups.pop_back_val();
+      auto& opening_info = relexed.GetTokenInfo(opening_token);
+      if (opening_info.kind != info.kind.opening_symbol()) {
+        return lex_from_scratch();
+      }
+      opening_info.closing_token = token;
+      relexed.GetTokenInfo(token).opening_token = opening_token;
+    }
+  }
+  const int token_delta = relexed.size() - suffix_begin;
+
+  // The old region's symbols that match ones outside of it, in order.
+  llvm::SmallVector<Token> old_unmatched_opening;
+  llvm::SmallVector<Token> old_unmatched_closing;
+  for (int token_index : llvm::seq(prefix_end, suffix_begin)) {
+    const auto& info = old_infos[token_index];
+    if (info.kind.is_opening_symbol() &&
+        info.closing_token.index >= suffix_begin) {
+      old_unmatched_opening.push_back(Token(token_index));
+    } else if (info.kind.is_closing_symbol() &&
+               info.opening_token.index < prefix_end) {
+      old_unmatched_closing.push_back(Token(token_index));
+    }
+  }
+  auto same_kinds = [&](llvm::ArrayRef<Token> new_tokens,
+                        llvm::ArrayRef<Token> old_group_tokens) {
+    return std::equal(new_tokens.begin(), new_tokens.end(),
+                      old_group_tokens.begin(), old_group_tokens.end(),
+                      [&](Token a, Token b) {
+                        return relexed.GetTokenInfo(a).kind ==
+                               old_tokens.GetTokenInfo(b).kind;
+                      });
+  };
+  if (!same_kinds(open_groups, old_unmatched_opening) ||
+      !same_kinds(unmatched_closing, old_unmatched_closing)) {
+    return lex_from_scratch();
+  }
+
+  // Move the suffix, along with the matches that refer into it.
+  for (TokenizedBuffer::TokenInfo info : old_infos.drop_front(suffix_begin)) {
+    info.token_line = Line(info.token_line.index + line_delta);
+    if (info.kind.is_opening_symbol()) {
+      info.closing_token = Token(info.closing_token.index + token_delta);
+    } else if (info.kind.is_closing_symbol()) {
+      if (info.opening_token.index >= suffix_begin) {
+        info.opening_token = Token(info.opening_token.index + token_delta);
+      } else if (info.opening_token.index < prefix_end) {
+        auto& opening_info = relexed.GetTokenInfo(info.opening_token);
+        opening_info.closing_token = Token(relexed.size());
+      }
+    }
+    relexed.AddToken(info);
+  }
+
+  // Pair the region's unmatched symbols with the old region's partners.
+  for (auto [token, old_token] :
+       llvm::zip(unmatched_closing, old_unmatched_closing)) {
+    Token opening_token = old_tokens.GetTokenInfo(old_token).opening_token;
+    relexed.GetTokenInfo(opening_token).closing_token = token;
+    relexed.GetTokenInfo(token).opening_token = opening_token;
+  }
+  for (auto [token, old_token] :
+       llvm::zip(open_groups, old_unmatched_opening)) {
+    Token closing_token(
+        old_tokens.GetTokenInfo(old_token).closing_token.index + token_delta);
+    relexed.GetTokenInfo(closing_token).opening_token = token;
+    relexed.GetTokenInfo(token).closing_token = closing_token;
+  }
+
+  KeepRegionStrings(relexed, region);
+
+  // When the first line is relexed, its `StartOfFile` token is unchanged.
+  return RelexResult{
+      .tokens = std::move(relexed),
+      .num_unchanged_prefix_tokens = std::max(prefix_end, 1),
+      .num_unchanged_suffix_tokens =
+          static_cast<int>(old_infos.size()) - suffix_begin};
+}
+
 auto Lex(SharedValueStores& value_stores, SourceBuffer& source,
-         DiagnosticConsumer& consumer) -> TokenizedBuffer {
+         DiagnosticConsumer& consumer, ParallelLexOptions parallel)
+    -> TokenizedBuffer {
+  if (parallel.max_threads > 1) {
+    return Lexer::LexInParallel(value_stores, source, consumer, parallel);
+  }
   return Lexer(value_stores, source, consumer).Lex();
 }
 
+auto Relex(SharedValueStores& value_stores, SourceBuffer& source,
+           const TokenizedBuffer& old_tokens, SourceEdit edit,
+           DiagnosticConsumer& consumer) -> RelexResult {
+  return Lexer::Relex(value_stores, source, old_tokens, edit, consumer);
+}
+
 }  // namespace Carbon::Lex
@@ -5,6 +5,8 @@
 #ifndef CARBON_TOOLCHAIN_LEX_LEX_H_
 #define CARBON_TOOLCHAIN_LEX_LEX_H_
 
+#include <cstdint>
+
 #include "toolchain/base/value_store.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/lex/tokenized_buffer.h"
@@ -12,12 +14,78 @@
 
 namespace Carbon::Lex {
 
+// Options for lexing a large buffer on multiple threads.
+struct ParallelLexOptions {
+  // The most threads to lex on, including the calling thread.
+  int max_threads = 1;
+
+  // The fewest bytes of source to lex on each thread. Smaller buffers are lexed
+  // on fewer threads.
+  int64_t min_bytes_per_thread = 256 * 1024;
+};
+
 // Lexes a buffer of source code into a tokenized buffer.
 //
+// A large buffer may be split into regions of lines, which are lexed
+// concurrently and then stitched together. Regions add strings directly to the
+// string store, so this requires it to be thread-safe. The result, including
+// diagnostics, is the same as lexing on a single thread, other than the IDs of
+// strings that weren't already in the store.
+//
 // The provided source buffer must outlive any returned `TokenizedBuffer`
 // which will refer into the source.
 auto Lex(SharedValueStores& value_stores, SourceBuffer& source,
-         DiagnosticConsumer& consumer) -> TokenizedBuffer;
+         DiagnosticConsumer& consumer, ParallelLexOptions parallel = {})
+    -> TokenizedBuffer;
+
+// A change to a source buffer's text: `removed_length` bytes at `offset` are
+// replaced with `inserted_length` bytes.
+struct SourceEdit {
+  int64_t offset;
+  int64_t removed_length;
+  int64_t inserted_length;
+};
+
+// The result of `Relex`.
+struct RelexResult {
+  TokenizedBuffer tokens;
+
+  // The numbers of tokens at the start and end of `tokens` which are unchanged
+  // from the old buffer, other than their line and index. These are zero when
+  // the source was lexed from scratch.
+  int num_unchanged_prefix_tokens = 0;
+  int num_unchanged_suffix_tokens = 0;
+};
+
+// Lexes `source` after an edit to the source of `old_tokens`. Only the lines
+// touched by the edit are lexed; the tokens of other lines are copied from
+// `old_tokens`. The result, including diagnostics, is the same as `Lex`, which
+// is used instead when `old_tokens` has errors, the edit produces errors, or
+// the lines it touches are within a block string literal.
+//
+// `value_stores` must be the stores `old_tokens` was lexed with. The copied
+// tokens keep their values, which may refer into the old source and buffer, so
+// both must outlive the returned buffer and any use of the values.
+auto Relex(SharedValueStores& value_stores, SourceBuffer& source,
+           const TokenizedBuffer& old_tokens, SourceEdit edit,
+           DiagnosticConsumer& consumer) -> RelexResult;
+
+// The widest vectors used by the lexer's scanners. `Baseline` is whatever the
+// lexer was compiled for, which may be scalar code. Wider vectors are only used
+// on x86-64, and are selected at runtime based on the host CPU.
+enum class VectorWidth : int8_t {
+  Baseline,
+  Bits256,
+  Bits512,
+};
+
+// Returns the widest vectors the host CPU supports that the lexer can use.
+auto GetHostVectorWidth() -> VectorWidth;
+
+// Limits the vectors used by later calls to `Lex` to at most `width`, and
+// returns the previous limit. This is intended for benchmarks and tests that
+// compare the scanners.
+auto SetMaxVectorWidth(VectorWidth width) -> VectorWidth;
 
 }  // namespace Carbon::Lex
 
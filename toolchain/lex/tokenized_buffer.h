@@ -344,6 +344,11 @@ class TokenizedBuffer : public Printable<TokenizedBuffer> {
   // Used to allocate computed string literals.
   llvm::BumpPtrAllocator allocator_;
 
+  // The allocators of regions lexed separately, whose computed string literals
+  // were added to the shared value stores, and may be used by this buffer's
+  // tokens or by other buffers.
+  llvm::SmallVector<llvm::BumpPtrAllocator, 0> region_allocators_;
+
   SharedValueStores* value_stores_;
   SourceBuffer* source_;
 
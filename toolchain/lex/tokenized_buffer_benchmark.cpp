@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "absl/random/random.h"
 #include "common/check.h"
@@ -428,6 +429,36 @@ void BM_ValidKeywords(benchmark::State& state) {
 }
 BENCHMARK(BM_ValidKeywords);
 
+// Benchmark identifiers that are near misses for keywords: each has a keyword's
+// length, but with its last character changed. These defeat any early exit on
+// the length or first character when recognizing keywords.
+void BM_KeywordLikeIdentifiers(benchmark::State& state) {
+  absl::BitGen gen;
+  llvm::SmallVector<std::string> near_misses;
+  for (TokenKind keyword : TokenKind::KeywordTokens) {
+    std::string spelling = keyword.fixed_spelling().str();
+    spelling.back() = spelling.back() == 'z' ? 'y' : 'z';
+    near_misses.push_back(std::move(spelling));
+  }
+  std::array<llvm::StringRef, NumTokens> tokens;
+  for (int i : llvm::seq(NumTokens)) {
+    tokens[i] = near_misses[i % near_misses.size()];
+  }
+  std::shuffle(tokens.begin(), tokens.end(), gen);
+  std::string source = llvm::join(tokens, " ");
+
+  LexerBenchHelper helper(source);
+  for (auto _ : state) {
+    TokenizedBuffer buffer = helper.Lex();
+    CARBON_CHECK(!buffer.has_errors());
+  }
+
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens_per_second"] = benchmark::Counter(
+      NumTokens, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_KeywordLikeIdentifiers);
+
 void BM_ValidKeywordsAsRawIdentifiers(benchmark::State& state) {
   absl::BitGen gen;
   std::array<llvm::StringRef, NumTokens> tokens;
@@ -511,6 +542,9 @@ BENCHMARK(BM_ValidIdentifiers<1, 64, /*Uniform=*/false>);
 BENCHMARK(BM_ValidIdentifiers<1, 1, /*Uniform=*/true>);
 BENCHMARK(BM_ValidIdentifiers<3, 5, /*Uniform=*/true>);
 BENCHMARK(BM_ValidIdentifiers<3, 16, /*Uniform=*/true>);
+// Identifiers no longer than the longest keyword, which all need to be checked
+// against the keywords.
+BENCHMARK(BM_ValidIdentifiers<2, 10, /*Uniform=*/true>);
 BENCHMARK(BM_ValidIdentifiers<12, 64, /*Uniform=*/true>);
 BENCHMARK(BM_ValidIdentifiers<16, 16, /*Uniform=*/true>);
 BENCHMARK(BM_ValidIdentifiers<24, 24, /*Uniform=*/true>);
@@ -722,6 +756,101 @@ BENCHMARK(BM_CommentLines)
         {0, 2, 8},
     });
 
+// Limits the lexer to the `VectorWidth` in the benchmark's first argument while
+// in scope, skipping the benchmark if the host CPU doesn't support it.
+class ScopedVectorWidth {
+ public:
+  explicit ScopedVectorWidth(benchmark::State& state)
+      : previous_width_(
+            SetMaxVectorWidth(static_cast<VectorWidth>(state.range(0)))) {
+    if (static_cast<VectorWidth>(state.range(0)) > GetHostVectorWidth()) {
+      state.SkipWithError("Unsupported by the host CPU");
+    }
+  }
+  ~ScopedVectorWidth() { SetMaxVectorWidth(previous_width_); }
+
+ private:
+  VectorWidth previous_width_;
+};
+
+// The vector widths to compare the lexer's scanners with.
+const std::vector<int64_t> VectorWidthArgs = {
+    static_cast<int64_t>(VectorWidth::Baseline),
+    static_cast<int64_t>(VectorWidth::Bits256),
+    static_cast<int64_t>(VectorWidth::Bits512)};
+
+// Benchmarks to compare the widths of vectors used by the scanners, on the
+// inputs where they matter: long identifiers, long runs of whitespace, and
+// blocks of deeply indented comments.
+void BM_VectorWidthIdentifiers(benchmark::State& state) {
+  ScopedVectorWidth width(state);
+  std::string source = RandomIdentifierSeq<24, 80, /*Uniform=*/true>();
+
+  LexerBenchHelper helper(source);
+  for (auto _ : state) {
+    TokenizedBuffer buffer = helper.Lex();
+    CARBON_CHECK(!buffer.has_errors()) << helper.DiagnoseErrors();
+  }
+
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens_per_second"] = benchmark::Counter(
+      NumTokens, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_VectorWidthIdentifiers)->ArgsProduct({VectorWidthArgs});
+
+void BM_VectorWidthWhitespace(benchmark::State& state) {
+  ScopedVectorWidth width(state);
+  std::string separator(state.range(1), ' ');
+  std::string source = RandomIdentifierSeq<3, 5, /*Uniform=*/true>(separator);
+
+  LexerBenchHelper helper(source);
+  for (auto _ : state) {
+    TokenizedBuffer buffer = helper.Lex();
+    CARBON_CHECK(!buffer.has_errors()) << helper.DiagnoseErrors();
+  }
+
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens_per_second"] = benchmark::Counter(
+      NumTokens, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_VectorWidthWhitespace)
+    ->ArgsProduct({VectorWidthArgs,
+                   // Runs of whitespace, starting where the scalar loop hands
+                   // off to the vector scanners.
+                   {16, 64, 256}});
+
+void BM_VectorWidthCommentLines(benchmark::State& state) {
+  ScopedVectorWidth width(state);
+  int comment_indent = state.range(1);
+  std::string separator;
+  llvm::raw_string_ostream os(separator);
+  os << "\n";
+  for (int i : llvm::seq(16)) {
+    static_cast<void>(i);
+    os << std::string(comment_indent, ' ') << "// "
+       << std::string(30, 'x') << "\n";
+  }
+  std::string source = RandomIdentifierSeq<3, 5, /*Uniform=*/true>(separator);
+
+  LexerBenchHelper helper(source);
+  for (auto _ : state) {
+    TokenizedBuffer buffer = helper.Lex();
+    CARBON_CHECK(!buffer.has_errors()) << helper.DiagnoseErrors();
+  }
+
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens_per_second"] = benchmark::Counter(
+      NumTokens, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["lines_per_second"] =
+      benchmark::Counter(llvm::StringRef(source).count('\n'),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_VectorWidthCommentLines)
+    ->ArgsProduct({VectorWidthArgs,
+                   // Comment indentations past what the baseline SIMD code
+                   // handles, including nesting deep enough to need 512 bits.
+                   {16, 24, 40}});
+
 // This is a speed-of-light benchmark that should reflect memory bandwidth
 // (ideally) of simply reading all the source code. For speed-of-light we use
 // `strcpy` -- this both examines ever byte of the input looking for a null to
@@ -15,6 +15,7 @@
 #include "toolchain/base/value_store.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/diagnostics/mocks.h"
+#include "toolchain/diagnostics/null_diagnostics.h"
 #include "toolchain/lex/lex.h"
 #include "toolchain/lex/tokenized_buffer_test_helpers.h"
 #include "toolchain/testing/yaml_test_helpers.h"
@@ -50,7 +51,9 @@ class LexerTest : public ::testing::Test {
     return Lex::Lex(value_stores_, GetSourceBuffer(text), consumer);
   }
 
-  SharedValueStores value_stores_;
+  // Thread-safe so that large buffers can be lexed in parallel.
+  ValueStore<StringId> strings_{/*thread_safe=*/true};
+  SharedValueStores value_stores_{&strings_};
   llvm::vfs::InMemoryFileSystem fs_;
   int file_index_ = 0;
   std::forward_list<SourceBuffer> source_storage_;
@@ -747,6 +750,200 @@ TEST_F(LexerTest, Identifiers) {
               }));
 }
 
+TEST_F(LexerTest, VectorWidths) {
+  // Long identifiers, deep indentation, and long runs of comment lines with
+  // deep indentation, which the wider vector scanners handle. These straddle
+  // the scanners' block sizes, and also need handling near the end of the
+  // buffer.
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  for (int length : {15, 16, 17, 31, 32, 33, 63, 64, 65, 100}) {
+    os << std::string(length, ' ') << std::string(length, 'a') << "\n";
+    for (int i = 0; i < 3; ++i) {
+      os << std::string(length, ' ') << "// " << std::string(length, 'x')
+         << "\n";
+    }
+    os << std::string(length, ' ') << "//" << std::string(length, '!')
+       << "\n";
+    os << "r#" << std::string(length, 'b') << "\t\t" << std::string(length, 'c')
+       << std::string(length, '\t') << ";\n";
+  }
+  os << "    // a\n    // b\n    //c";
+
+  auto print_tokens = [&]() -> std::string {
+    auto buffer = Lex(source, NullDiagnosticConsumer());
+    TestRawOstream print_stream;
+    buffer.Print(print_stream);
+    // Skip the filename, which differs for each buffer.
+    std::string printed = print_stream.TakeStr();
+    return printed.substr(printed.find("tokens:"));
+  };
+
+  auto original_width = SetMaxVectorWidth(VectorWidth::Baseline);
+  std::string baseline = print_tokens();
+  for (auto width : {VectorWidth::Bits256, VectorWidth::Bits512}) {
+    if (width > GetHostVectorWidth()) {
+      continue;
+    }
+    SetMaxVectorWidth(width);
+    EXPECT_EQ(print_tokens(), baseline) << static_cast<int>(width);
+  }
+  SetMaxVectorWidth(original_width);
+}
+
+TEST_F(LexerTest, ParallelLexing) {
+  // Groups and block strings spanning many lines, so that both cross the
+  // boundaries between regions.
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  for (int i = 0; i < 40; ++i) {
+    os << "fn F" << i << "(a: i32,\n    b: [i32; " << i << "]) {\n";
+    os << "  var s: String = '''\n    line " << i << "\n    }\n  ''';\n";
+    os << "  // comment " << i << "\n  return (a +\n    " << i << ".5);\n}\n";
+  }
+
+  // Computed string values live in the buffers but are interned in the shared
+  // value stores, so every buffer must outlive the test.
+  std::forward_list<TokenizedBuffer> buffers;
+  auto print_tokens = [&](ParallelLexOptions parallel) -> std::string {
+    auto& buffer = buffers.emplace_front(
+        Lex::Lex(value_stores_, GetSourceBuffer(source),
+                 ConsoleDiagnosticConsumer(), parallel));
+    EXPECT_FALSE(buffer.has_errors());
+    TestRawOstream print_stream;
+    buffer.Print(print_stream);
+    // Skip the filename, which differs for each buffer.
+    std::string printed = print_stream.TakeStr();
+    return printed.substr(printed.find("tokens:"));
+  };
+
+  std::string sequential = print_tokens({});
+  for (int threads : {2, 3, 8, 64}) {
+    EXPECT_EQ(print_tokens({.max_threads = threads, .min_bytes_per_thread = 1}),
+              sequential)
+        << threads;
+  }
+}
+
+TEST_F(LexerTest, ParallelLexingFallsBackOnDiagnostics) {
+  // An unknown escape sequence in a region after the first. The escape is
+  // diagnosed at line 92, column 12.
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  for (int i = 0; i < 40; ++i) {
+    os << "fn F" << i << "() {\n";
+    os << "  return \"" << (i == 30 ? "\\q" : "\\n") << i << "\";\n}\n";
+  }
+
+  // Diagnostics from the regions are discarded, and the whole source is lexed
+  // again on one thread, so each lex diagnoses the escape exactly once.
+  Testing::MockDiagnosticConsumer consumer;
+  EXPECT_CALL(consumer, HandleDiagnostic(IsDiagnostic(
+                            DiagnosticKind::UnknownEscapeSequence,
+                            DiagnosticLevel::Error, 92, 12, HasSubstr("`q`"))))
+      .Times(2);
+  std::forward_list<TokenizedBuffer> buffers;
+  auto print_tokens = [&](ParallelLexOptions parallel) -> std::string {
+    auto& buffer = buffers.emplace_front(
+        Lex::Lex(value_stores_, GetSourceBuffer(source), consumer, parallel));
+    EXPECT_TRUE(buffer.has_errors());
+    TestRawOstream print_stream;
+    buffer.Print(print_stream);
+    std::string printed = print_stream.TakeStr();
+    return printed.substr(printed.find("tokens:"));
+  };
+
+  // Lex in parallel first, so that the computed values of the string literals
+  // are first added to the shared value stores by the regions.
+  std::string parallel =
+      print_tokens({.max_threads = 4, .min_bytes_per_thread = 1});
+  EXPECT_EQ(print_tokens({}), parallel);
+}
+
+TEST_F(LexerTest, Relex) {
+  std::string source;
+  llvm::raw_string_ostream os(source);
+  for (int i = 0; i < 8; ++i) {
+    os << "fn F" << i << "(a: i32,\n    b: [i32; " << i << "]) {\n";
+    os << "  var s: String = \"x\\ty" << i << "\";\n";
+    if (i == 4) {
+      os << "  var t: String = '''\n    block\n  ''';\n";
+    }
+    os << "  return (a +\n    " << i << ".5);\n}\n";
+  }
+  os << "// end\n";
+
+  // Replaces the first occurrence of `before` with `after`.
+  struct Edit {
+    llvm::StringRef before;
+    llvm::StringRef after;
+    // Whether any tokens are reused, rather than lexing from scratch.
+    bool reuses_tokens = true;
+  };
+  Edit edits[] = {
+      {.before = "F3", .after = "Renamed"},
+      {.before = "  return (a +\n    2", .after = "  return (a +\n\n    2"},
+      {.before = "  var s: String = \"x\\ty5\";\n", .after = ""},
+      {.before = "fn F0", .after = "fn G() {}\nfn F0"},
+      {.before = "// end\n", .after = "// end\nfn G();"},
+      {.before = "// end\n", .after = "// end\n\n"},
+      {.before = "6]) {\n", .after = "6]) {\n  F5((\n    1));\n"},
+      {.before = "    6.5);", .after = "    6.5, a);"},
+      {.before = "    3.5);", .after = "    3.5) + (a);"},
+      {.before = "    3.5);\n}\nfn F4(", .after = "    3.5, (a));\n}\nfn F4("},
+      {.before = "(a: i32,\n    b: [i32; 1]", .after = "(\"\\n\" x 0x7F"},
+      {.before = "}\nfn F2", .after = "}\n\nfn F2"},
+      {.before = "    block", .after = "    changed", .reuses_tokens = false},
+      {.before = "    6.5);", .after = "    (6.5);", .reuses_tokens = false},
+      {.before = "x\\ty7\"", .after = "x\\ty7", .reuses_tokens = false},
+  };
+
+  auto print_tokens = [&](TokenizedBuffer& buffer) -> std::string {
+    TestRawOstream print_stream;
+    buffer.Print(print_stream);
+    // Skip the filename, which differs for each buffer.
+    std::string printed = print_stream.TakeStr();
+    return printed.substr(printed.find("tokens:"));
+  };
+
+  // Relexed tokens may refer into the old sources and buffers.
+  std::forward_list<std::string> texts;
+  std::forward_list<TokenizedBuffer> old_buffers;
+  for (const Edit& edit : edits) {
+    TokenizedBuffer& old_buffer = old_buffers.emplace_front(
+        Lex::Lex(value_stores_, GetSourceBuffer(source),
+                 ConsoleDiagnosticConsumer()));
+    ASSERT_FALSE(old_buffer.has_errors());
+
+    size_t offset = source.find(edit.before);
+    ASSERT_NE(offset, std::string::npos) << edit.before;
+    std::string& text = texts.emplace_front(source);
+    text.replace(offset, edit.before.size(), edit.after);
+    SourceBuffer& new_source = GetSourceBuffer(text);
+
+    auto relexed =
+        Relex(value_stores_, new_source, old_buffer,
+              {.offset = static_cast<int64_t>(offset),
+               .removed_length = static_cast<int64_t>(edit.before.size()),
+               .inserted_length = static_cast<int64_t>(edit.after.size())},
+              NullDiagnosticConsumer());
+    auto full = Lex::Lex(value_stores_, new_source, NullDiagnosticConsumer());
+    EXPECT_EQ(relexed.tokens.has_errors(), full.has_errors()) << edit.after;
+    EXPECT_EQ(print_tokens(relexed.tokens), print_tokens(full)) << edit.after;
+    if (!full.has_errors()) {
+      for (Token token : full.tokens()) {
+        if (full.GetKind(token).is_opening_symbol()) {
+          EXPECT_EQ(relexed.tokens.GetMatchedClosingToken(token),
+                    full.GetMatchedClosingToken(token))
+              << edit.after;
+        }
+      }
+    }
+    EXPECT_EQ(relexed.num_unchanged_prefix_tokens > 0, edit.reuses_tokens)
+        << edit.after;
+  }
+}
+
 TEST_F(LexerTest, StringLiterals) {
   llvm::StringLiteral testcase = R"(
     "hello world\n"
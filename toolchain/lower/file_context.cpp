@@ -17,17 +17,22 @@ namespace Carbon::Lower {
 
 FileContext::FileContext(llvm::LLVMContext& llvm_context,
                          llvm::StringRef module_name, const SemIR::File& sem_ir,
+                         llvm::StringRef target_cpu,
+                         llvm::StringRef target_features,
                          llvm::raw_ostream* vlog_stream)
     : llvm_context_(&llvm_context),
       llvm_module_(std::make_unique<llvm::Module>(module_name, llvm_context)),
       sem_ir_(&sem_ir),
+      target_cpu_(target_cpu),
+      target_features_(target_features),
       vlog_stream_(vlog_stream) {
   CARBON_CHECK(!sem_ir.has_errors())
       << "Generating LLVM IR from invalid SemIR::File is unsupported.";
 }
 
 // TODO: Move this to lower.cpp.
-auto FileContext::Run() -> std::unique_ptr<llvm::Module> {
+auto FileContext::Run(int32_t definitions_begin, int32_t definitions_end)
+    -> std::unique_ptr<llvm::Module> {
   CARBON_CHECK(llvm_module_) << "Run can only be called once.";
 
   // Lower all types that were required to be complete. Note that this may
@@ -47,7 +52,7 @@ auto FileContext::Run() -> std::unique_ptr<llvm::Module> {
   // TODO: Lower global variable declarations.
 
   // Lower function definitions.
-  for (auto i : llvm::seq(sem_ir_->functions().size())) {
+  for (auto i : llvm::seq(definitions_begin, definitions_end)) {
     BuildFunctionDefinition(SemIR::FunctionId(i));
   }
 
@@ -149,6 +154,12 @@ auto FileContext::BuildFunctionDecl(SemIR::FunctionId function_id)
   auto* llvm_function =
       llvm::Function::Create(function_type, llvm::Function::ExternalLinkage,
                              mangled_name, llvm_module());
+  if (!target_cpu_.empty()) {
+    llvm_function->addFnAttr("target-cpu", target_cpu_);
+  }
+  if (!target_features_.empty()) {
+    llvm_function->addFnAttr("target-features", target_features_);
+  }
 
   // Set up parameters and the return slot.
   for (auto [inst_id, arg] :
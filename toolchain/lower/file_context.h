@@ -18,11 +18,21 @@ class FileContext {
  public:
   explicit FileContext(llvm::LLVMContext& llvm_context,
                        llvm::StringRef module_name, const SemIR::File& sem_ir,
+                       llvm::StringRef target_cpu,
+                       llvm::StringRef target_features,
                        llvm::raw_ostream* vlog_stream);
 
   // Lowers the SemIR::File to LLVM IR. Should only be called once, and handles
   // the main execution loop.
-  auto Run() -> std::unique_ptr<llvm::Module>;
+  auto Run() -> std::unique_ptr<llvm::Module> {
+    return Run(0, sem_ir_->functions().size());
+  }
+
+  // Lowers the SemIR::File to LLVM IR, defining only the functions with IDs in
+  // [`definitions_begin`, `definitions_end`). Other functions are declared.
+  // This allows lowering different functions in different modules.
+  auto Run(int32_t definitions_begin, int32_t definitions_end)
+      -> std::unique_ptr<llvm::Module>;
 
   // Gets a callable's function.
   auto GetFunction(SemIR::FunctionId function_id) -> llvm::Function* {
@@ -82,6 +92,11 @@ class FileContext {
   // The input SemIR.
   const SemIR::File* const sem_ir_;
 
+  // The target CPU and features for function attributes, or empty to omit
+  // them.
+  llvm::StringRef target_cpu_;
+  llvm::StringRef target_features_;
+
   // The optional vlog stream.
   llvm::raw_ostream* vlog_stream_;
 
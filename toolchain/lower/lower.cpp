@@ -4,14 +4,114 @@
 
 #include "toolchain/lower/lower.h"
 
+#include <algorithm>
+#include <memory>
+
+#include "common/check.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
 #include "toolchain/lower/file_context.h"
 
 namespace Carbon::Lower {
 
+// Splits the functions into `num_shards` contiguous ranges with roughly equal
+// numbers of instructions in their bodies. Returns the bounds of the ranges,
+// including 0 and the number of functions.
+static auto GetShardBounds(const SemIR::File& sem_ir, int num_shards)
+    -> llvm::SmallVector<int32_t> {
+  llvm::SmallVector<int64_t> cumulative_sizes;
+  int64_t total_size = 0;
+  for (const auto& function : sem_ir.functions().array_ref()) {
+    // Count each function, so that declarations aren't free.
+    ++total_size;
+    for (auto block_id : function.body_block_ids) {
+      total_size += sem_ir.inst_blocks().Get(block_id).size();
+    }
+    cumulative_sizes.push_back(total_size);
+  }
+
+  llvm::SmallVector<int32_t> bounds = {0};
+  for (int shard : llvm::seq(1, num_shards)) {
+    int64_t target_size = total_size * shard / num_shards;
+    int32_t bound =
+        std::lower_bound(cumulative_sizes.begin(), cumulative_sizes.end(),
+                         target_size) -
+        cumulative_sizes.begin();
+    bounds.push_back(std::max(bound, bounds.back()));
+  }
+  bounds.push_back(cumulative_sizes.size());
+  return bounds;
+}
+
+// Lowers shards of function definitions on a thread pool. Each shard other than
+// the first is lowered in its own context and passed back as bitcode, because
+// modules can't be linked across contexts.
+static auto LowerInParallel(llvm::LLVMContext& llvm_context,
+                            llvm::StringRef module_name,
+                            const SemIR::File& sem_ir,
+                            llvm::StringRef target_cpu,
+                            llvm::StringRef target_features,
+                            llvm::raw_ostream* vlog_stream, int num_shards)
+    -> std::unique_ptr<llvm::Module> {
+  auto bounds = GetShardBounds(sem_ir, num_shards);
+  llvm::SmallVector<llvm::SmallVector<char, 0>> shard_bitcode(num_shards);
+  llvm::ThreadPool pool(llvm::hardware_concurrency(num_shards - 1));
+  for (int shard : llvm::seq(1, num_shards)) {
+    pool.async([&, shard] {
+      llvm::LLVMContext shard_context;
+      // Logging is only done for the first shard, to avoid interleaving.
+      FileContext context(shard_context, module_name, sem_ir, target_cpu,
+                          target_features, /*vlog_stream=*/nullptr);
+      auto module = context.Run(bounds[shard], bounds[shard + 1]);
+      llvm::raw_svector_ostream out(shard_bitcode[shard]);
+      llvm::WriteBitcodeToFile(*module, out);
+    });
+  }
+
+  FileContext context(llvm_context, module_name, sem_ir, target_cpu,
+                      target_features, vlog_stream);
+  auto module = context.Run(bounds[0], bounds[1]);
+  pool.wait();
+
+  llvm::Linker linker(*module);
+  for (int shard : llvm::seq(1, num_shards)) {
+    auto shard_module = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(
+            llvm::StringRef(shard_bitcode[shard].data(),
+                            shard_bitcode[shard].size()),
+            module_name),
+        llvm_context);
+    CARBON_CHECK(shard_module) << "Invalid bitcode for lowered shard: "
+                               << llvm::toString(shard_module.takeError());
+    // Note that this returns true on an error.
+    CARBON_CHECK(!linker.linkInModule(std::move(*shard_module)))
+        << "Unable to link lowered shard " << shard;
+  }
+  return module;
+}
+
 auto LowerToLLVM(llvm::LLVMContext& llvm_context, llvm::StringRef module_name,
-                 const SemIR::File& sem_ir, llvm::raw_ostream* vlog_stream)
+                 const SemIR::File& sem_ir, llvm::StringRef target_cpu,
+                 llvm::StringRef target_features,
+                 llvm::raw_ostream* vlog_stream, ParallelLowerOptions parallel)
     -> std::unique_ptr<llvm::Module> {
-  FileContext context(llvm_context, module_name, sem_ir, vlog_stream);
+  int num_shards = std::min<int64_t>(
+      parallel.max_threads,
+      sem_ir.functions().size() /
+          std::max(parallel.min_functions_per_thread, 1));
+  if (num_shards > 1) {
+    return LowerInParallel(llvm_context, module_name, sem_ir, target_cpu,
+                           target_features, vlog_stream, num_shards);
+  }
+
+  FileContext context(llvm_context, module_name, sem_ir, target_cpu,
+                      target_features, vlog_stream);
   return context.Run();
 }
 
@@ -11,9 +11,27 @@
 
 namespace Carbon::Lower {
 
-// Lowers SemIR to LLVM IR.
+// Options for lowering function definitions on multiple threads.
+struct ParallelLowerOptions {
+  // The maximum number of threads to use, including the calling thread.
+  int max_threads = 1;
+  // The minimum number of functions to give each thread, so that small files
+  // don't pay for merging modules.
+  int min_functions_per_thread = 64;
+};
+
+// Lowers SemIR to LLVM IR. When provided, the target CPU and features are
+// recorded on each function, so that optimization is specialized for them.
+//
+// When `parallel` allows more than one thread and there are enough functions,
+// function definitions are split into shards which are lowered concurrently,
+// each into a module in its own LLVM context. The shards are then linked into
+// one module in `llvm_context`.
 auto LowerToLLVM(llvm::LLVMContext& llvm_context, llvm::StringRef module_name,
-                 const SemIR::File& sem_ir, llvm::raw_ostream* vlog_stream)
+                 const SemIR::File& sem_ir, llvm::StringRef target_cpu,
+                 llvm::StringRef target_features,
+                 llvm::raw_ostream* vlog_stream,
+                 ParallelLowerOptions parallel = {})
     -> std::unique_ptr<llvm::Module>;
 
 }  // namespace Carbon::Lower
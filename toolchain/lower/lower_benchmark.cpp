@@ -0,0 +1,81 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <optional>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "toolchain/lower/lower.h"
+#include "toolchain/testing/benchmark_sources.h"
+#include "toolchain/testing/compile_helper.h"
+
+namespace Carbon::Lower {
+namespace {
+
+template <auto MakeSources>
+void BM_LowerToLLVM(benchmark::State& state) {
+  Testing::CompileHelper helper(MakeSources(state.range(0)));
+  helper.RunCheck();
+
+  int64_t num_insts = 0;
+  for (const auto& unit : helper.units()) {
+    num_insts += unit->sem_ir->insts().size();
+  }
+
+  std::optional<llvm::LLVMContext> llvm_context;
+  llvm::SmallVector<std::unique_ptr<llvm::Module>> modules;
+  int64_t num_llvm_insts = 0;
+  int64_t bytes_allocated = 0;
+  for (auto _ : state) {
+    // Discarding the previous iteration's modules isn't part of lowering.
+    state.PauseTiming();
+    modules.clear();
+    llvm_context.emplace();
+    state.ResumeTiming();
+
+    int64_t start_bytes = Testing::GetMallocBytes();
+    for (const auto& unit : helper.units()) {
+      modules.push_back(LowerToLLVM(*llvm_context, unit->source->filename(),
+                                    *unit->sem_ir, /*target_cpu=*/"",
+                                    /*target_features=*/"",
+                                    /*vlog_stream=*/nullptr));
+    }
+    bytes_allocated = Testing::GetMallocBytes() - start_bytes;
+  }
+  for (const auto& module : modules) {
+    num_llvm_insts += module->getInstructionCount();
+  }
+
+  state.counters["insts_per_second"] = benchmark::Counter(
+      num_insts, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["llvm_insts_per_second"] = benchmark::Counter(
+      num_llvm_insts, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes_allocated"] = bytes_allocated;
+}
+
+BENCHMARK(BM_LowerToLLVM<Testing::DeepExpressionSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_LowerToLLVM<Testing::ManyFunctionsSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_LowerToLLVM<Testing::WideStructSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_LowerToLLVM<Testing::WideTupleSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_LowerToLLVM<Testing::ManyClassesSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_LowerToLLVM<Testing::ImportChainSources>)
+    ->Arg(1 << 4)
+    ->Arg(1 << 8);
+
+}  // namespace
+}  // namespace Carbon::Lower
@@ -0,0 +1,51 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include "llvm/ADT/SmallVector.h"
+#include "toolchain/diagnostics/null_diagnostics.h"
+#include "toolchain/parse/tree.h"
+#include "toolchain/testing/benchmark_sources.h"
+#include "toolchain/testing/compile_helper.h"
+
+namespace Carbon::Parse {
+namespace {
+
+template <auto MakeSources>
+void BM_Parse(benchmark::State& state) {
+  Testing::CompileHelper helper(MakeSources(state.range(0)));
+  helper.RunLex();
+
+  int64_t num_nodes = 0;
+  int64_t bytes_allocated = 0;
+  for (auto _ : state) {
+    llvm::SmallVector<Tree> trees;
+    int64_t start_bytes = Testing::GetMallocBytes();
+    for (const auto& unit : helper.units()) {
+      trees.push_back(Tree::Parse(*unit->tokens, NullDiagnosticConsumer(),
+                                  /*vlog_stream=*/nullptr));
+    }
+    bytes_allocated = Testing::GetMallocBytes() - start_bytes;
+    num_nodes = 0;
+    for (const auto& tree : trees) {
+      num_nodes += tree.size();
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() * helper.source_bytes());
+  state.counters["nodes_per_second"] = benchmark::Counter(
+      num_nodes, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes_allocated"] = bytes_allocated;
+}
+
+BENCHMARK(BM_Parse<Testing::DeepExpressionSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Parse<Testing::ManyFunctionsSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Parse<Testing::WideStructSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Parse<Testing::WideTupleSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Parse<Testing::ManyClassesSources>)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_Parse<Testing::ImportChainSources>)->Arg(1 << 4)->Arg(1 << 8);
+
+}  // namespace
+}  // namespace Carbon::Parse
@@ -4,6 +4,8 @@
 
 #include "toolchain/parse/tree.h"
 
+#include <algorithm>
+
 #include "common/check.h"
 #include "common/error.h"
 #include "llvm/ADT/Sequence.h"
@@ -15,6 +17,40 @@
 
 namespace Carbon::Parse {
 
+namespace {
+// Holds the diagnostics from reparsing until it's known to succeed.
+class BufferingDiagnosticConsumer : public DiagnosticConsumer {
+ public:
+  auto HandleDiagnostic(Diagnostic diagnostic) -> void override {
+    diagnostics_.push_back(std::move(diagnostic));
+  }
+
+  // Passes the held diagnostics on to `consumer`.
+  auto ForwardTo(DiagnosticConsumer& consumer) -> void {
+    for (auto& diagnostic : diagnostics_) {
+      consumer.HandleDiagnostic(std::move(diagnostic));
+    }
+    diagnostics_.clear();
+  }
+
+ private:
+  llvm::SmallVector<Diagnostic, 0> diagnostics_;
+};
+}  // namespace
+
+// Runs the handler for the state at the top of the stack.
+static auto HandleState(Context& context) -> void {
+  // clang warns on unhandled enum values; clang-tidy is incorrect here.
+  // NOLINTNEXTLINE(bugprone-switch-missing-default-case)
+  switch (context.state_stack().back().state) {
+#define CARBON_PARSE_STATE(Name) \
+  case State::Name:              \
+    Handle##Name(context);       \
+    break;
+#include "toolchain/parse/state.def"
+  }
+}
+
 auto Tree::Parse(Lex::TokenizedBuffer& tokens, DiagnosticConsumer& consumer,
                  llvm::raw_ostream* vlog_stream) -> Tree {
   Lex::TokenLocationTranslator translator(&tokens);
@@ -32,15 +68,7 @@ auto Tree::Parse(Lex::TokenizedBuffer& tokens, DiagnosticConsumer& consumer,
   context.PushState(State::DeclScopeLoop);
 
   while (!context.state_stack().empty()) {
-    // clang warns on unhandled enum values; clang-tidy is incorrect here.
-    // NOLINTNEXTLINE(bugprone-switch-missing-default-case)
-    switch (context.state_stack().back().state) {
-#define CARBON_PARSE_STATE(Name) \
-  case State::Name:              \
-    Handle##Name(context);       \
-    break;
-#include "toolchain/parse/state.def"
-    }
+    HandleState(context);
   }
 
   context.AddLeafNode(NodeKind::FileEnd, *context.position());
@@ -54,6 +82,164 @@ auto Tree::Parse(Lex::TokenizedBuffer& tokens, DiagnosticConsumer& consumer,
   return tree;
 }
 
+auto Tree::Reparse(Lex::TokenizedBuffer& tokens, const Tree& old_tree,
+                   int num_unchanged_prefix_tokens,
+                   int num_unchanged_suffix_tokens,
+                   DiagnosticConsumer& consumer,
+                   llvm::raw_ostream* vlog_stream) -> Tree {
+  if (auto tree = ReparseChanges(tokens, old_tree, num_unchanged_prefix_tokens,
+                                 num_unchanged_suffix_tokens, consumer,
+                                 vlog_stream)) {
+    return std::move(*tree);
+  }
+  return Parse(tokens, consumer, vlog_stream);
+}
+
+auto Tree::ReparseChanges(Lex::TokenizedBuffer& tokens, const Tree& old_tree,
+                          int num_unchanged_prefix_tokens,
+                          int num_unchanged_suffix_tokens,
+                          DiagnosticConsumer& consumer,
+                          llvm::raw_ostream* vlog_stream)
+    -> std::optional<Tree> {
+  // Without errors, each top-level declaration covers a contiguous range of
+  // tokens, and is parsed the same regardless of the declarations around it.
+  if (old_tree.has_errors()) {
+    return std::nullopt;
+  }
+  int old_num_tokens = old_tree.tokens_->size();
+  int token_delta = tokens.size() - old_num_tokens;
+  int old_changes_begin = num_unchanged_prefix_tokens;
+  int old_changes_end = old_num_tokens - num_unchanged_suffix_tokens;
+
+  // Without errors, each top-level declaration's root is at its last token,
+  // and the next declaration starts right after it. So a root's tokens are
+  // found from its own token and the one of the root before it, without
+  // walking its subtree.
+  auto last_token = [&](Node root) { return old_tree.node_token(root).index; };
+
+  // Find the roots to reuse: a prefix ending before the first changed token,
+  // which must include `FileStart`, and a suffix starting after the last
+  // changed token. The tokens between them are parsed again, from
+  // `region_begin` up to `region_end` in the new tokens.
+  llvm::SmallVector<Node> roots(old_tree.roots());
+  std::reverse(roots.begin(), roots.end());
+  int num_prefix_roots = 0;
+  int region_begin = 0;
+  for (Node root : roots) {
+    int last = last_token(root);
+    if (last >= old_changes_begin) {
+      break;
+    }
+    ++num_prefix_roots;
+    region_begin = last + 1;
+  }
+  if (num_prefix_roots == 0) {
+    return std::nullopt;
+  }
+  int num_suffix_roots = 0;
+  // Without a suffix, `FileEnd` is added again at the `EndOfFile` token.
+  int region_end = tokens.size() - 1;
+  for (int i = roots.size() - 1; i >= num_prefix_roots; --i) {
+    int first = last_token(roots[i - 1]) + 1;
+    if (first < old_changes_end) {
+      break;
+    }
+    ++num_suffix_roots;
+    region_end = first + token_delta;
+  }
+  if (region_begin > region_end) {
+    return std::nullopt;
+  }
+
+  // Packaging directives are tracked in the tree and depend on the state of
+  // those before them, so changes to them are parsed from scratch.
+  for (Node root : llvm::ArrayRef<Node>(roots).slice(
+           num_prefix_roots,
+           roots.size() - num_prefix_roots - num_suffix_roots)) {
+    switch (old_tree.node_kind(root)) {
+      case NodeKind::PackageDirective:
+      case NodeKind::ImportDirective:
+      case NodeKind::LibraryDirective:
+        return std::nullopt;
+      default:
+        break;
+    }
+  }
+  for (int index : llvm::seq(region_begin, region_end)) {
+    switch (tokens.GetKind(Lex::Token(index))) {
+      case Lex::TokenKind::Package:
+      case Lex::TokenKind::Import:
+      case Lex::TokenKind::Library:
+        return std::nullopt;
+      default:
+        break;
+    }
+  }
+
+  Tree tree(tokens);
+  int old_prefix_end = roots[num_prefix_roots - 1].index + 1;
+  tree.node_impls_.append(old_tree.node_impls_.begin(),
+                          old_tree.node_impls_.begin() + old_prefix_end);
+
+  Lex::TokenLocationTranslator translator(&tokens);
+  BufferingDiagnosticConsumer buffered_consumer;
+  Lex::TokenDiagnosticEmitter emitter(translator, buffered_consumer);
+  Context context(tree, tokens, emitter, vlog_stream);
+  PrettyStackTraceFunction context_dumper(
+      [&](llvm::raw_ostream& output) { context.PrintForStackDump(output); });
+
+  // Between top-level declarations, only the file's `DeclScopeLoop` is on the
+  // stack. Stop there once the suffix is reached; if the declarations don't
+  // end exactly at its start, they don't line up with the old ones.
+  context.position() = Lex::TokenIterator(Lex::Token(region_begin));
+  context.PushState(State::DeclScopeLoop);
+  while (!context.state_stack().empty() &&
+         (context.state_stack().size() > 1 ||
+          (*context.position()).index < region_end)) {
+    HandleState(context);
+  }
+  if ((*context.position()).index != region_end) {
+    return std::nullopt;
+  }
+
+  int old_suffix_begin = old_tree.size();
+  if (num_suffix_roots > 0) {
+    Node first_suffix_root = roots[roots.size() - num_suffix_roots];
+    old_suffix_begin = first_suffix_root.index -
+                       old_tree.node_subtree_size(first_suffix_root) + 1;
+    for (NodeImpl node_impl : llvm::ArrayRef<NodeImpl>(old_tree.node_impls_)
+                                  .drop_front(old_suffix_begin)) {
+      node_impl.token = Lex::Token(node_impl.token.index + token_delta);
+      tree.node_impls_.push_back(node_impl);
+    }
+  } else {
+    context.AddLeafNode(NodeKind::FileEnd, *context.position());
+  }
+
+  int node_delta = tree.size() - old_tree.size();
+  auto map_node = [&](Node n) {
+    return n.index < old_suffix_begin ? n : Node(n.index + node_delta);
+  };
+  tree.packaging_directive_ = old_tree.packaging_directive_;
+  if (tree.packaging_directive_) {
+    tree.packaging_directive_->names.node =
+        map_node(tree.packaging_directive_->names.node);
+  }
+  tree.imports_ = old_tree.imports_;
+  for (auto& import : tree.imports_) {
+    import.node = map_node(import.node);
+  }
+
+  if (auto verify = tree.Verify(); !verify.ok()) {
+    if (vlog_stream) {
+      tree.Print(*vlog_stream);
+    }
+    CARBON_FATAL() << "Invalid tree returned by Reparse(): " << verify.error();
+  }
+  buffered_consumer.ForwardTo(consumer);
+  return tree;
+}
+
 auto Tree::postorder() const -> llvm::iterator_range<PostorderIterator> {
   return {PostorderIterator(Node(0)),
           PostorderIterator(Node(node_impls_.size()))};
@@ -87,6 +87,21 @@ class Tree : public Printable<Tree> {
   static auto Parse(Lex::TokenizedBuffer& tokens, DiagnosticConsumer& consumer,
                     llvm::raw_ostream* vlog_stream) -> Tree;
 
+  // Parses the token buffer into a `Tree` after an edit to the source of
+  // `old_tree`, where `tokens` begins and ends with the given numbers of tokens
+  // unchanged from the tokens of `old_tree`, as returned by `Lex::Relex`.
+  //
+  // Only the top-level declarations touching changed tokens are parsed again,
+  // and the nodes of the others are copied from `old_tree`. The result,
+  // including diagnostics, is the same as `Parse`, which is used instead when
+  // `old_tree` has errors or the changes touch packaging directives. The tokens
+  // of `old_tree` must still be valid.
+  static auto Reparse(Lex::TokenizedBuffer& tokens, const Tree& old_tree,
+                      int num_unchanged_prefix_tokens,
+                      int num_unchanged_suffix_tokens,
+                      DiagnosticConsumer& consumer,
+                      llvm::raw_ostream* vlog_stream) -> Tree;
+
   // Tests whether there are any errors in the parse tree.
   [[nodiscard]] auto has_errors() const -> bool { return has_errors_; }
 
@@ -246,6 +261,15 @@ class Tree : public Printable<Tree> {
     node_impls_.reserve(tokens_->expected_parse_tree_size());
   }
 
+  // Implements `Reparse`, returning `std::nullopt` if the tokens should be
+  // parsed from scratch instead.
+  static auto ReparseChanges(Lex::TokenizedBuffer& tokens, const Tree& old_tree,
+                             int num_unchanged_prefix_tokens,
+                             int num_unchanged_suffix_tokens,
+                             DiagnosticConsumer& consumer,
+                             llvm::raw_ostream* vlog_stream)
+      -> std::optional<Tree>;
+
   // Prints a single node for Print(). Returns true when preorder and there are
   // children.
   auto PrintNode(llvm::raw_ostream& output, Node n, int depth,
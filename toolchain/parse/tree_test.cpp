@@ -9,10 +9,13 @@
 
 #include <forward_list>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "testing/base/test_raw_ostream.h"
 #include "toolchain/base/value_store.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
 #include "toolchain/diagnostics/mocks.h"
+#include "toolchain/diagnostics/null_diagnostics.h"
 #include "toolchain/lex/lex.h"
 #include "toolchain/lex/tokenized_buffer.h"
 #include "toolchain/testing/yaml_test_helpers.h"
@@ -120,6 +123,95 @@ TEST_F(TreeTest, PrintPreorderAsYAML) {
               IsYaml(ElementsAre(root)));
 }
 
+TEST_F(TreeTest, Reparse) {
+  std::string source = "package P api;\n\nimport library \"L\";\n\n";
+  llvm::raw_string_ostream os(source);
+  for (int i = 0; i < 6; ++i) {
+    os << "fn F" << i << "(a: i32) -> i32 {\n  var b: i32 = a;\n";
+    os << "  return " << (i == 0 ? "b" : "F0(b)") << ";\n}\n\n";
+  }
+  os << "abstract class C {\n  fn G[self: Self]();\n  var x: i32;\n}\n";
+
+  // Replaces the first occurrence of `before` with `after`.
+  struct Edit {
+    llvm::StringRef before;
+    llvm::StringRef after;
+  };
+  Edit edits[] = {
+      {.before = "var b: i32 = a;", .after = "var b: i32 = a * 2;"},
+      {.before = "fn F3", .after = "fn Renamed"},
+      {.before = "fn F2(a: i32) -> i32 {\n  var b: i32 = a;\n"
+                 "  return F0(b);\n}",
+       .after = ""},
+      {.before = "  var x: i32;\n}\n", .after = "  var x: i32;\n}\nfn H();\n"},
+      {.before = "fn F4", .after = "fn F4_1();\nfn F4"},
+      {.before = "abstract class", .after = "base class"},
+      {.before = "}\n\nabstract", .after = "}\nfn F6();\nabstract"},
+      {.before = "var b: i32 = a;\n  return F0",
+       .after = "var b: i32 = ;\n  F0"},
+      {.before = "G[self: Self]();", .after = "G[self: Self]()"},
+      {.before = "-> i32 {\n  var b", .after = "-> i32 {\n  fn b"},
+      {.before = "library \"L\"", .after = "library \"M\""},
+      {.before = "package P api;\n", .after = ""},
+  };
+
+  std::forward_list<std::string> texts;
+  std::forward_list<Tree> old_trees;
+  for (auto [i, edit] : llvm::enumerate(edits)) {
+    Lex::TokenizedBuffer& old_tokens = GetTokenizedBuffer(source);
+    Tree& old_tree = old_trees.emplace_front(
+        Tree::Parse(old_tokens, consumer_, /*vlog_stream=*/nullptr));
+    ASSERT_FALSE(old_tree.has_errors());
+
+    size_t offset = source.find(edit.before);
+    ASSERT_NE(offset, std::string::npos) << edit.before;
+    std::string& text = texts.emplace_front(source);
+    text.replace(offset, edit.before.size(), edit.after);
+    // Use the same filename for both parses so that diagnostics match.
+    std::string filename = llvm::formatv("edit{0}.carbon", i);
+    CARBON_CHECK(fs_.addFile(filename, /*ModificationTime=*/0,
+                             llvm::MemoryBuffer::getMemBuffer(text)));
+    auto load_tokens = [&]() -> Lex::TokenizedBuffer& {
+      source_storage_.push_front(
+          std::move(*SourceBuffer::CreateFromFile(fs_, filename, consumer_)));
+      token_storage_.push_front(Lex::Lex(value_stores_, source_storage_.front(),
+                                         NullDiagnosticConsumer()));
+      return token_storage_.front();
+    };
+
+    Lex::TokenizedBuffer& full_tokens = load_tokens();
+    TestRawOstream full_diagnostics;
+    StreamDiagnosticConsumer full_consumer(full_diagnostics);
+    Tree full_tree =
+        Tree::Parse(full_tokens, full_consumer, /*vlog_stream=*/nullptr);
+
+    source_storage_.push_front(
+        std::move(*SourceBuffer::CreateFromFile(fs_, filename, consumer_)));
+    auto relexed = Lex::Relex(
+        value_stores_, source_storage_.front(), old_tokens,
+        {.offset = static_cast<int64_t>(offset),
+         .removed_length = static_cast<int64_t>(edit.before.size()),
+         .inserted_length = static_cast<int64_t>(edit.after.size())},
+        NullDiagnosticConsumer());
+    ASSERT_FALSE(relexed.tokens.has_errors());
+    TestRawOstream diagnostics;
+    StreamDiagnosticConsumer reparse_consumer(diagnostics);
+    Tree tree = Tree::Reparse(relexed.tokens, old_tree,
+                              relexed.num_unchanged_prefix_tokens,
+                              relexed.num_unchanged_suffix_tokens,
+                              reparse_consumer, /*vlog_stream=*/nullptr);
+
+    EXPECT_EQ(tree.has_errors(), full_tree.has_errors()) << edit.after;
+    EXPECT_EQ(diagnostics.TakeStr(), full_diagnostics.TakeStr()) << edit.after;
+    TestRawOstream print_stream;
+    tree.Print(print_stream);
+    TestRawOstream full_print_stream;
+    full_tree.Print(full_print_stream);
+    EXPECT_EQ(print_stream.TakeStr(), full_print_stream.TakeStr())
+        << edit.after;
+  }
+}
+
 TEST_F(TreeTest, HighRecursion) {
   std::string code = "fn Foo() { return ";
   code.append(10000, '(');
@@ -265,6 +265,11 @@ class File : public Printable<File> {
   auto StringifyTypeExpr(InstId outer_inst_id,
                          bool in_type_context = false) const -> std::string;
 
+  auto value_stores() -> SharedValueStores& { return *value_stores_; }
+  auto value_stores() const -> const SharedValueStores& {
+    return *value_stores_;
+  }
+
   // Directly expose SharedValueStores members.
   auto identifiers() -> StringStoreWrapper<IdentifierId>& {
     return value_stores_->identifiers();
@@ -5,8 +5,10 @@
 #include "toolchain/sem_ir/formatter.h"
 
 #include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "toolchain/base/value_store.h"
 #include "toolchain/lex/tokenized_buffer.h"
@@ -53,33 +55,15 @@ class InstNamer {
     GetScopeInfo(ScopeIndex::File).name = globals.AddNameUnchecked("file");
     CollectNamesInBlock(ScopeIndex::File, sem_ir.top_inst_block_id());
 
-    // Build each function scope.
+    // Name each function. The contents of a function's scope are only named
+    // while it's being formatted, by `CollectNamesInFunction`, so that names
+    // aren't live for the whole file at once.
     for (auto [i, fn] : llvm::enumerate(sem_ir.functions().array_ref())) {
-      auto fn_id = FunctionId(i);
-      auto fn_scope = GetScopeFor(fn_id);
       // TODO: Provide a location for the function for use as a
       // disambiguator.
       auto fn_loc = Parse::Node::Invalid;
-      GetScopeInfo(fn_scope).name = globals.AllocateName(
-          *this, fn_loc, sem_ir.names().GetIRBaseName(fn.name_id).str());
-      CollectNamesInBlock(fn_scope, fn.implicit_param_refs_id);
-      CollectNamesInBlock(fn_scope, fn.param_refs_id);
-      if (fn.return_slot_id.is_valid()) {
-        insts[fn.return_slot_id.index] = {
-            fn_scope,
-            GetScopeInfo(fn_scope).insts.AllocateName(
-                *this, sem_ir.insts().Get(fn.return_slot_id).parse_node(),
-                "return")};
-      }
-      if (!fn.body_block_ids.empty()) {
-        AddBlockLabel(fn_scope, fn.body_block_ids.front(), "entry", fn_loc);
-      }
-      for (auto block_id : fn.body_block_ids) {
-        CollectNamesInBlock(fn_scope, block_id);
-      }
-      for (auto block_id : fn.body_block_ids) {
-        AddBlockLabel(fn_scope, block_id);
-      }
+      GetScopeInfo(GetScopeFor(FunctionId(i))).name = globals.AllocateName(
+          *this, fn_loc, sem_ir.names().GetIRBaseName(fn.name_id));
     }
 
     // Build each class scope.
@@ -90,13 +74,55 @@ class InstNamer {
       // disambiguator.
       auto class_loc = Parse::Node::Invalid;
       GetScopeInfo(class_scope).name = globals.AllocateName(
-          *this, class_loc,
-          sem_ir.names().GetIRBaseName(class_info.name_id).str());
+          *this, class_loc, sem_ir.names().GetIRBaseName(class_info.name_id));
       AddBlockLabel(class_scope, class_info.body_block_id, "class", class_loc);
       CollectNamesInBlock(class_scope, class_info.body_block_id);
     }
   }
 
+  // Names the instructions and blocks in a function's scope. This must be
+  // called before the function's body is formatted.
+  auto CollectNamesInFunction(FunctionId fn_id) -> void {
+    const auto& fn = sem_ir_.functions().Get(fn_id);
+    auto fn_scope = GetScopeFor(fn_id);
+    // TODO: Provide a location for the function for use as a
+    // disambiguator.
+    auto fn_loc = Parse::Node::Invalid;
+    CollectNamesInBlock(fn_scope, fn.implicit_param_refs_id);
+    CollectNamesInBlock(fn_scope, fn.param_refs_id);
+    if (fn.return_slot_id.is_valid()) {
+      AddInstName(fn_scope, fn.return_slot_id,
+                  sem_ir_.insts().Get(fn.return_slot_id).parse_node(),
+                  "return");
+    }
+    if (!fn.body_block_ids.empty()) {
+      AddBlockLabel(fn_scope, fn.body_block_ids.front(), "entry", fn_loc);
+    }
+    for (auto block_id : fn.body_block_ids) {
+      CollectNamesInBlock(fn_scope, block_id);
+    }
+    for (auto block_id : fn.body_block_ids) {
+      AddBlockLabel(fn_scope, block_id);
+    }
+  }
+
+  // Discards the names in a function's scope once it has been formatted,
+  // releasing their storage. Instructions and blocks in the function are no
+  // longer named afterwards.
+  auto ClearNamesInFunction(FunctionId fn_id) -> void {
+    Scope& scope = GetScopeInfo(GetScopeFor(fn_id));
+    for (auto inst_id : scope.named_insts) {
+      insts[inst_id.index] = {};
+    }
+    for (auto block_id : scope.named_blocks) {
+      labels[block_id.index] = {};
+    }
+    scope.named_insts = {};
+    scope.named_blocks = {};
+    scope.insts = {.prefix = "%"};
+    scope.labels = {.prefix = "!"};
+  }
+
   // Returns the scope index corresponding to a function.
   auto GetScopeFor(FunctionId fn_id) -> ScopeIndex {
     return static_cast<ScopeIndex>(
@@ -126,50 +152,51 @@ class InstNamer {
     return GetScopeInfo(GetScopeFor(class_id)).name.str();
   }
 
-  // Returns the IR name to use for an instruction, when referenced from a given
+  // Prints the IR name to use for an instruction, when referenced from a given
   // scope.
-  auto GetNameFor(ScopeIndex scope_idx, InstId inst_id) -> std::string {
+  auto PrintNameFor(llvm::raw_ostream& out, ScopeIndex scope_idx,
+                    InstId inst_id) -> void {
     if (!inst_id.is_valid()) {
-      return "invalid";
+      out << "invalid";
+      return;
     }
 
     // Check for a builtin.
     if (inst_id.index < BuiltinKind::ValidCount) {
-      return BuiltinKind::FromInt(inst_id.index).label().str();
+      out << BuiltinKind::FromInt(inst_id.index).label();
+      return;
     }
 
     auto& [inst_scope, inst_name] = insts[inst_id.index];
     if (!inst_name) {
       // This should not happen in valid IR.
-      std::string str;
-      llvm::raw_string_ostream(str) << "<unexpected instref " << inst_id << ">";
-      return str;
+      out << "<unexpected instref " << inst_id << ">";
+      return;
     }
-    if (inst_scope == scope_idx) {
-      return inst_name.str().str();
+    if (inst_scope != scope_idx) {
+      out << GetScopeInfo(inst_scope).name.str() << ".";
     }
-    return (GetScopeInfo(inst_scope).name.str() + "." + inst_name.str()).str();
+    out << inst_name.str();
   }
 
-  // Returns the IR name to use for a label, when referenced from a given scope.
-  auto GetLabelFor(ScopeIndex scope_idx, InstBlockId block_id) -> std::string {
+  // Prints the IR name to use for a label, when referenced from a given scope.
+  auto PrintLabelFor(llvm::raw_ostream& out, ScopeIndex scope_idx,
+                     InstBlockId block_id) -> void {
     if (!block_id.is_valid()) {
-      return "!invalid";
+      out << "!invalid";
+      return;
     }
 
     auto& [label_scope, label_name] = labels[block_id.index];
     if (!label_name) {
       // This should not happen in valid IR.
-      std::string str;
-      llvm::raw_string_ostream(str)
-          << "<unexpected instblockref " << block_id << ">";
-      return str;
+      out << "<unexpected instblockref " << block_id << ">";
+      return;
     }
-    if (label_scope == scope_idx) {
-      return label_name.str().str();
+    if (label_scope != scope_idx) {
+      out << GetScopeInfo(label_scope).name.str() << ".";
     }
-    return (GetScopeInfo(label_scope).name.str() + "." + label_name.str())
-        .str();
+    out << label_name.str();
   }
 
  private:
@@ -210,7 +237,8 @@ class InstNamer {
     };
 
     llvm::StringRef prefix;
-    llvm::StringMap<NameResult> allocated = {};
+    // Names are interned in an arena that's freed with the namespace.
+    llvm::StringMap<NameResult, llvm::BumpPtrAllocator> allocated = {};
     int unnamed_count = 0;
 
     auto AddNameUnchecked(llvm::StringRef name) -> Name {
@@ -218,7 +246,7 @@ class InstNamer {
     }
 
     auto AllocateName(const InstNamer& namer, Parse::Node node,
-                      std::string name = "") -> Name {
+                      llvm::StringRef base_name = "") -> Name {
       // The best (shortest) name for this instruction so far, and the current
       // name for it.
       Name best;
@@ -248,7 +276,8 @@ class InstNamer {
       };
 
       // All names start with the prefix.
-      name.insert(0, prefix);
+      llvm::SmallString<64> name = prefix;
+      name += base_name;
 
       // Use the given name if it's available and not just the prefix.
       if (name.size() > prefix.size()) {
@@ -258,11 +287,11 @@ class InstNamer {
       // Append location information to try to disambiguate.
       if (node.is_valid()) {
         auto token = namer.parse_tree_.node_token(node);
-        llvm::raw_string_ostream(name)
+        llvm::raw_svector_ostream(name)
             << ".loc" << namer.tokenized_buffer_.GetLineNumber(token);
         add_name();
 
-        llvm::raw_string_ostream(name)
+        llvm::raw_svector_ostream(name)
             << "_" << namer.tokenized_buffer_.GetColumnNumber(token);
         add_name();
       }
@@ -272,7 +301,7 @@ class InstNamer {
       auto name_size_without_counter = name.size();
       for (int counter = 1;; ++counter) {
         name.resize(name_size_without_counter);
-        llvm::raw_string_ostream(name) << counter;
+        llvm::raw_svector_ostream(name) << counter;
         if (add_name(/*mark_ambiguous=*/false)) {
           return best;
         }
@@ -285,14 +314,25 @@ class InstNamer {
     Namespace::Name name;
     Namespace insts = {.prefix = "%"};
     Namespace labels = {.prefix = "!"};
+    // The instructions and blocks named in this scope.
+    llvm::SmallVector<InstId> named_insts = {};
+    llvm::SmallVector<InstBlockId> named_blocks = {};
   };
 
   auto GetScopeInfo(ScopeIndex scope_idx) -> Scope& {
     return scopes[static_cast<int>(scope_idx)];
   }
 
+  auto AddInstName(ScopeIndex scope_idx, InstId inst_id, Parse::Node node,
+                   llvm::StringRef name) -> void {
+    Scope& scope = GetScopeInfo(scope_idx);
+    insts[inst_id.index] = {scope_idx,
+                            scope.insts.AllocateName(*this, node, name)};
+    scope.named_insts.push_back(inst_id);
+  }
+
   auto AddBlockLabel(ScopeIndex scope_idx, InstBlockId block_id,
-                     std::string name = "",
+                     llvm::StringRef name = "",
                      Parse::Node parse_node = Parse::Node::Invalid) -> void {
     if (!block_id.is_valid() || labels[block_id.index].second) {
       return;
@@ -305,9 +345,10 @@ class InstNamer {
       }
     }
 
-    labels[block_id.index] = {scope_idx,
-                              GetScopeInfo(scope_idx).labels.AllocateName(
-                                  *this, parse_node, std::move(name))};
+    Scope& scope = GetScopeInfo(scope_idx);
+    labels[block_id.index] = {
+        scope_idx, scope.labels.AllocateName(*this, parse_node, name)};
+    scope.named_blocks.push_back(block_id);
   }
 
   // Finds and adds a suitable block label for the given SemIR instruction that
@@ -379,7 +420,7 @@ class InstNamer {
         break;
     }
 
-    AddBlockLabel(scope_idx, block_id, name.str(), inst.parse_node());
+    AddBlockLabel(scope_idx, block_id, name, inst.parse_node());
   }
 
   auto CollectNamesInBlock(ScopeIndex scope_idx, InstBlockId block_id) -> void {
@@ -390,8 +431,6 @@ class InstNamer {
 
   auto CollectNamesInBlock(ScopeIndex scope_idx, llvm::ArrayRef<InstId> block)
       -> void {
-    Scope& scope = GetScopeInfo(scope_idx);
-
     // Use bound names where available. Otherwise, assign a backup name.
     for (auto inst_id : block) {
       if (!inst_id.is_valid()) {
@@ -399,13 +438,13 @@ class InstNamer {
       }
 
       auto inst = sem_ir_.insts().Get(inst_id);
-      auto add_inst_name = [&](std::string name) {
-        insts[inst_id.index] = {scope_idx, scope.insts.AllocateName(
-                                               *this, inst.parse_node(), name)};
+      auto add_inst_name = [&](llvm::StringRef name) {
+        AddInstName(scope_idx, inst_id, inst.parse_node(), name);
       };
       auto add_inst_name_id = [&](NameId name_id, llvm::StringRef suffix = "") {
-        add_inst_name(
-            (sem_ir_.names().GetIRBaseName(name_id).str() + suffix).str());
+        llvm::SmallString<64> name = sem_ir_.names().GetIRBaseName(name_id);
+        name += suffix;
+        add_inst_name(name);
       };
 
       switch (inst.kind()) {
@@ -552,6 +591,7 @@ class Formatter {
     FormatFunctionName(id);
 
     llvm::SaveAndRestore function_scope(scope_, inst_namer_.GetScopeFor(id));
+    inst_namer_.CollectNamesInFunction(id);
 
     if (fn.implicit_param_refs_id != InstBlockId::Empty) {
       out_ << "[";
@@ -588,6 +628,8 @@ class Formatter {
     } else {
       out_ << ";\n";
     }
+
+    inst_namer_.ClearNamesInFunction(id);
   }
 
   auto FormatParamList(InstBlockId param_refs_id) -> void {
@@ -915,11 +957,11 @@ class Formatter {
   }
 
   auto FormatInstName(InstId id) -> void {
-    out_ << inst_namer_.GetNameFor(scope_, id);
+    inst_namer_.PrintNameFor(out_, scope_, id);
   }
 
   auto FormatLabel(InstBlockId id) -> void {
-    out_ << inst_namer_.GetLabelFor(scope_, id);
+    inst_namer_.PrintLabelFor(out_, scope_, id);
   }
 
   auto FormatFunctionName(FunctionId id) -> void {
@@ -0,0 +1,65 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+#include "toolchain/sem_ir/formatter.h"
+#include "toolchain/testing/benchmark_sources.h"
+#include "toolchain/testing/compile_helper.h"
+
+namespace Carbon::SemIR {
+namespace {
+
+template <auto MakeSources>
+void BM_FormatFile(benchmark::State& state) {
+  Testing::CompileHelper helper(MakeSources(state.range(0)));
+  helper.RunCheck();
+
+  int64_t num_insts = 0;
+  for (const auto& unit : helper.units()) {
+    num_insts += unit->sem_ir->insts().size();
+  }
+
+  int64_t output_bytes = 0;
+  int64_t bytes_allocated = 0;
+  for (auto _ : state) {
+    llvm::SmallString<0> output;
+    llvm::raw_svector_ostream out(output);
+    int64_t start_bytes = Testing::GetMallocBytes();
+    for (const auto& unit : helper.units()) {
+      FormatFile(*unit->tokens, *unit->parse_tree, *unit->sem_ir, out);
+    }
+    bytes_allocated = Testing::GetMallocBytes() - start_bytes;
+    output_bytes = output.size();
+  }
+
+  state.SetBytesProcessed(state.iterations() * output_bytes);
+  state.counters["insts_per_second"] = benchmark::Counter(
+      num_insts, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes_allocated"] = bytes_allocated;
+}
+
+BENCHMARK(BM_FormatFile<Testing::DeepExpressionSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_FormatFile<Testing::ManyFunctionsSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_FormatFile<Testing::WideStructSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_FormatFile<Testing::WideTupleSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_FormatFile<Testing::ManyClassesSources>)
+    ->Arg(1 << 8)
+    ->Arg(1 << 12);
+BENCHMARK(BM_FormatFile<Testing::ImportChainSources>)
+    ->Arg(1 << 4)
+    ->Arg(1 << 8);
+
+}  // namespace
+}  // namespace Carbon::SemIR
@@ -0,0 +1,126 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "common/check.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "toolchain/driver/driver.h"
+#include "toolchain/sem_ir/inst.h"
+#include "toolchain/sem_ir/typed_insts.h"
+#include "toolchain/sem_ir/value_stores.h"
+#include "toolchain/testing/benchmark_sources.h"
+
+namespace Carbon::SemIR {
+namespace {
+
+// Returns an instruction from a rotating mix of kinds and arities, roughly
+// resembling the instructions produced for function bodies.
+auto MakeInst(int i) -> Inst {
+  Parse::Node parse_node(i);
+  TypeId type_id(i % 64);
+  switch (i % 4) {
+    case 0:
+      return IntegerLiteral{parse_node, type_id, IntegerId(i)};
+    case 1:
+      return NameRef{parse_node, type_id, NameId(i % 1024), InstId(i - 1)};
+    case 2:
+      return Assign{parse_node, InstId(i - 2), InstId(i - 1)};
+    default:
+      return TupleAccess{parse_node, type_id, InstId(i - 3), MemberIndex(1)};
+  }
+}
+
+// Fills an `InstStore`, as check does. Reports the memory used per
+// instruction, which bounds how many instructions can be streamed per second.
+void BM_InstStoreAdd(benchmark::State& state) {
+  int num_insts = state.range(0);
+  for (auto _ : state) {
+    InstStore insts;
+    for (int i : llvm::seq(num_insts)) {
+      insts.AddInNoBlock(MakeInst(i));
+    }
+    benchmark::DoNotOptimize(insts.array_ref().data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * num_insts * sizeof(Inst));
+  state.counters["bytes_per_inst"] = sizeof(Inst);
+  state.counters["insts_per_second"] = benchmark::Counter(
+      num_insts, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_InstStoreAdd)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+// Walks an `InstStore`, dispatching on the kind and reading arguments, as
+// lower does. Large stores don't fit in cache, so this measures the bandwidth
+// of reading instructions.
+void BM_InstStoreScan(benchmark::State& state) {
+  int num_insts = state.range(0);
+  InstStore insts;
+  insts.Reserve(num_insts);
+  for (int i : llvm::seq(num_insts)) {
+    insts.AddInNoBlock(MakeInst(i));
+  }
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (Inst inst : insts.array_ref()) {
+      if (auto access = inst.TryAs<TupleAccess>()) {
+        sum += access->tuple_id.index;
+      } else if (auto assign = inst.TryAs<Assign>()) {
+        sum += assign->rhs_id.index;
+      } else {
+        sum += inst.type_id().index;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * num_insts * sizeof(Inst));
+  state.counters["insts_per_second"] = benchmark::Counter(
+      num_insts, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_InstStoreScan)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+// Runs the driver up to `phase` on a large generated file, to measure the
+// effect of the instruction representation on check and lower as a whole.
+void RunDriverOnLargeFile(benchmark::State& state, llvm::StringRef phase) {
+  int num_functions = state.range(0);
+  llvm::vfs::InMemoryFileSystem fs;
+  std::string source =
+      Testing::ManyFunctionsSources(num_functions).front().text;
+  CARBON_CHECK(fs.addFile("large.carbon", /*ModificationTime=*/0,
+                          llvm::MemoryBuffer::getMemBuffer(source)));
+  std::string phase_arg = llvm::formatv("--phase={0}", phase);
+
+  llvm::raw_null_ostream output;
+  llvm::raw_null_ostream errors;
+  for (auto _ : state) {
+    Driver driver(fs, output, errors);
+    bool success = driver.RunCommand({"compile", phase_arg, "large.carbon"});
+    CARBON_CHECK(success) << "Compiling the generated source failed.";
+  }
+
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["functions_per_second"] = benchmark::Counter(
+      num_functions, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_CheckLargeFile(benchmark::State& state) {
+  RunDriverOnLargeFile(state, "check");
+}
+BENCHMARK(BM_CheckLargeFile)->Arg(1 << 10)->Arg(1 << 14);
+
+void BM_LowerLargeFile(benchmark::State& state) {
+  RunDriverOnLargeFile(state, "lower");
+}
+BENCHMARK(BM_LowerLargeFile)->Arg(1 << 10)->Arg(1 << 14);
+
+}  // namespace
+}  // namespace Carbon::SemIR
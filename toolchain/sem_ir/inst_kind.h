@@ -48,7 +48,9 @@ class InstKind : public CARBON_ENUM_BASE(InstKind) {
 #define CARBON_SEM_IR_INST_KIND(Name) CARBON_ENUM_CONSTANT_DECL(Name)
 #include "toolchain/sem_ir/inst_kind.def"
 
+  using EnumBase::AsInt;
   using EnumBase::Create;
+  using EnumBase::FromInt;
 
   // Returns the name to use for this instruction kind in Semantics IR.
   [[nodiscard]] auto ir_name() const -> llvm::StringLiteral;
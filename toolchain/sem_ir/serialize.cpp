@@ -0,0 +1,896 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "toolchain/sem_ir/serialize.h"
+
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "common/check.h"
+#include "common/struct_reflection.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/MathExtras.h"
+#include "toolchain/base/value_store.h"
+#include "toolchain/sem_ir/builtin_kind.h"
+#include "toolchain/sem_ir/ids.h"
+#include "toolchain/sem_ir/inst.h"
+#include "toolchain/sem_ir/inst_kind.h"
+#include "toolchain/sem_ir/typed_insts.h"
+
+namespace Carbon::SemIR {
+
+// Identifies serialized SemIR. The version must be incremented whenever the
+// layout of the format or of any structure serialized as raw bytes changes.
+static constexpr char Magic[8] = {'C', 'R', 'B', 'N', 'S', 'E', 'M', 'I'};
+static constexpr uint32_t Version = 5;
+
+// Every section starts at a multiple of this, relative to the start of the
+// data, so that arrays can be viewed in place.
+static constexpr uint64_t SectionAlignment = 8;
+
+// Structures from the IR which are serialized as raw bytes.
+static_assert(sizeof(Inst) == 20, "Update `Version` for the new layout.");
+static_assert(sizeof(TypeInfo) == 12, "Update `Version` for the new layout.");
+static_assert(std::is_trivially_copyable_v<Inst>);
+static_assert(std::is_trivially_copyable_v<TypeInfo>);
+static_assert(std::is_trivially_copyable_v<Class>);
+
+// The number of instruction kinds, for checking deserialized kinds.
+static constexpr int NumInstKinds = 0
+#define CARBON_SEM_IR_INST_KIND(Name) +1
+#include "toolchain/sem_ir/inst_kind.def"
+    ;
+
+namespace {
+
+// The sections of serialized SemIR, in the order they're written. A block
+// store is written as two sections: a flat array of the values in all blocks,
+// and an array of offsets into it with one more entry than there are blocks.
+enum class Section : uint32_t {
+  Metadata,
+  Filename,
+  IntegerRecords,
+  IntegerWords,
+  RealRecords,
+  StringOffsets,
+  StringChars,
+  FunctionRecords,
+  FunctionBodyBlockIds,
+  Classes,
+  NameScopeOffsets,
+  NameScopeEntries,
+  Types,
+  CompleteTypes,
+  TypeBlockOffsets,
+  TypeBlockTypeIds,
+  Insts,
+  InstBlockOffsets,
+  InstBlockInstIds,
+  Constants,
+};
+constexpr int NumSections = static_cast<int>(Section::Constants) + 1;
+
+// The start of serialized SemIR.
+struct Header {
+  char magic[sizeof(Magic)];
+  uint32_t version;
+  uint32_t num_sections;
+  // The size of the serialized SemIR, including this header. This allows
+  // tools to split concatenated files.
+  uint64_t total_size;
+};
+
+// An entry in the section table, which immediately follows the header. There
+// is one entry per `Section`, in order.
+struct SectionEntry {
+  // The offset from the start of the header.
+  uint64_t offset;
+  // The size in bytes.
+  uint64_t size;
+};
+
+// The remaining serialized structures avoid implicit padding so that output
+// is deterministic.
+
+// Scalar information about the file.
+struct Metadata {
+  InstBlockId top_inst_block_id;
+  uint32_t num_cross_ref_irs;
+  uint32_t has_errors;
+};
+
+// An arbitrary-precision integer, whose words are in `IntegerWords`.
+struct IntegerRecord {
+  uint32_t bit_width;
+  uint32_t num_words;
+  uint64_t first_word;
+};
+
+struct RealRecord {
+  IntegerRecord mantissa;
+  IntegerRecord exponent;
+  uint64_t is_decimal;
+};
+
+// A function, whose body block IDs are in `FunctionBodyBlockIds`.
+struct FunctionRecord {
+  NameId name_id;
+  InstId decl_id;
+  InstId definition_id;
+  InstBlockId implicit_param_refs_id;
+  InstBlockId param_refs_id;
+  TypeId return_type_id;
+  InstId return_slot_id;
+  uint32_t first_body_block;
+  uint32_t num_body_blocks;
+};
+
+// A name scope entry. `std::pair` isn't trivially copyable, so this is used to
+// write entries as raw bytes.
+struct NameScopeEntry {
+  NameId name_id;
+  InstId inst_id;
+};
+
+// Flattens blocks of values into the representation used by block sections.
+template <typename T>
+class FlatBlocks {
+ public:
+  auto Add(llvm::ArrayRef<T> block) -> void {
+    values_.append(block.begin(), block.end());
+    offsets_.push_back(values_.size());
+  }
+
+  auto offsets() const -> llvm::ArrayRef<uint64_t> { return offsets_; }
+  auto values() const -> llvm::ArrayRef<T> { return values_; }
+
+ private:
+  llvm::SmallVector<uint64_t> offsets_ = {0};
+  llvm::SmallVector<T> values_;
+};
+
+// A view of a block section, as read from serialized SemIR.
+template <typename T>
+class BlocksView {
+ public:
+  BlocksView(llvm::ArrayRef<uint64_t> offsets, llvm::ArrayRef<T> values)
+      : offsets_(offsets), values_(values) {}
+
+  auto Get(int i) const -> llvm::ArrayRef<T> {
+    return values_.slice(offsets_[i], offsets_[i + 1] - offsets_[i]);
+  }
+
+  auto size() const -> int { return offsets_.size() - 1; }
+
+ private:
+  llvm::ArrayRef<uint64_t> offsets_;
+  llvm::ArrayRef<T> values_;
+};
+
+// Collects sections, then writes them with the header and section table.
+// Sections refer to their contents, which must outlive the call to `Write`.
+class Writer {
+ public:
+  template <typename T>
+  auto Set(Section section, llvm::ArrayRef<T> values) -> void {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= SectionAlignment);
+    sections_[static_cast<int>(section)] = llvm::StringRef(
+        reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+  }
+
+  template <typename T>
+  auto SetBlocks(Section offsets_section, Section values_section,
+                 const FlatBlocks<T>& blocks) -> void {
+    Set(offsets_section, blocks.offsets());
+    Set(values_section, blocks.values());
+  }
+
+  auto Write(llvm::raw_ostream& out) const -> void {
+    std::array<SectionEntry, NumSections> table;
+    uint64_t offset =
+        llvm::alignTo(sizeof(Header) + sizeof(table), SectionAlignment);
+    for (auto [entry, contents] : llvm::zip(table, sections_)) {
+      entry = {.offset = offset, .size = contents.size()};
+      offset = llvm::alignTo(offset + contents.size(), SectionAlignment);
+    }
+
+    Header header = {.magic = {},
+                     .version = Version,
+                     .num_sections = NumSections,
+                     .total_size = offset};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), sizeof(table));
+    uint64_t written = sizeof(header) + sizeof(table);
+    for (auto [entry, contents] : llvm::zip(table, sections_)) {
+      out.write_zeros(entry.offset - written);
+      out << contents;
+      written = entry.offset + entry.size;
+    }
+    out.write_zeros(offset - written);
+  }
+
+ private:
+  std::array<llvm::StringRef, NumSections> sections_;
+};
+
+// Provides in-place views of the sections in serialized SemIR.
+class Reader {
+ public:
+  // Validates the header and section table.
+  static auto Open(llvm::StringRef data) -> ErrorOr<Reader> {
+    if (reinterpret_cast<uintptr_t>(data.data()) % SectionAlignment != 0) {
+      return Error("Serialized SemIR is misaligned.");
+    }
+    if (data.size() < sizeof(Header)) {
+      return Error("Not serialized SemIR.");
+    }
+    const auto* header = reinterpret_cast<const Header*>(data.data());
+    if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0) {
+      return Error("Not serialized SemIR.");
+    }
+    if (header->version != Version) {
+      return Error(llvm::Twine("Unsupported serialized SemIR version ") +
+                   llvm::Twine(header->version) + ".");
+    }
+    if (header->num_sections != NumSections ||
+        header->total_size > data.size() ||
+        header->total_size <
+            sizeof(Header) + sizeof(SectionEntry) * NumSections) {
+      return Error("Malformed serialized SemIR header.");
+    }
+    data = data.take_front(header->total_size);
+
+    Reader reader;
+    const auto* table =
+        reinterpret_cast<const SectionEntry*>(data.data() + sizeof(Header));
+    for (auto i : llvm::seq(NumSections)) {
+      const auto& entry = table[i];
+      if (entry.offset % SectionAlignment != 0 || entry.offset > data.size() ||
+          entry.size > data.size() - entry.offset) {
+        return Error("Malformed serialized SemIR section table.");
+      }
+      reader.sections_[i] = data.substr(entry.offset, entry.size);
+    }
+    return reader;
+  }
+
+  // Returns a section as bytes.
+  auto GetBytes(Section section) const -> llvm::StringRef {
+    return sections_[static_cast<int>(section)];
+  }
+
+  // Returns a view of a section as an array, without copying.
+  template <typename T>
+  auto Get(Section section) const -> ErrorOr<llvm::ArrayRef<T>> {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= SectionAlignment);
+    llvm::StringRef bytes = GetBytes(section);
+    if (bytes.size() % sizeof(T) != 0) {
+      return Error("Malformed serialized SemIR section.");
+    }
+    return llvm::ArrayRef<T>(reinterpret_cast<const T*>(bytes.data()),
+                             bytes.size() / sizeof(T));
+  }
+
+  // Returns a section which must contain exactly one value.
+  template <typename T>
+  auto GetSingle(Section section) const -> ErrorOr<const T*> {
+    CARBON_ASSIGN_OR_RETURN(auto values, Get<T>(section));
+    if (values.size() != 1) {
+      return Error("Malformed serialized SemIR section.");
+    }
+    return &values.front();
+  }
+
+  // Returns a view of a block section, validating that each block is within
+  // the values.
+  template <typename T>
+  auto GetBlocks(Section offsets_section, Section values_section) const
+      -> ErrorOr<BlocksView<T>> {
+    CARBON_ASSIGN_OR_RETURN(auto offsets, Get<uint64_t>(offsets_section));
+    CARBON_ASSIGN_OR_RETURN(auto values, Get<T>(values_section));
+    if (offsets.empty() || offsets.front() != 0 ||
+        offsets.back() != values.size() || !llvm::is_sorted(offsets)) {
+      return Error("Malformed serialized SemIR blocks.");
+    }
+    return BlocksView<T>(offsets, values);
+  }
+
+ private:
+  Reader() = default;
+
+  std::array<llvm::StringRef, NumSections> sections_;
+};
+
+// Checks that the IDs in a deserialized file refer to values that exist, so
+// that a corrupt file is rejected instead of crashing a later phase. Parse
+// nodes aren't checked because the file doesn't have its parse tree.
+class IdValidator {
+ public:
+  explicit IdValidator(const File& sem_ir) : sem_ir_(&sem_ir) {}
+
+  auto IsValid(InstId id) const -> bool {
+    return id == InstId::Invalid || InRange(id, sem_ir_->insts().size());
+  }
+  auto IsValid(InstBlockId id) const -> bool {
+    return id == InstBlockId::Invalid || id == InstBlockId::Unreachable ||
+           InRange(id, sem_ir_->inst_blocks().size());
+  }
+  auto IsValid(TypeId id) const -> bool {
+    return id == TypeId::Invalid || id == TypeId::Error ||
+           id == TypeId::TypeType || InRange(id, sem_ir_->types().size());
+  }
+  auto IsValid(TypeBlockId id) const -> bool {
+    return id.index == TypeBlockId::InvalidIndex ||
+           InRange(id, sem_ir_->type_blocks().size());
+  }
+  auto IsValid(NameId id) const -> bool {
+    return id.index >= NameId::ReturnSlot.index &&
+           id.index < sem_ir_->value_stores().strings().size();
+  }
+  auto IsValid(NameScopeId id) const -> bool {
+    return id == NameScopeId::Invalid ||
+           InRange(id, sem_ir_->name_scopes().size());
+  }
+  auto IsValid(FunctionId id) const -> bool {
+    return id == FunctionId::Invalid ||
+           InRange(id, sem_ir_->functions().size());
+  }
+  auto IsValid(ClassId id) const -> bool {
+    return id == ClassId::Invalid || InRange(id, sem_ir_->classes().size());
+  }
+  auto IsValid(CrossRefIRId id) const -> bool {
+    return InRange(id, sem_ir_->cross_ref_irs().size());
+  }
+  auto IsValid(IntegerId id) const -> bool {
+    return id == IntegerId::Invalid ||
+           InRange(id, sem_ir_->value_stores().integers().size());
+  }
+  auto IsValid(RealId id) const -> bool {
+    return id == RealId::Invalid ||
+           InRange(id, sem_ir_->value_stores().reals().size());
+  }
+  auto IsValid(StringLiteralId id) const -> bool {
+    return id == StringLiteralId::Invalid ||
+           InRange(id, sem_ir_->value_stores().strings().size());
+  }
+  auto IsValid(BuiltinKind kind) const -> bool {
+    return kind.AsInt() < BuiltinKind::ValidCount;
+  }
+  auto IsValid(BoolValue value) const -> bool {
+    return value == BoolValue::False || value == BoolValue::True;
+  }
+  auto IsValid(MemberIndex index) const -> bool { return index.index >= 0; }
+
+  // Checks an instruction's kind, type, and arguments.
+  auto IsValid(Inst inst) const -> bool {
+    if (inst.kind().AsInt() >= NumInstKinds || !IsValid(inst.type_id())) {
+      return false;
+    }
+    // clang warns on unhandled enum values; clang-tidy is incorrect here.
+    // NOLINTNEXTLINE(bugprone-switch-missing-default-case)
+    switch (inst.kind()) {
+#define CARBON_SEM_IR_INST_KIND(Name) \
+  case Name::Kind:                    \
+    return AreArgsValid<Name>(inst);
+#include "toolchain/sem_ir/inst_kind.def"
+    }
+    CARBON_FATAL() << "Unhandled instruction kind " << inst.kind();
+  }
+
+  auto IsValid(const Function& function) const -> bool {
+    return IsValid(function.name_id) && IsValid(function.decl_id) &&
+           IsValid(function.definition_id) &&
+           IsValid(function.implicit_param_refs_id) &&
+           IsValid(function.param_refs_id) &&
+           IsValid(function.return_type_id) &&
+           IsValid(function.return_slot_id) &&
+           llvm::all_of(function.body_block_ids, [&](InstBlockId block_id) {
+             return IsValid(block_id);
+           });
+  }
+
+  auto IsValid(const Class& class_info) const -> bool {
+    return IsValid(class_info.name_id) && IsValid(class_info.self_type_id) &&
+           IsValid(class_info.decl_id) &&
+           class_info.inheritance_kind >= Class::Abstract &&
+           class_info.inheritance_kind <= Class::Final &&
+           IsValid(class_info.definition_id) && IsValid(class_info.scope_id) &&
+           IsValid(class_info.body_block_id) &&
+           IsValid(class_info.object_representation_id);
+  }
+
+  auto IsValid(const TypeInfo& type) const -> bool {
+    const auto& value_rep = type.value_representation;
+    return IsValid(type.inst_id) &&
+           value_rep.kind >= ValueRepresentation::Unknown &&
+           value_rep.kind <= ValueRepresentation::Custom &&
+           value_rep.aggregate_kind >= ValueRepresentation::NotAggregate &&
+           value_rep.aggregate_kind <=
+               ValueRepresentation::ValueAndObjectAggregate &&
+           IsValid(value_rep.type_id);
+  }
+
+ private:
+  static auto InRange(IndexBase id, int size) -> bool {
+    return id.index >= 0 && id.index < size;
+  }
+
+  template <typename TypedInst>
+  auto AreArgsValid(Inst inst) const -> bool {
+    using Info = TypedInstArgsInfo<TypedInst>;
+    auto typed_inst = inst.As<TypedInst>();
+    if constexpr (std::is_same_v<TypedInst, CrossRef>) {
+      // The instruction is in the cross-referenced IR, not this one.
+      return IsValid(typed_inst.ir_id) &&
+             InRange(typed_inst.inst_id,
+                     sem_ir_->cross_ref_irs().Get(typed_inst.ir_id)->insts().size());
+    } else {
+      if constexpr (Info::NumArgs > 0) {
+        if (!IsValid(Info::template Get<0>(typed_inst))) {
+          return false;
+        }
+      }
+      if constexpr (Info::NumArgs > 1) {
+        if (!IsValid(Info::template Get<1>(typed_inst))) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+
+  const File* sem_ir_;
+};
+
+// Maps a string ID between the file's string store, which may be shared with
+// other files, and the serialized strings, which are only the ones the file
+// refers to.
+using StringIdMap = llvm::function_ref<auto(StringId)->StringId>;
+
+// Maps a field of an instruction or entity if it refers to a string. Special
+// names aren't strings, so are unchanged.
+auto MapStrings(NameId& name_id, StringIdMap map) -> void {
+  if (name_id.index >= 0) {
+    name_id = NameId(map(StringId(name_id.index)).index);
+  }
+}
+auto MapStrings(StringLiteralId& string_literal_id, StringIdMap map) -> void {
+  if (string_literal_id.is_valid()) {
+    string_literal_id =
+        StringLiteralId(map(StringId(string_literal_id.index)).index);
+  }
+}
+template <typename FieldT>
+auto MapStrings(FieldT& /*field*/, StringIdMap /*map*/) -> void {}
+
+template <typename TypedInst>
+auto MapInstStrings(Inst inst, StringIdMap map) -> Inst {
+  auto fields = StructReflection::AsTuple(inst.As<TypedInst>());
+  std::apply([&](auto&... field) { (MapStrings(field, map), ...); }, fields);
+  return std::apply([](auto... field) { return Inst(TypedInst{field...}); },
+                    fields);
+}
+
+// Returns `inst` with the strings it refers to mapped. Its kind must be valid.
+auto MapStrings(Inst inst, StringIdMap map) -> Inst {
+  // clang warns on unhandled enum values; clang-tidy is incorrect here.
+  // NOLINTNEXTLINE(bugprone-switch-missing-default-case)
+  switch (inst.kind()) {
+#define CARBON_SEM_IR_INST_KIND(Name) \
+  case Name::Kind:                    \
+    return MapInstStrings<Name>(inst, map);
+#include "toolchain/sem_ir/inst_kind.def"
+  }
+  CARBON_FATAL() << "Unhandled instruction kind " << inst.kind();
+}
+
+}  // namespace
+
+// Appends an integer's words to `words`, returning its record.
+static auto AddInteger(const llvm::APInt& value,
+                       llvm::SmallVectorImpl<uint64_t>& words)
+    -> IntegerRecord {
+  IntegerRecord record = {.bit_width = value.getBitWidth(),
+                          .num_words = value.getNumWords(),
+                          .first_word = words.size()};
+  words.append(value.getRawData(), value.getRawData() + value.getNumWords());
+  return record;
+}
+
+// Returns the integer for a record.
+static auto GetInteger(IntegerRecord record, llvm::ArrayRef<uint64_t> words)
+    -> ErrorOr<llvm::APInt> {
+  if (record.bit_width == 0 ||
+      record.num_words != llvm::APInt::getNumWords(record.bit_width) ||
+      record.first_word > words.size() ||
+      record.num_words > words.size() - record.first_word) {
+    return Error("Malformed integer.");
+  }
+  return llvm::APInt(record.bit_width,
+                     words.slice(record.first_word, record.num_words));
+}
+
+auto SerializeFile(const File& sem_ir, llvm::raw_ostream& out) -> void {
+  Writer writer;
+
+  Metadata metadata = {
+      .top_inst_block_id = sem_ir.top_inst_block_id(),
+      .num_cross_ref_irs = static_cast<uint32_t>(sem_ir.cross_ref_irs().size()),
+      .has_errors = sem_ir.has_errors()};
+  writer.Set(Section::Metadata, llvm::ArrayRef<Metadata>(metadata));
+  writer.Set(Section::Filename, llvm::ArrayRef<char>(sem_ir.filename().data(),
+                                                     sem_ir.filename().size()));
+
+  // Integers and reals are written in full, because the reader needs to
+  // restore values that were added after lexing.
+  const auto& value_stores = sem_ir.value_stores();
+  llvm::SmallVector<uint64_t> integer_words;
+  llvm::SmallVector<IntegerRecord> integers;
+  for (const auto& integer : value_stores.integers().array_ref()) {
+    integers.push_back(AddInteger(integer, integer_words));
+  }
+  llvm::SmallVector<RealRecord> reals;
+  for (const auto& real : value_stores.reals().array_ref()) {
+    reals.push_back({.mantissa = AddInteger(real.mantissa, integer_words),
+                     .exponent = AddInteger(real.exponent, integer_words),
+                     .is_decimal = real.is_decimal});
+  }
+  writer.Set(Section::IntegerRecords, llvm::ArrayRef<IntegerRecord>(integers));
+  writer.Set(Section::IntegerWords, llvm::ArrayRef<uint64_t>(integer_words));
+  writer.Set(Section::RealRecords, llvm::ArrayRef<RealRecord>(reals));
+
+  // The string store may be shared with other files, so only the strings this
+  // file refers to are written, numbered in the order they're first seen.
+  llvm::DenseMap<StringId, StringId> serialized_string_ids;
+  FlatBlocks<char> strings;
+  auto map_string = [&](StringId id) -> StringId {
+    auto [it, inserted] = serialized_string_ids.insert(
+        {id, StringId(serialized_string_ids.size())});
+    if (inserted) {
+      llvm::StringRef str = value_stores.strings().Get(id);
+      strings.Add(llvm::ArrayRef<char>(str.data(), str.size()));
+    }
+    return it->second;
+  };
+
+  llvm::SmallVector<FunctionRecord> functions;
+  llvm::SmallVector<InstBlockId> body_block_ids;
+  for (const auto& function : sem_ir.functions().array_ref()) {
+    NameId name_id = function.name_id;
+    MapStrings(name_id, map_string);
+    functions.push_back(
+        {.name_id = name_id,
+         .decl_id = function.decl_id,
+         .definition_id = function.definition_id,
+         .implicit_param_refs_id = function.implicit_param_refs_id,
+         .param_refs_id = function.param_refs_id,
+         .return_type_id = function.return_type_id,
+         .return_slot_id = function.return_slot_id,
+         .first_body_block = static_cast<uint32_t>(body_block_ids.size()),
+         .num_body_blocks =
+             static_cast<uint32_t>(function.body_block_ids.size())});
+    body_block_ids.append(function.body_block_ids.begin(),
+                          function.body_block_ids.end());
+  }
+  writer.Set(Section::FunctionRecords,
+             llvm::ArrayRef<FunctionRecord>(functions));
+  writer.Set(Section::FunctionBodyBlockIds,
+             llvm::ArrayRef<InstBlockId>(body_block_ids));
+
+  llvm::SmallVector<Class> classes;
+  for (auto class_info : sem_ir.classes().array_ref()) {
+    MapStrings(class_info.name_id, map_string);
+    classes.push_back(class_info);
+  }
+  writer.Set(Section::Classes, llvm::ArrayRef<Class>(classes));
+
+  FlatBlocks<NameScopeEntry> name_scopes;
+  for (auto i : llvm::seq(sem_ir.name_scopes().size())) {
+    llvm::SmallVector<NameScopeEntry> entries;
+    for (const auto& entry : sem_ir.name_scopes().Get(NameScopeId(i))) {
+      NameId name_id = entry.first;
+      MapStrings(name_id, map_string);
+      entries.push_back({.name_id = name_id, .inst_id = entry.second});
+    }
+    name_scopes.Add(entries);
+  }
+  writer.SetBlocks(Section::NameScopeOffsets, Section::NameScopeEntries,
+                   name_scopes);
+
+  writer.Set(Section::Types, sem_ir.types().array_ref());
+  writer.Set(Section::CompleteTypes, sem_ir.complete_types());
+
+  FlatBlocks<TypeId> type_blocks;
+  for (auto i : llvm::seq(sem_ir.type_blocks().size())) {
+    type_blocks.Add(sem_ir.type_blocks().Get(TypeBlockId(i)));
+  }
+  writer.SetBlocks(Section::TypeBlockOffsets, Section::TypeBlockTypeIds,
+                   type_blocks);
+
+  llvm::SmallVector<Inst> insts;
+  insts.reserve(sem_ir.insts().size());
+  for (auto inst : sem_ir.insts().array_ref()) {
+    insts.push_back(MapStrings(inst, map_string));
+  }
+  writer.Set(Section::Insts, llvm::ArrayRef<Inst>(insts));
+
+  FlatBlocks<InstId> inst_blocks;
+  for (auto i : llvm::seq(sem_ir.inst_blocks().size())) {
+    inst_blocks.Add(sem_ir.inst_blocks().Get(InstBlockId(i)));
+  }
+  writer.SetBlocks(Section::InstBlockOffsets, Section::InstBlockInstIds,
+                   inst_blocks);
+
+  writer.Set(Section::Constants, sem_ir.constants().array_ref());
+
+  // Strings are set last, once every reference to them has been mapped.
+  writer.SetBlocks(Section::StringOffsets, Section::StringChars, strings);
+
+  writer.Write(out);
+}
+
+// Reads the shared values, adding the ones that aren't already present.
+// Returns the IDs of the serialized strings in the file's string store.
+static auto DeserializeValueStores(const Reader& reader,
+                                   SharedValueStores& value_stores)
+    -> ErrorOr<llvm::SmallVector<StringId>> {
+  CARBON_ASSIGN_OR_RETURN(auto words,
+                          reader.Get<uint64_t>(Section::IntegerWords));
+
+  CARBON_ASSIGN_OR_RETURN(auto integer_records,
+                          reader.Get<IntegerRecord>(Section::IntegerRecords));
+  auto& integers = value_stores.integers();
+  if (integer_records.size() < static_cast<size_t>(integers.size())) {
+    return Error("Serialized integers don't match the source.");
+  }
+  for (auto record : integer_records.drop_front(integers.size())) {
+    CARBON_ASSIGN_OR_RETURN(llvm::APInt integer, GetInteger(record, words));
+    integers.Add(std::move(integer));
+  }
+
+  CARBON_ASSIGN_OR_RETURN(auto real_records,
+                          reader.Get<RealRecord>(Section::RealRecords));
+  auto& reals = value_stores.reals();
+  if (real_records.size() < static_cast<size_t>(reals.size())) {
+    return Error("Serialized reals don't match the source.");
+  }
+  for (auto record : real_records.drop_front(reals.size())) {
+    CARBON_ASSIGN_OR_RETURN(llvm::APInt mantissa,
+                            GetInteger(record.mantissa, words));
+    CARBON_ASSIGN_OR_RETURN(llvm::APInt exponent,
+                            GetInteger(record.exponent, words));
+    reals.Add({.mantissa = std::move(mantissa),
+               .exponent = std::move(exponent),
+               .is_decimal = record.is_decimal != 0});
+  }
+
+  // Strings are interned, so ones that are already in the store keep their
+  // IDs. Added strings refer directly into the serialized data.
+  CARBON_ASSIGN_OR_RETURN(
+      auto serialized_strings,
+      reader.GetBlocks<char>(Section::StringOffsets, Section::StringChars));
+  llvm::SmallVector<StringId> string_ids;
+  string_ids.reserve(serialized_strings.size());
+  for (auto i : llvm::seq(serialized_strings.size())) {
+    auto chars = serialized_strings.Get(i);
+    string_ids.push_back(value_stores.strings().Add(
+        llvm::StringRef(chars.data(), chars.size())));
+  }
+  return string_ids;
+}
+
+auto GetSerializedFilename(llvm::StringRef data) -> ErrorOr<llvm::StringRef> {
+  CARBON_ASSIGN_OR_RETURN(Reader reader, Reader::Open(data));
+  return reader.GetBytes(Section::Filename);
+}
+
+auto DeserializeFile(llvm::StringRef data, File& sem_ir) -> ErrorOr<Success> {
+  CARBON_ASSIGN_OR_RETURN(Reader reader, Reader::Open(data));
+  if (reader.GetBytes(Section::Filename) != sem_ir.filename()) {
+    return Error("Serialized SemIR is for a different file.");
+  }
+
+  CARBON_ASSIGN_OR_RETURN(const auto* metadata,
+                          reader.GetSingle<Metadata>(Section::Metadata));
+  // Only the number of cross-referenced IRs is recorded. The reader requires
+  // that they're the same IRs the file was constructed with.
+  if (metadata->num_cross_ref_irs !=
+      static_cast<uint32_t>(sem_ir.cross_ref_irs().size())) {
+    return Error("Serialized SemIR references other IRs.");
+  }
+  sem_ir.set_has_errors(metadata->has_errors != 0);
+  sem_ir.set_top_inst_block_id(metadata->top_inst_block_id);
+
+  CARBON_ASSIGN_OR_RETURN(auto string_ids,
+                          DeserializeValueStores(reader, sem_ir.value_stores()));
+  // IDs that aren't serialized strings are left unchanged, and reported once
+  // loading is done, or before they're used as map keys.
+  bool has_malformed_strings = false;
+  auto map_string = [&](StringId id) -> StringId {
+    if (id.index < 0 || static_cast<size_t>(id.index) >= string_ids.size()) {
+      has_malformed_strings = true;
+      return id;
+    }
+    return string_ids[id.index];
+  };
+
+  CARBON_ASSIGN_OR_RETURN(
+      auto body_block_ids,
+      reader.Get<InstBlockId>(Section::FunctionBodyBlockIds));
+  CARBON_ASSIGN_OR_RETURN(auto functions,
+                          reader.Get<FunctionRecord>(Section::FunctionRecords));
+  sem_ir.functions().Reserve(functions.size());
+  for (const auto& record : functions) {
+    if (record.first_body_block > body_block_ids.size() ||
+        record.num_body_blocks >
+            body_block_ids.size() - record.first_body_block) {
+      return Error("Malformed function.");
+    }
+    auto body =
+        body_block_ids.slice(record.first_body_block, record.num_body_blocks);
+    NameId name_id = record.name_id;
+    MapStrings(name_id, map_string);
+    sem_ir.functions().Add(
+        {.name_id = name_id,
+         .decl_id = record.decl_id,
+         .definition_id = record.definition_id,
+         .implicit_param_refs_id = record.implicit_param_refs_id,
+         .param_refs_id = record.param_refs_id,
+         .return_type_id = record.return_type_id,
+         .return_slot_id = record.return_slot_id,
+         .body_block_ids = {body.begin(), body.end()}});
+  }
+
+  CARBON_ASSIGN_OR_RETURN(auto classes, reader.Get<Class>(Section::Classes));
+  sem_ir.classes().Reserve(classes.size());
+  for (auto class_info : classes) {
+    MapStrings(class_info.name_id, map_string);
+    sem_ir.classes().Add(class_info);
+  }
+
+  CARBON_ASSIGN_OR_RETURN(
+      auto name_scopes,
+      reader.GetBlocks<NameScopeEntry>(Section::NameScopeOffsets,
+                                       Section::NameScopeEntries));
+  // Names are checked before they're used as map keys.
+  IdValidator validator(sem_ir);
+  for (auto i : llvm::seq(name_scopes.size())) {
+    auto scope_id = sem_ir.name_scopes().Add();
+    for (auto entry : name_scopes.Get(i)) {
+      MapStrings(entry.name_id, map_string);
+      if (has_malformed_strings || !validator.IsValid(entry.name_id) ||
+          !sem_ir.name_scopes().AddEntry(scope_id, entry.name_id,
+                                         entry.inst_id)) {
+        return Error("Malformed name scope.");
+      }
+    }
+  }
+
+  // Types are added as incomplete, then completed in their original order so
+  // that `complete_types()` is restored.
+  CARBON_ASSIGN_OR_RETURN(auto types, reader.Get<TypeInfo>(Section::Types));
+  sem_ir.types().Reserve(types.size());
+  for (auto type : types) {
+    type.value_representation = ValueRepresentation();
+    sem_ir.types().Add(type);
+  }
+  CARBON_ASSIGN_OR_RETURN(auto complete_types,
+                          reader.Get<TypeId>(Section::CompleteTypes));
+  for (auto type_id : complete_types) {
+    if (type_id.index < 0 || type_id.index >= sem_ir.types().size() ||
+        sem_ir.IsTypeComplete(type_id) ||
+        types[type_id.index].value_representation.kind ==
+            ValueRepresentation::Unknown) {
+      return Error("Malformed complete type.");
+    }
+    sem_ir.CompleteType(type_id, types[type_id.index].value_representation);
+  }
+
+  CARBON_ASSIGN_OR_RETURN(
+      auto type_blocks, reader.GetBlocks<TypeId>(Section::TypeBlockOffsets,
+                                                 Section::TypeBlockTypeIds));
+  for (auto i : llvm::seq(type_blocks.size())) {
+    sem_ir.type_blocks().Add(type_blocks.Get(i));
+  }
+
+  // The file already has cross-references for builtins, which are serialized
+  // too.
+  CARBON_ASSIGN_OR_RETURN(auto insts, reader.Get<Inst>(Section::Insts));
+  if (insts.size() < static_cast<size_t>(sem_ir.insts().size())) {
+    return Error("Serialized SemIR is missing builtins.");
+  }
+  sem_ir.insts().Reserve(insts.size());
+  for (auto inst : insts.drop_front(sem_ir.insts().size())) {
+    if (inst.kind().AsInt() >= NumInstKinds) {
+      return Error("Malformed instruction.");
+    }
+    sem_ir.insts().AddInNoBlock(MapStrings(inst, map_string));
+  }
+
+  // Similarly, the file already has the empty block.
+  CARBON_ASSIGN_OR_RETURN(
+      auto inst_blocks, reader.GetBlocks<InstId>(Section::InstBlockOffsets,
+                                                 Section::InstBlockInstIds));
+  if (inst_blocks.size() < sem_ir.inst_blocks().size()) {
+    return Error("Serialized SemIR is missing the empty block.");
+  }
+  for (auto i : llvm::seq(sem_ir.inst_blocks().size(), inst_blocks.size())) {
+    sem_ir.inst_blocks().Add(inst_blocks.Get(i));
+  }
+
+  CARBON_ASSIGN_OR_RETURN(auto constants,
+                          reader.Get<InstId>(Section::Constants));
+  for (auto inst_id : constants) {
+    sem_ir.constants().Add(inst_id);
+  }
+
+  // Everything is loaded, so IDs can be checked against the final sizes.
+  if (has_malformed_strings) {
+    return Error("Malformed string reference.");
+  }
+  if (!validator.IsValid(metadata->top_inst_block_id)) {
+    return Error("Malformed top instruction block.");
+  }
+  for (const auto& function : sem_ir.functions().array_ref()) {
+    if (!validator.IsValid(function)) {
+      return Error("Malformed function.");
+    }
+  }
+  for (const auto& class_info : sem_ir.classes().array_ref()) {
+    if (!validator.IsValid(class_info)) {
+      return Error("Malformed class.");
+    }
+  }
+  for (auto i : llvm::seq(sem_ir.name_scopes().size())) {
+    for (auto [name_id, inst_id] : sem_ir.name_scopes().Get(NameScopeId(i))) {
+      if (!validator.IsValid(inst_id)) {
+        return Error("Malformed name scope.");
+      }
+    }
+  }
+  for (const auto& type : sem_ir.types().array_ref()) {
+    if (!validator.IsValid(type)) {
+      return Error("Malformed type.");
+    }
+  }
+  for (auto i : llvm::seq(sem_ir.type_blocks().size())) {
+    for (auto type_id : sem_ir.type_blocks().Get(TypeBlockId(i))) {
+      if (!validator.IsValid(type_id)) {
+        return Error("Malformed type block.");
+      }
+    }
+  }
+  for (auto inst : sem_ir.insts().array_ref()) {
+    if (!validator.IsValid(inst)) {
+      return Error("Malformed instruction.");
+    }
+  }
+  for (auto i : llvm::seq(sem_ir.inst_blocks().size())) {
+    for (auto inst_id : sem_ir.inst_blocks().Get(InstBlockId(i))) {
+      if (!validator.IsValid(inst_id)) {
+        return Error("Malformed instruction block.");
+      }
+    }
+  }
+  for (auto inst_id : sem_ir.constants().array_ref()) {
+    if (!validator.IsValid(inst_id)) {
+      return Error("Malformed constant.");
+    }
+  }
+  return Success();
+}
+
+}  // namespace Carbon::SemIR
@@ -0,0 +1,48 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_TOOLCHAIN_SEM_IR_SERIALIZE_H_
+#define CARBON_TOOLCHAIN_SEM_IR_SERIALIZE_H_
+
+#include "common/error.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "toolchain/sem_ir/file.h"
+
+namespace Carbon::SemIR {
+
+// Writes a binary form of `sem_ir`, including the shared values it uses, to
+// `out`.
+//
+// The format is a versioned header and section table followed by 8-byte
+// aligned sections, most of which are the raw contents of a store. Reading it
+// back bulk-copies those sections into the stores instead of parsing them, and
+// only strings are viewed in place. Strings are written compactly, so the
+// sections that refer to them are remapped when they're written and read. Values are in host byte order and layout,
+// so the format is only intended to be read back by the same toolchain version
+// on the same kind of host.
+auto SerializeFile(const File& sem_ir, llvm::raw_ostream& out) -> void;
+
+// Returns the filename recorded in the output of `SerializeFile`, which is
+// needed to construct the `File` to deserialize into. The result refers into
+// `data`.
+auto GetSerializedFilename(llvm::StringRef data) -> ErrorOr<llvm::StringRef>;
+
+// Reads the output of `SerializeFile` into `sem_ir`. `sem_ir` must be freshly
+// constructed with the builtins IR, and its integers and reals must be a prefix
+// of the ones that were serialized, for example because the same source was
+// lexed into them. Missing integers and reals are added. Only the strings the
+// file refers to are serialized; they're interned into the string store, which
+// may be shared with other files, and references to them are remapped.
+//
+// `data` must be 8-byte aligned, as buffers from `llvm::MemoryBuffer` are.
+// Strings added to the string store refer into `data`, so it must outlive the
+// store. Every ID read is checked against the loaded stores, so corrupt
+// data produces an error rather than a crash. On error, `sem_ir` may have been
+// partially populated and should be discarded.
+auto DeserializeFile(llvm::StringRef data, File& sem_ir) -> ErrorOr<Success>;
+
+}  // namespace Carbon::SemIR
+
+#endif  // CARBON_TOOLCHAIN_SEM_IR_SERIALIZE_H_
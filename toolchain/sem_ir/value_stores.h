@@ -120,6 +120,8 @@ class NameScopeStore {
     return values_.Get(scope_id);
   }
 
+  auto size() const -> int { return values_.size(); }
+
  private:
   ValueStore<NameScopeId, llvm::DenseMap<NameId, InstId>> values_;
 };
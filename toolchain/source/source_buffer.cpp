@@ -59,6 +59,15 @@ auto SourceBuffer::CreateFromFile(llvm::vfs::FileSystem& fs,
       filename, is_regular_file, consumer);
 }
 
+auto SourceBuffer::CreateFromText(llvm::StringRef text,
+                                  llvm::StringRef filename,
+                                  DiagnosticConsumer& consumer)
+    -> std::optional<SourceBuffer> {
+  return CreateFromMemoryBuffer(
+      llvm::MemoryBuffer::getMemBufferCopy(text, filename), filename,
+      /*is_regular_file=*/false, consumer);
+}
+
 auto SourceBuffer::CreateFromMemoryBuffer(
     llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer,
     llvm::StringRef filename, bool is_regular_file,
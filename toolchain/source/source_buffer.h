@@ -46,6 +46,13 @@ class SourceBuffer {
                              DiagnosticConsumer& consumer)
       -> std::optional<SourceBuffer>;
 
+  // Copies `text` into a new buffer, such as for text from an editor that
+  // hasn't been saved. Returns a SourceBuffer on success. Prints an error and
+  // returns nullopt on failure.
+  static auto CreateFromText(llvm::StringRef text, llvm::StringRef filename,
+                             DiagnosticConsumer& consumer)
+      -> std::optional<SourceBuffer>;
+
   // Use one of the factory functions above to create a source buffer.
   SourceBuffer() = delete;
 
@@ -6,6 +6,8 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include "common/check.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "toolchain/diagnostics/diagnostic_emitter.h"
@@ -35,6 +37,18 @@ TEST(SourceBufferTest, SimpleFile) {
   EXPECT_EQ("Hello World", buffer->text());
 }
 
+TEST(SourceBufferTest, FromText) {
+  std::string text = "Hello World";
+  auto buffer = SourceBuffer::CreateFromText(text, TestFileName,
+                                             ConsoleDiagnosticConsumer());
+  ASSERT_TRUE(buffer);
+  // The buffer owns a copy of the text.
+  text = "Goodbye";
+
+  EXPECT_EQ(TestFileName, buffer->filename());
+  EXPECT_EQ("Hello World", buffer->text());
+}
+
 TEST(SourceBufferTest, NoNull) {
   llvm::vfs::InMemoryFileSystem fs;
   static constexpr char NoNull[3] = {'a', 'b', 'c'};
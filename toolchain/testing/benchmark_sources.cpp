@@ -0,0 +1,130 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "toolchain/testing/benchmark_sources.h"
+
+#include "common/check.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace Carbon::Testing {
+
+auto DeepExpressionSources(int depth) -> SourceFiles {
+  CARBON_CHECK(depth >= 1) << depth;
+  std::string text;
+  llvm::raw_string_ostream out(text);
+  out << "fn F(p: bool) -> bool {\n  return ";
+  for (int i : llvm::seq(depth - 1)) {
+    out << (i % 2 == 0 ? "p and (" : "p or (");
+  }
+  out << "p";
+  for (int i : llvm::seq(depth - 1)) {
+    static_cast<void>(i);
+    out << ")";
+  }
+  out << ";\n}\n";
+  return {{.filename = "deep_expression.carbon", .text = std::move(text)}};
+}
+
+auto ManyFunctionsSources(int count) -> SourceFiles {
+  std::string text;
+  llvm::raw_string_ostream out(text);
+  for (int i : llvm::seq(count)) {
+    out << llvm::formatv(
+        "fn F{0}(a: i32, p: bool) -> i32 {{\n"
+        "  var b: (i32, i32) = (a, {0});\n"
+        "  var c: {{.x: i32, .y: i32} = {{.x = a, .y = b[1]};\n"
+        "  c.x = b[0];\n"
+        "  if (p) {{\n"
+        "    return c.y;\n"
+        "  }\n",
+        i);
+    if (i == 0) {
+      out << "  return c.x;\n}\n";
+    } else {
+      out << llvm::formatv("  return F{0}(c.x, p);\n}\n", i - 1);
+    }
+  }
+  return {{.filename = "many_functions.carbon", .text = std::move(text)}};
+}
+
+auto WideStructSources(int width) -> SourceFiles {
+  CARBON_CHECK(width >= 1) << width;
+  std::string text;
+  llvm::raw_string_ostream out(text);
+  out << "fn F() -> i32 {\n  var s: {";
+  for (int i : llvm::seq(width)) {
+    out << (i == 0 ? "" : ", ") << ".f" << i << ": i32";
+  }
+  out << "} = {";
+  for (int i : llvm::seq(width)) {
+    out << (i == 0 ? "" : ", ") << ".f" << i << " = " << i;
+  }
+  out << "};\n  return s.f" << width - 1 << ";\n}\n";
+  return {{.filename = "wide_struct.carbon", .text = std::move(text)}};
+}
+
+auto WideTupleSources(int width) -> SourceFiles {
+  // A one-element tuple would need a trailing comma.
+  CARBON_CHECK(width >= 2) << width;
+  std::string text;
+  llvm::raw_string_ostream out(text);
+  out << "fn F() -> i32 {\n  var t: (";
+  for (int i : llvm::seq(width)) {
+    out << (i == 0 ? "" : ", ") << "i32";
+  }
+  out << ") = (";
+  for (int i : llvm::seq(width)) {
+    out << (i == 0 ? "" : ", ") << i;
+  }
+  out << ");\n  return t[" << width - 1 << "];\n}\n";
+  return {{.filename = "wide_tuple.carbon", .text = std::move(text)}};
+}
+
+auto ManyClassesSources(int count) -> SourceFiles {
+  std::string text;
+  llvm::raw_string_ostream out(text);
+  for (int i : llvm::seq(count)) {
+    out << llvm::formatv(
+        "class C{0} {{\n"
+        "  var a: i32;\n"
+        "  var b: C{0}*;\n"
+        "\n"
+        "  fn Get[self: C{0}]() -> i32;\n"
+        "}\n"
+        "\n"
+        "fn C{0}.Get[self: C{0}]() -> i32 {{\n"
+        "  return self.a;\n"
+        "}\n"
+        "\n"
+        "fn Run{0}() -> i32 {{\n"
+        "  var c: C{0};\n"
+        "  c.a = {0};\n"
+        "  c.b = &c;\n"
+        "  return (*c.b).Get();\n"
+        "}\n"
+        "\n",
+        i);
+  }
+  return {{.filename = "many_classes.carbon", .text = std::move(text)}};
+}
+
+auto ImportChainSources(int length) -> SourceFiles {
+  SourceFiles files;
+  for (int i : llvm::seq(length)) {
+    std::string text;
+    llvm::raw_string_ostream out(text);
+    out << llvm::formatv("package Chain library \"L{0}\" api;\n\n", i);
+    if (i > 0) {
+      out << llvm::formatv("import library \"L{0}\";\n\n", i - 1);
+    }
+    out << llvm::formatv("fn F{0}() -> i32 {{\n  return {0};\n}\n", i);
+    files.push_back({.filename = llvm::formatv("chain{0}.carbon", i),
+                     .text = std::move(text)});
+  }
+  return files;
+}
+
+}  // namespace Carbon::Testing
@@ -0,0 +1,48 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_TOOLCHAIN_TESTING_BENCHMARK_SOURCES_H_
+#define CARBON_TOOLCHAIN_TESTING_BENCHMARK_SOURCES_H_
+
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+
+namespace Carbon::Testing {
+
+// A generated source file.
+struct SourceFile {
+  std::string filename;
+  std::string text;
+};
+
+using SourceFiles = llvm::SmallVector<SourceFile>;
+
+// Generators of synthetic sources for benchmarking the toolchain's phases.
+// Each takes a size and returns sources that compile without errors through
+// lowering, with work proportional to the size in the aspect it stresses.
+
+// A single function returning an expression of nested `and` and `or`
+// operators, `depth` levels deep.
+auto DeepExpressionSources(int depth) -> SourceFiles;
+
+// `count` functions with a mix of variables, aggregates, control flow, and a
+// call to the previous function.
+auto ManyFunctionsSources(int count) -> SourceFiles;
+
+// A struct type and literal with `width` fields.
+auto WideStructSources(int width) -> SourceFiles;
+
+// A tuple type and literal with `width` elements.
+auto WideTupleSources(int width) -> SourceFiles;
+
+// `count` classes, each with fields, a method, and a function using it.
+auto ManyClassesSources(int count) -> SourceFiles;
+
+// `length` library files in one package, each importing the one before it.
+auto ImportChainSources(int length) -> SourceFiles;
+
+}  // namespace Carbon::Testing
+
+#endif  // CARBON_TOOLCHAIN_TESTING_BENCHMARK_SOURCES_H_
@@ -0,0 +1,88 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "toolchain/testing/compile_helper.h"
+
+#include "common/check.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "toolchain/diagnostics/null_diagnostics.h"
+#include "toolchain/lex/lex.h"
+
+namespace Carbon::Testing {
+
+CompileHelper::CompileHelper(llvm::ArrayRef<SourceFile> files)
+    : builtins_(Check::MakeBuiltins(builtin_value_stores_)) {
+  for (const auto& file : files) {
+    CARBON_CHECK(fs_.addFile(file.filename, /*ModificationTime=*/0,
+                             llvm::MemoryBuffer::getMemBuffer(file.text)))
+        << "Duplicate file: " << file.filename;
+    auto& unit = units_.emplace_back(std::make_unique<Unit>());
+    unit->source = SourceBuffer::CreateFromFile(fs_, file.filename,
+                                                NullDiagnosticConsumer());
+    CARBON_CHECK(unit->source) << "Failed to load " << file.filename;
+    source_bytes_ += unit->source->text().size();
+  }
+}
+
+auto CompileHelper::RunLex() -> void {
+  // Results refer to the value stores, so discard them first.
+  for (auto& unit : units_) {
+    unit->sem_ir.reset();
+    unit->parse_tree.reset();
+    unit->tokens.reset();
+    unit->value_stores.reset();
+  }
+  strings_.emplace();
+  for (auto& unit : units_) {
+    unit->value_stores.emplace(&*strings_);
+    unit->tokens =
+        Lex::Lex(*unit->value_stores, *unit->source, NullDiagnosticConsumer());
+    CARBON_CHECK(!unit->tokens->has_errors())
+        << "Lex failed for " << unit->source->filename();
+  }
+}
+
+auto CompileHelper::RunParse() -> void {
+  RunLex();
+  for (auto& unit : units_) {
+    unit->parse_tree = Parse::Tree::Parse(*unit->tokens,
+                                          NullDiagnosticConsumer(),
+                                          /*vlog_stream=*/nullptr);
+    CARBON_CHECK(!unit->parse_tree->has_errors())
+        << "Parse failed for " << unit->source->filename();
+  }
+}
+
+auto CompileHelper::RunCheck() -> void {
+  RunParse();
+  auto check_units = GetCheckUnits();
+  Check::CheckParseTrees(builtins_, check_units, /*thread_pool=*/nullptr,
+                         /*cache=*/nullptr, /*time_trace=*/nullptr,
+                         /*vlog_stream=*/nullptr);
+  for (auto& unit : units_) {
+    CARBON_CHECK(!unit->sem_ir->has_errors())
+        << "Check failed for " << unit->source->filename();
+  }
+}
+
+auto CompileHelper::GetCheckUnits() -> llvm::SmallVector<Check::Unit> {
+  llvm::SmallVector<Check::Unit> check_units;
+  for (auto& unit : units_) {
+    CARBON_CHECK(unit->parse_tree) << "Parse hasn't run.";
+    unit->sem_ir.reset();
+    check_units.push_back({.value_stores = &*unit->value_stores,
+                           .tokens = &*unit->tokens,
+                           .parse_tree = &*unit->parse_tree,
+                           .consumer = &NullDiagnosticConsumer(),
+                           .sem_ir = &unit->sem_ir});
+  }
+  return check_units;
+}
+
+auto GetMallocBytes() -> int64_t {
+  return llvm::sys::Process::GetMallocUsage();
+}
+
+}  // namespace Carbon::Testing
@@ -0,0 +1,78 @@
+// Part of the Carbon Language project, under the Apache License v2.0 with LLVM
+// Exceptions. See /LICENSE for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef CARBON_TOOLCHAIN_TESTING_COMPILE_HELPER_H_
+#define CARBON_TOOLCHAIN_TESTING_COMPILE_HELPER_H_
+
+#include <memory>
+#include <optional>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "toolchain/base/value_store.h"
+#include "toolchain/check/check.h"
+#include "toolchain/lex/tokenized_buffer.h"
+#include "toolchain/parse/tree.h"
+#include "toolchain/sem_ir/file.h"
+#include "toolchain/source/source_buffer.h"
+#include "toolchain/testing/benchmark_sources.h"
+
+namespace Carbon::Testing {
+
+// Runs the phases of compiling a set of source files, so that a benchmark can
+// time one phase using the results of the phases before it. Each phase must
+// succeed without errors.
+class CompileHelper {
+ public:
+  // A file being compiled. Results are set as phases run.
+  struct Unit {
+    std::optional<SharedValueStores> value_stores;
+    std::optional<SourceBuffer> source;
+    std::optional<Lex::TokenizedBuffer> tokens;
+    std::optional<Parse::Tree> parse_tree;
+    std::optional<SemIR::File> sem_ir;
+  };
+
+  explicit CompileHelper(llvm::ArrayRef<SourceFile> files);
+
+  // Runs a phase on every unit, after the phases before it. Lexing starts
+  // from fresh value stores, discarding the results of any earlier run.
+  auto RunLex() -> void;
+  auto RunParse() -> void;
+  auto RunCheck() -> void;
+
+  // Returns the units to check, clearing any previous SemIR. Checking adds to
+  // the value stores, so to repeat it, run parse again first.
+  auto GetCheckUnits() -> llvm::SmallVector<Check::Unit>;
+
+  auto builtins() const -> const SemIR::File& { return builtins_; }
+  auto units() const -> llvm::ArrayRef<std::unique_ptr<Unit>> {
+    return units_;
+  }
+
+  // Returns the bytes of source in all units.
+  auto source_bytes() const -> int64_t { return source_bytes_; }
+
+ private:
+  llvm::vfs::InMemoryFileSystem fs_;
+
+  // Shared by all units, as in the driver. This is recreated when lexing,
+  // because computed string literal values are owned by the tokens.
+  std::optional<ValueStore<StringId>> strings_;
+
+  SharedValueStores builtin_value_stores_;
+  SemIR::File builtins_;
+
+  llvm::SmallVector<std::unique_ptr<Unit>> units_;
+  int64_t source_bytes_ = 0;
+};
+
+// Returns the bytes currently allocated by malloc, or 0 if that's unavailable.
+// The difference across a phase is the memory retained by its results.
+auto GetMallocBytes() -> int64_t;
+
+}  // namespace Carbon::Testing
+
+#endif  // CARBON_TOOLCHAIN_TESTING_COMPILE_HELPER_H_